@@ -59,8 +59,8 @@
 #include <deque>
 #include <sstream>
 #include <iostream>
-#include <boost/circular_buffer.hpp>
 #include <boost/bind.hpp>
+#include <cob_base_velocity_smoother/velocity_smoothing.h>
 
 // ros includes
 #include <ros/ros.h>
@@ -75,8 +75,11 @@
  * comming from ROS-navigation or teleoperation, by calculating the mean values of a certain number
  * of past messages and limiting the acceleration under a given threshold.
  * cob_base_velocity_smoother subsribes (input) and publishes (output) geometry_msgs::Twist.
+ * The smoothing itself is done by BufferMeanSmoother, this class connects it to ROS.
  ****************************************************************/
-class cob_base_velocity_smoother
+namespace cob_base_velocity_smoother {
+
+class BufferedVelocitySmoother
 {
 private:
   //capacity for circular buffers (to be loaded from parameter server, otherwise set to default value 12)
@@ -105,18 +108,16 @@ private:
 
 public:
   // constructor
-  cob_base_velocity_smoother();
+  BufferedVelocitySmoother();
 
   // destructor
-  ~cob_base_velocity_smoother();
+  ~BufferedVelocitySmoother();
 
   //create node handle
   ros::NodeHandle nh_, pnh_;
 
-  //circular buffers for velocity, output and time
-  boost::circular_buffer<geometry_msgs::Twist> cb_;
-  boost::circular_buffer<geometry_msgs::Twist> cb_out_;
-  boost::circular_buffer<ros::Time> cb_time_;
+  //smoothing of the commands
+  BufferMeanSmoother smoother_;
 
   // declaration of ros subscribers
   ros::Subscriber geometry_msgs_sub_;
@@ -128,34 +129,18 @@ public:
   void geometryCallback(const geometry_msgs::Twist::ConstPtr &cmd_vel);
   //calculation function called periodically in main
   void calculationStep();
-  //function that updates the circular buffer after receiving a new geometry message
-  void reviseCircBuff(ros::Time now, geometry_msgs::Twist cmd_vel);
-  //function to limit the acceleration under the given threshhold thresh
-  void limitAcceleration(ros::Time now, geometry_msgs::Twist& cmd_vel);
-
-  //boolean function that returns true if all messages stored in the circular buffer are older than store_delay, false otherwise
-  bool circBuffOutOfDate(ros::Time now);
-  // function to compare two geometry messages
-  bool IsEqual(geometry_msgs::Twist msg1, geometry_msgs::Twist msg2);
 
   //boolean function that returns true if the input msg cmd_vel equals zero_values, false otherwise
   bool IsZeroMsg(geometry_msgs::Twist cmd_vel);
 
-  //help-function that returns the signum of a double variable
-  int signum(double var);
-
-  //functions to calculate the mean values for each direction
-  double meanValueX();
-  double meanValueY();
-  double meanValueZ();
-
   // function to make the loop rate available outside the class
   double getLoopRate();
 
   //function for the actual computation
-  //calls the reviseCircBuff and the meanValue-functions and limits the acceleration under thresh
-  //returns the resulting geometry message to be published to the base_controller
+  //passes the command to the smoother and returns the resulting geometry message to be published to the base_controller
   geometry_msgs::Twist setOutput(ros::Time now, geometry_msgs::Twist cmd_vel);
 };
 
+} // cob_base_velocity_smoother
+
 #endif
@@ -0,0 +1,244 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_driver
+ * ROS package name: cob_base_velocity_smoother
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#ifndef JERK_LIMITED_PROFILE_H
+#define JERK_LIMITED_PROFILE_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace cob_base_velocity_smoother {
+
+/*****************************************************************************
+** ScurveAxis
+*****************************************************************************/
+
+/**
+ * Time optimal, jerk limited transition (S-curve) of a single velocity from its current value and
+ * acceleration to a target velocity with zero acceleration.
+ * The acceleration ramps to a peak value with constant jerk, stays there and ramps back to zero.
+ **/
+class ScurveAxis
+{
+public:
+  ScurveAxis()
+  : v0(0.0), v1(0.0), a0(0.0), dir(1.0), jerk(1.0), a_peak(0.0), t1(0.0), t2(0.0), t3(0.0), dv1(0.0), dv2(0.0)
+  {
+  }
+
+  /**
+   * Plans the fastest transition within the given acceleration and jerk limits (both > 0).
+   * @return double : duration of the transition
+   **/
+  double plan(double v_start, double a_start, double v_target, double accel_lim, double jerk_lim)
+  {
+    v0 = v_start;
+    v1 = v_target;
+    jerk = jerk_lim;
+
+    // velocity reached when ramping the current acceleration down to zero decides the direction
+    double v_stop = v_start + a_start*std::abs(a_start)/(2.0*jerk);
+    dir = (v_target >= v_stop) ? 1.0 : -1.0;
+    a0 = dir*a_start;
+    double dv = dir*(v_target - v_start);
+
+    a_peak = std::max(accel_lim, 0.0);
+    double t_const = (dv - rampGain(a_peak) - a_peak*a_peak/(2.0*jerk))/a_peak;
+    if (!(t_const >= 0.0))
+    {
+      // limit is not reached; the acceleration ramps up and immediately down again
+      a_peak = std::sqrt(std::max(jerk*dv + a0*a0/2.0, 0.0));
+      t_const = 0.0;
+    }
+    setPhases(t_const);
+    return duration();
+  }
+
+  /**
+   * Stretches the planned transition to a longer duration by lowering the peak acceleration,
+   * so that several axes reach their targets at the same time.
+   **/
+  void stretch(double t)
+  {
+    if (t <= duration())
+      return;
+
+    double dv = dir*(v1 - v0);
+    double b = jerk*t + a0;
+    double c = jerk*dv + a0*a0/2.0;
+    a_peak = (b - std::sqrt(std::max(b*b - 4.0*c, 0.0)))/2.0;
+    if (a_peak < a0)
+    {
+      // the current acceleration is above the one needed, so it ramps down to the peak value
+      a_peak = (dv - a0*a0/(2.0*jerk))/(t - a0/jerk);
+    }
+    setPhases(t - std::abs(a_peak - a0)/jerk - a_peak/jerk);
+  }
+
+  double duration() const
+  {
+    return t1 + t2 + t3;
+  }
+
+  /**
+   * Evaluates velocity and acceleration at time t after the start of the transition.
+   **/
+  void evaluate(double t, double& v, double& a) const
+  {
+    double dv, acc;
+    if (t <= 0.0)
+    {
+      dv = 0.0;
+      acc = a0;
+    }
+    else if (t < t1)
+    {
+      double j = (a_peak >= a0) ? jerk : -jerk;
+      dv = a0*t + j*t*t/2.0;
+      acc = a0 + j*t;
+    }
+    else if (t < t1 + t2)
+    {
+      t -= t1;
+      dv = dv1 + a_peak*t;
+      acc = a_peak;
+    }
+    else if (t < t1 + t2 + t3)
+    {
+      t -= t1 + t2;
+      dv = dv2 + a_peak*t - jerk*t*t/2.0;
+      acc = a_peak - jerk*t;
+    }
+    else
+    {
+      v = v1;
+      a = 0.0;
+      return;
+    }
+    v = v0 + dir*dv;
+    a = dir*acc;
+  }
+
+private:
+  double v0, v1, a0;     /**< Start and target velocity, start acceleration (in direction dir) */
+  double dir;            /**< Direction of the velocity change */
+  double jerk;           /**< Jerk limit */
+  double a_peak;         /**< Peak acceleration (in direction dir) */
+  double t1, t2, t3;     /**< Durations of the jerk up, constant acceleration and jerk down phases */
+  double dv1, dv2;       /**< Velocity change at the end of the first and second phase */
+
+  // velocity change while ramping the acceleration from a0 to a
+  double rampGain(double a) const
+  {
+    return (a0 + a)*std::abs(a - a0)/(2.0*jerk);
+  }
+
+  void setPhases(double t_const)
+  {
+    t1 = std::abs(a_peak - a0)/jerk;
+    t2 = std::max(t_const, 0.0);
+    t3 = a_peak/jerk;
+    dv1 = rampGain(a_peak);
+    dv2 = dv1 + a_peak*t2;
+  }
+};
+
+/*****************************************************************************
+** JerkLimitedProfile
+*****************************************************************************/
+
+/**
+ * Synchronized S-curve profile for the planar velocities (vx, vy, w): all axes reach their target
+ * at the same time, the faster ones with a reduced peak acceleration.
+ * Planning is done once per target change, evaluation is O(1) and doesn't allocate.
+ **/
+class JerkLimitedProfile
+{
+public:
+  enum
+  {
+    NUM_AXES = 3
+  };
+
+  JerkLimitedProfile()
+  : duration_(0.0)
+  {
+  }
+
+  /**
+   * Plans the transition from velocities v and accelerations a to the target velocities.
+   * @return double : duration of the transition
+   **/
+  double plan(const double v[NUM_AXES], const double a[NUM_AXES], const double target[NUM_AXES],
+              const double accel_lim[NUM_AXES], const double jerk_lim[NUM_AXES])
+  {
+    duration_ = 0.0;
+    for (int i = 0; i < NUM_AXES; i++)
+      duration_ = std::max(duration_, axes_[i].plan(v[i], a[i], target[i], accel_lim[i], jerk_lim[i]));
+
+    for (int i = 0; i < NUM_AXES; i++)
+      axes_[i].stretch(duration_);
+
+    return duration_;
+  }
+
+  void evaluate(double t, double v[NUM_AXES], double a[NUM_AXES]) const
+  {
+    for (int i = 0; i < NUM_AXES; i++)
+      axes_[i].evaluate(t, v[i], a[i]);
+  }
+
+  double duration() const
+  {
+    return duration_;
+  }
+
+private:
+  ScurveAxis axes_[NUM_AXES];
+  double duration_;
+};
+
+} // cob_base_velocity_smoother
+
+#endif /* JERK_LIMITED_PROFILE_H */
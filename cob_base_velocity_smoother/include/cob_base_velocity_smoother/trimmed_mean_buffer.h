@@ -0,0 +1,370 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_driver
+ * ROS package name: cob_base_velocity_smoother
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#ifndef TRIMMED_MEAN_BUFFER_H
+#define TRIMMED_MEAN_BUFFER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace cob_base_velocity_smoother {
+
+/****************************************************************
+ * circular buffer of planar velocities (x, y, theta) with time stamps,
+ * stored as structure of arrays.
+ * Elements are pushed to the front (index 0 = newest) and the oldest ones are
+ * dropped at the back once the capacity is reached, like boost::circular_buffer.
+ * Several copies of the same message pushed at once are kept as a single entry
+ * (run), so pushing a run of zeros and dropping a run is O(1).
+ * For each axis a running sum with a bound of its rounding error and monotonic min/max
+ * deques are maintained, so the mean without the element farthest from the mean is
+ * available in O(1); only if min and max are equally far from the mean within the
+ * rounding error, the plain computation decides in O(runs). A monotonic deque of the
+ * time stamps answers outdated() in O(1) as well.
+ * No memory is allocated after setCapacity().
+ ****************************************************************/
+class TrimmedMeanBuffer
+{
+public:
+  enum Axis
+  {
+    X = 0,
+    Y = 1,
+    THETA = 2,
+    NUM_AXES = 3
+  };
+
+  explicit TrimmedMeanBuffer(std::size_t capacity = 0)
+  {
+    setCapacity(capacity);
+  }
+
+  // sets the maximal number of elements and clears the buffer
+  void setCapacity(std::size_t capacity)
+  {
+    capacity_ = capacity;
+    stamp_.assign(capacity, 0.0);
+    count_.assign(capacity, 0);
+    for (std::size_t a = 0; a < NUM_AXES; a++)
+    {
+      value_[a].assign(capacity, 0.0);
+      min_runs_[a].reset(capacity);
+      max_runs_[a].reset(capacity);
+    }
+    stamp_runs_.reset(capacity);
+    clear();
+  }
+
+  void clear()
+  {
+    size_ = 0;
+    head_ = tail_ = 0;
+    pushes_since_resync_ = 0;
+    for (std::size_t a = 0; a < NUM_AXES; a++)
+    {
+      sum_[a] = 0.0;
+      sum_error_[a] = 0.0;
+      min_runs_[a].clear();
+      max_runs_[a].clear();
+    }
+    stamp_runs_.clear();
+  }
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == capacity_; }
+
+  // pushes count copies of the velocity to the front, dropping the oldest elements if the buffer is full
+  void pushFront(double x, double y, double theta, double stamp, std::size_t count = 1)
+  {
+    if (count == 0 || capacity_ == 0)
+      return;
+    if (count > capacity_)
+      count = capacity_;
+
+    // make room first, so the new run always gets a free slot
+    std::size_t overflow = size_ + count > capacity_ ? size_ + count - capacity_ : 0;
+    while (overflow > 0)
+    {
+      std::size_t& oldest = count_[slot(tail_)];
+      std::size_t n = oldest < overflow ? oldest : overflow;
+      for (std::size_t a = 0; a < NUM_AXES; a++)
+        subtractFromSum(a, value_[a][slot(tail_)], n);
+      oldest -= n;
+      size_ -= n;
+      overflow -= n;
+      if (oldest == 0)
+        dropOldestRun();
+    }
+
+    const std::size_t run = head_++;
+    const std::size_t s = slot(run);
+    const double values[NUM_AXES] = {x, y, theta};
+    stamp_[s] = stamp;
+    count_[s] = count;
+    while (!stamp_runs_.empty() && stamp_[slot(stamp_runs_.back())] <= stamp)
+      stamp_runs_.pop_back();
+    stamp_runs_.push_back(run);
+    for (std::size_t a = 0; a < NUM_AXES; a++)
+    {
+      value_[a][s] = values[a];
+      if (values[a] != 0.0)
+      {
+        for (std::size_t i = 0; i < count; i++)
+          addToSum(a, values[a]);
+      }
+
+      // keep only the newest occurrence of equal values
+      RunQueue& min_runs = min_runs_[a];
+      while (!min_runs.empty() && value_[a][slot(min_runs.back())] >= values[a])
+        min_runs.pop_back();
+      min_runs.push_back(run);
+      RunQueue& max_runs = max_runs_[a];
+      while (!max_runs.empty() && value_[a][slot(max_runs.back())] <= values[a])
+        max_runs.pop_back();
+      max_runs.push_back(run);
+    }
+    size_ += count;
+
+    // recompute the sums from time to time, so rounding errors of the running sums can't accumulate
+    if (++pushes_since_resync_ >= capacity_)
+      resync();
+  }
+
+  // removes the oldest elements as long as they are at least max_age older than now
+  void eraseOutdated(double now, double max_age)
+  {
+    while (size_ > 0 && now - stamp_[slot(tail_)] >= max_age)
+    {
+      std::size_t s = slot(tail_);
+      for (std::size_t a = 0; a < NUM_AXES; a++)
+        subtractFromSum(a, value_[a][s], count_[s]);
+      size_ -= count_[s];
+      dropOldestRun();
+    }
+  }
+
+  // returns true if all elements are at least max_age older than now
+  bool outdated(double now, double max_age) const
+  {
+    return stamp_runs_.empty() || now - stamp_[slot(stamp_runs_.front())] >= max_age;
+  }
+
+  // time stamp of the i-th newest element
+  double stamp(std::size_t i) const
+  {
+    std::size_t run = head_ - 1;
+    while (i >= count_[slot(run)])
+    {
+      i -= count_[slot(run)];
+      run--;
+    }
+    return stamp_[slot(run)];
+  }
+
+  // mean value of an axis without the element farthest from the mean (the newest one on ties),
+  // the same element is removed as by the plain three pass computation, the result is equal up to rounding of the sum
+  double trimmedMean(Axis axis) const
+  {
+    if (size_ == 0)
+      return 0.0;
+
+    // with only a few entries, min and max are often equally far from the mean and rounding decides,
+    // so evaluate them like the plain three pass computation to get exactly the same result
+    if (head_ - tail_ <= DIRECT_RUNS)
+      return trimmedMeanDirect(axis);
+
+    // the element farthest from the mean is either the minimum or the maximum
+    const double min = value_[axis][slot(min_runs_[axis].front())];
+    const double max = value_[axis][slot(max_runs_[axis].front())];
+
+    // constant axis, e.g. no lateral motion
+    if (min == max)
+      return (sum_[axis] - min) / (size_ - 1);
+
+    const double mean = sum_[axis] / size_;
+    const double min_dist = std::fabs(mean - min);
+    const double max_dist = std::fabs(mean - max);
+
+    // the mean of the plain computation differs by the rounding errors of both sums, which must not decide between
+    // min and max: within that tolerance the plain computation decides
+    const double eps = std::numeric_limits<double>::epsilon();
+    const double max_abs = std::max(std::fabs(min), std::fabs(max));
+    const double tolerance = 2.0 * sum_error_[axis] / size_ + 4.0 * eps * (size_ + 2) * max_abs;
+    if (std::fabs(min_dist - max_dist) <= tolerance)
+      return trimmedMeanDirect(axis);
+    return (sum_[axis] - (min_dist > max_dist ? min : max)) / (size_ - 1);
+  }
+
+private:
+  static const std::size_t DIRECT_RUNS = 16;
+
+  // double ended queue of run numbers, holding at most capacity runs
+  class RunQueue
+  {
+  public:
+    void reset(std::size_t capacity) { runs_.assign(capacity, 0); clear(); }
+    void clear() { begin_ = end_ = 0; }
+    bool empty() const { return begin_ == end_; }
+    std::size_t front() const { return runs_[begin_ % runs_.size()]; }
+    std::size_t back() const { return runs_[(end_ - 1) % runs_.size()]; }
+    void pop_front() { begin_++; }
+    void pop_back() { end_--; }
+    void push_back(std::size_t run) { runs_[end_++ % runs_.size()] = run; }
+
+  private:
+    std::vector<std::size_t> runs_;
+    std::size_t begin_, end_;
+  };
+
+  std::size_t slot(std::size_t run) const { return run % capacity_; }
+
+  // running sum updates, each adds a bound of its rounding error
+  void addToSum(std::size_t axis, double value)
+  {
+    sum_[axis] += value;
+    sum_error_[axis] += std::numeric_limits<double>::epsilon() * std::fabs(sum_[axis]);
+  }
+
+  void subtractFromSum(std::size_t axis, double value, std::size_t count)
+  {
+    const double product = value * count;
+    sum_[axis] -= product;
+    sum_error_[axis] += std::numeric_limits<double>::epsilon() * (std::fabs(product) + std::fabs(sum_[axis]));
+  }
+
+  // sums up the elements from the newest to the oldest one, leaving out one element of run skip,
+  // optionally adds a bound of the rounding error to error
+  double directSum(Axis axis, std::size_t skip, double* error = NULL) const
+  {
+    double sum = 0.0;
+    for (std::size_t run = head_; run != tail_; run--)
+    {
+      const std::size_t s = slot(run - 1);
+      if (value_[axis][s] == 0.0)
+        continue;
+      const std::size_t count = run - 1 == skip ? count_[s] - 1 : count_[s];
+      for (std::size_t i = 0; i < count; i++)
+      {
+        sum += value_[axis][s];
+        if (error)
+          *error += std::numeric_limits<double>::epsilon() * std::fabs(sum);
+      }
+    }
+    return sum;
+  }
+
+  // mean without the element farthest from the mean, computed in three passes over all runs
+  double trimmedMeanDirect(Axis axis) const
+  {
+    const std::size_t no_run = tail_ - 1;
+    double mean = directSum(axis, no_run) / size_;
+    if (size_ == 1)
+      return mean;
+
+    std::size_t max_run = head_ - 1;
+    double max = value_[axis][slot(max_run)];
+    for (std::size_t run = head_; run != tail_; run--)
+    {
+      const double value = value_[axis][slot(run - 1)];
+      if (std::fabs(mean - value) > std::fabs(mean - max))
+      {
+        max = value;
+        max_run = run - 1;
+      }
+    }
+    return directSum(axis, max_run) / (size_ - 1);
+  }
+
+  void dropOldestRun()
+  {
+    for (std::size_t a = 0; a < NUM_AXES; a++)
+    {
+      if (!min_runs_[a].empty() && min_runs_[a].front() == tail_)
+        min_runs_[a].pop_front();
+      if (!max_runs_[a].empty() && max_runs_[a].front() == tail_)
+        max_runs_[a].pop_front();
+    }
+    if (!stamp_runs_.empty() && stamp_runs_.front() == tail_)
+      stamp_runs_.pop_front();
+    tail_++;
+  }
+
+  void resync()
+  {
+    for (std::size_t a = 0; a < NUM_AXES; a++)
+    {
+      sum_error_[a] = 0.0;
+      sum_[a] = directSum(static_cast<Axis>(a), tail_ - 1, &sum_error_[a]);
+    }
+    pushes_since_resync_ = 0;
+  }
+
+  std::size_t capacity_, size_;
+
+  // runs are numbered consecutively, tail_ is the oldest one and head_ - 1 the newest one
+  std::size_t head_, tail_;
+  std::vector<double> stamp_;
+  std::vector<std::size_t> count_;
+  std::vector<double> value_[NUM_AXES];
+
+  double sum_[NUM_AXES];
+  double sum_error_[NUM_AXES];
+  std::size_t pushes_since_resync_;
+
+  // runs with increasing minimum / decreasing maximum, from the oldest to the newest one
+  RunQueue min_runs_[NUM_AXES];
+  RunQueue max_runs_[NUM_AXES];
+
+  // runs with decreasing time stamps, the front holds the newest stamp
+  RunQueue stamp_runs_;
+};
+
+} // cob_base_velocity_smoother
+
+#endif
@@ -22,6 +22,7 @@
 #include <ros/ros.h>
 #include <dynamic_reconfigure/server.h>
 #include <cob_base_velocity_smoother/paramsConfig.h>
+#include <cob_base_velocity_smoother/velocity_smoothing.h>
 #include <nav_msgs/Odometry.h>
 
 /*****************************************************************************
@@ -62,6 +63,8 @@ private:
   double speed_lim_vy, accel_lim_vy, decel_lim_vy, decel_lim_vy_safe;
   double speed_lim_w, accel_lim_w, decel_lim_w, decel_lim_w_safe;
   double decel_factor, decel_factor_safe;
+  double jerk_lim_vx, jerk_lim_vy, jerk_lim_w;
+  int smoothing_mode; /**< ACCELERATION_LIMITED or JERK_LIMITED, see params.cfg */
 
   double frequency;
 
@@ -69,6 +72,9 @@ private:
   geometry_msgs::Twist  current_vel;
   geometry_msgs::Twist   target_vel;
 
+  AccelLimitSmoother accel_smoother; /**< ACCELERATION_LIMITED mode */
+  JerkLimitSmoother   jerk_smoother; /**< JERK_LIMITED mode */
+
   bool                 shutdown_req; /**< Shutdown requested by nodelet; kill worker thread */
   bool                 input_active;
   double                cb_avg_time;
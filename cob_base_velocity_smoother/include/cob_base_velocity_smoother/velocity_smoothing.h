@@ -0,0 +1,402 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_driver
+ * ROS package name: cob_base_velocity_smoother
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+
+#ifndef VELOCITY_SMOOTHING_H
+#define VELOCITY_SMOOTHING_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include <cob_base_velocity_smoother/trimmed_mean_buffer.h>
+#include <cob_base_velocity_smoother/jerk_limited_profile.h>
+
+/*****************************************************************************
+ * Smoothing strategies for planar base velocities, independent of ROS.
+ * They work on plain structs with explicit time stamps (in seconds) and don't
+ * allocate memory after configuration, so they can be used from realtime
+ * controllers and replayed offline (see velocity_smoother_benchmark).
+ *  - BufferMeanSmoother: trimmed mean of the recent commands with a limit of the
+ *    output change per step (cob_base_velocity_smoother node)
+ *  - AccelLimitSmoother: per axis acceleration/deceleration limits (velocity_smoother node)
+ *  - JerkLimitSmoother: synchronized jerk limited S-curves (velocity_smoother node)
+ *****************************************************************************/
+
+namespace cob_base_velocity_smoother {
+
+/*****************************************************************************
+** Velocity2D
+*****************************************************************************/
+
+struct Velocity2D
+{
+  double x, y, theta;
+
+  Velocity2D()
+  : x(0.0), y(0.0), theta(0.0)
+  {
+  }
+
+  Velocity2D(double x, double y, double theta)
+  : x(x), y(y), theta(theta)
+  {
+  }
+
+  bool isZero() const
+  {
+    return (x == 0.0) && (y == 0.0) && (theta == 0.0);
+  }
+
+  bool operator==(const Velocity2D& other) const
+  {
+    return (x == other.x) && (y == other.y) && (theta == other.theta);
+  }
+
+  bool operator!=(const Velocity2D& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/*****************************************************************************
+** BufferMeanSmoother
+*****************************************************************************/
+
+/**
+ * Mean of the commands received within store_delay, leaving out the one farthest from the mean.
+ * Zero commands are inserted several times to stop faster. The change of the output between two
+ * updates is limited to acc_limit.
+ **/
+class BufferMeanSmoother
+{
+public:
+  BufferMeanSmoother()
+  : store_delay_(4.0)
+  , acc_limit_(0.3)
+  , has_output_(false)
+  {
+  }
+
+  void configure(std::size_t capacity, double store_delay, double acc_limit)
+  {
+    buffer_.setCapacity(capacity);
+    store_delay_ = store_delay;
+    acc_limit_ = acc_limit;
+    has_output_ = false;
+  }
+
+  /**
+   * Fills the buffer with zero commands received at time now.
+   **/
+  void reset(double now)
+  {
+    buffer_.clear();
+    push(now, Velocity2D(), buffer_.capacity());
+    has_output_ = false;
+  }
+
+  /**
+   * Adds the command received at time now and returns the smoothed velocity.
+   **/
+  Velocity2D update(double now, const Velocity2D& cmd_vel)
+  {
+    reviseBuffer(now, cmd_vel);
+
+    Velocity2D result(buffer_.trimmedMean(TrimmedMeanBuffer::X),
+                      buffer_.trimmedMean(TrimmedMeanBuffer::Y),
+                      buffer_.trimmedMean(TrimmedMeanBuffer::THETA));
+    limitAcceleration(now, result);
+
+    last_output_ = result;
+    has_output_ = true;
+    return result;
+  }
+
+  const TrimmedMeanBuffer& buffer() const
+  {
+    return buffer_;
+  }
+
+private:
+  TrimmedMeanBuffer buffer_;
+  double store_delay_;  /**< Maximal age of the stored commands */
+  double acc_limit_;    /**< Maximal change of the output per update */
+  Velocity2D last_output_;
+  bool has_output_;
+
+  void push(double now, const Velocity2D& cmd_vel, std::size_t count)
+  {
+    buffer_.pushFront(cmd_vel.x, cmd_vel.y, cmd_vel.theta, now, count);
+  }
+
+  void reviseBuffer(double now, const Velocity2D& cmd_vel)
+  {
+    if (buffer_.outdated(now, store_delay_))
+    {
+      // the buffer is out of date, so clear and refill with zero messages before adding the new command
+      buffer_.clear();
+      push(now, Velocity2D(), buffer_.capacity());
+      push(now, cmd_vel, 1);
+      return;
+    }
+
+    // only some elements of the buffer are out of date, so only delete those
+    buffer_.eraseOutdated(now, store_delay_);
+    if (buffer_.empty())
+      push(now, Velocity2D(), buffer_.capacity());
+
+    if (cmd_vel.isZero())
+    {
+      // to stop the robot faster, add floor(size / 3) zero messages
+      push(now, cmd_vel, buffer_.size() / 3);
+    }
+    else
+    {
+      push(now, cmd_vel, 1);
+    }
+  }
+
+  static void limitChange(double last, double& value, double limit)
+  {
+    double delta = value - last;
+    if (std::fabs(delta) > limit)
+      value = last + (delta < 0.0 ? -limit : limit);
+  }
+
+  void limitAcceleration(double now, Velocity2D& result) const
+  {
+    // only if an output has been computed yet
+    double delta_time = 0.0;
+    if (buffer_.size() > 2)
+      delta_time = now - buffer_.stamp(2);
+
+    if (has_output_ && (delta_time > 0.0))
+    {
+      limitChange(last_output_.x, result.x, acc_limit_);
+      limitChange(last_output_.y, result.y, acc_limit_);
+      limitChange(last_output_.theta, result.theta, acc_limit_);
+    }
+  }
+};
+
+/*****************************************************************************
+** Rate limited smoothers
+*****************************************************************************/
+
+/**
+ * Common part of the smoothers that step their output towards a target velocity with
+ * acceleration and deceleration limits (per second).
+ * The time step is taken from the time stamps; the first one and the ones after a stall
+ * are bounded by the nominal period.
+ **/
+class RateLimitedSmoother
+{
+public:
+  RateLimitedSmoother()
+  : period_(0.05)
+  , last_stamp_(0.0)
+  , has_stamp_(false)
+  {
+  }
+
+  /**
+   * Nominal period between two updates.
+   **/
+  void setPeriod(double period)
+  {
+    period_ = period;
+  }
+
+  void setLimits(const Velocity2D& accel_lim, const Velocity2D& decel_lim)
+  {
+    accel_lim_ = accel_lim;
+    decel_lim_ = decel_lim;
+  }
+
+  const Velocity2D& output() const
+  {
+    return output_;
+  }
+
+protected:
+  double period_;
+  double last_stamp_;
+  bool has_stamp_;
+  Velocity2D accel_lim_, decel_lim_;
+  Velocity2D output_;
+
+  // time since the last update, the nominal period if unknown; at most two periods
+  double timeStep(double now)
+  {
+    double dt = has_stamp_ ? std::min(std::max(now - last_stamp_, 0.0), 2.0*period_) : period_;
+    last_stamp_ = now;
+    has_stamp_ = true;
+    return dt;
+  }
+
+  // acceleration limit for changing the velocity by inc towards target; decelerate when accelerating
+  // away from zero or if the robot still moves into the other direction (countermarch, needs feedback)
+  static double changeLimit(double inc, double target, const double* feedback, double accel_lim, double decel_lim)
+  {
+    if ((feedback != NULL) && (*feedback*target < 0.0))
+      return decel_lim;
+    return (inc*target > 0.0) ? accel_lim : decel_lim;
+  }
+};
+
+/**
+ * Limits the change of each axis to its acceleration (away from zero) or deceleration limit.
+ **/
+class AccelLimitSmoother : public RateLimitedSmoother
+{
+public:
+  /**
+   * Continues smoothing from velocity v, e.g. the measured one.
+   **/
+  void reset(const Velocity2D& v)
+  {
+    output_ = v;
+  }
+
+  /**
+   * Steps the output towards the target velocity.
+   * @param feedback : measured velocity for countermarch detection, NULL if not available
+   **/
+  const Velocity2D& update(double now, const Velocity2D& target, const Velocity2D* feedback = NULL)
+  {
+    double dt = timeStep(now);
+    step(output_.x, target.x, feedback ? &feedback->x : NULL, accel_lim_.x, decel_lim_.x, dt);
+    step(output_.y, target.y, feedback ? &feedback->y : NULL, accel_lim_.y, decel_lim_.y, dt);
+    step(output_.theta, target.theta, feedback ? &feedback->theta : NULL, accel_lim_.theta, decel_lim_.theta, dt);
+    return output_;
+  }
+
+private:
+  static void step(double& v, double target, const double* feedback, double accel_lim, double decel_lim, double dt)
+  {
+    double inc = target - v;
+    double max_inc = changeLimit(inc, target, feedback, accel_lim, decel_lim)*dt;
+    if (std::fabs(inc) > max_inc)
+      v += (inc < 0.0 ? -max_inc : max_inc);
+    else
+      v = target;
+  }
+};
+
+/**
+ * Follows a JerkLimitedProfile, which is planned from the current output and acceleration
+ * whenever the target changes.
+ **/
+class JerkLimitSmoother : public RateLimitedSmoother
+{
+public:
+  JerkLimitSmoother()
+  : profile_start_(0.0)
+  , profile_valid_(false)
+  {
+  }
+
+  void setJerkLimits(const Velocity2D& jerk_lim)
+  {
+    jerk_lim_ = jerk_lim;
+  }
+
+  /**
+   * Continues smoothing from velocity v with zero acceleration.
+   **/
+  void reset(const Velocity2D& v)
+  {
+    output_ = v;
+    acc_ = Velocity2D();
+    profile_valid_ = false;
+  }
+
+  const Velocity2D& acceleration() const
+  {
+    return acc_;
+  }
+
+  /**
+   * Evaluates the profile towards the target velocity at time now.
+   * @param feedback : measured velocity for countermarch detection, NULL if not available
+   **/
+  const Velocity2D& update(double now, const Velocity2D& target, const Velocity2D* feedback = NULL)
+  {
+    double dt = timeStep(now);
+    if (!profile_valid_ || (target != profile_target_))
+    {
+      double v[]      = { output_.x, output_.y, output_.theta };
+      double a[]      = { acc_.x, acc_.y, acc_.theta };
+      double goal[]   = { target.x, target.y, target.theta };
+      double accel[]  = { changeLimit(goal[0] - v[0], goal[0], feedback ? &feedback->x : NULL, accel_lim_.x, decel_lim_.x),
+                          changeLimit(goal[1] - v[1], goal[1], feedback ? &feedback->y : NULL, accel_lim_.y, decel_lim_.y),
+                          changeLimit(goal[2] - v[2], goal[2], feedback ? &feedback->theta : NULL,
+                                      accel_lim_.theta, decel_lim_.theta) };
+      double jerk[]   = { jerk_lim_.x, jerk_lim_.y, jerk_lim_.theta };
+
+      profile_.plan(v, a, goal, accel, jerk);
+      profile_target_ = target;
+      profile_start_ = now - dt;
+      profile_valid_ = true;
+    }
+
+    double v[JerkLimitedProfile::NUM_AXES], a[JerkLimitedProfile::NUM_AXES];
+    profile_.evaluate(now - profile_start_, v, a);
+    output_ = Velocity2D(v[0], v[1], v[2]);
+    acc_ = Velocity2D(a[0], a[1], a[2]);
+    return output_;
+  }
+
+private:
+  Velocity2D jerk_lim_;
+  Velocity2D acc_;
+  JerkLimitedProfile profile_;
+  Velocity2D profile_target_;
+  double profile_start_;
+  bool profile_valid_;
+};
+
+} // cob_base_velocity_smoother
+
+#endif /* VELOCITY_SMOOTHING_H */
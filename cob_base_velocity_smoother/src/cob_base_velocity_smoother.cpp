@@ -50,6 +50,8 @@
 
 #include <cob_base_velocity_smoother.h>
 
+namespace cob_base_velocity_smoother {
+
 /****************************************************************
  * the ros navigation doesn't run very smoothly because acceleration is too high
  * --> cob has strong base motors and therefore reacts with shaking behavior
@@ -61,14 +63,14 @@
  ****************************************************************/
 
 // function for checking wether a new msg has been received, triggering publishers accordingly
-void cob_base_velocity_smoother::set_new_msg_received(bool received)
+void BufferedVelocitySmoother::set_new_msg_received(bool received)
 {
   pthread_mutex_lock(&m_mutex);
   new_msg_received_ = received;
   pthread_mutex_unlock(&m_mutex);
 }
 
-bool cob_base_velocity_smoother::get_new_msg_received()
+bool BufferedVelocitySmoother::get_new_msg_received()
 {
   pthread_mutex_lock(&m_mutex);
   bool ret_val = new_msg_received_;
@@ -77,7 +79,7 @@ bool cob_base_velocity_smoother::get_new_msg_received()
 }
 
 // constructor
-cob_base_velocity_smoother::cob_base_velocity_smoother()
+BufferedVelocitySmoother::BufferedVelocitySmoother()
 {
   m_mutex = PTHREAD_MUTEX_INITIALIZER;
   new_msg_received_ = false;
@@ -90,7 +92,7 @@ cob_base_velocity_smoother::cob_base_velocity_smoother()
   pub_ = nh_.advertise<geometry_msgs::Twist>("output", 1);
 
   // subscriber
-  geometry_msgs_sub_ = nh_.subscribe<geometry_msgs::Twist>("input", 1, boost::bind(&cob_base_velocity_smoother::geometryCallback, this, _1));
+  geometry_msgs_sub_ = nh_.subscribe<geometry_msgs::Twist>("input", 1, boost::bind(&BufferedVelocitySmoother::geometryCallback, this, _1));
 
   // get parameters from parameter server if possible or write default values to variables
   if( !pnh_.hasParam("circular_buffer_capacity") )
@@ -146,34 +148,23 @@ cob_base_velocity_smoother::cob_base_velocity_smoother()
   zero_values_.angular.y = 0.0;
   zero_values_.angular.z = 0.0;
 
-  // initialize circular buffers
-  cb_.set_capacity(buffer_capacity_);
-  cb_out_.set_capacity(buffer_capacity_);
-  cb_time_.set_capacity(buffer_capacity_);
-
-  // set actual ros::Time
-  ros::Time now = ros::Time::now();
-
-  // fill circular buffer with zero values
-  while(cb_.full() == false)
-  {
-    cb_.push_front(zero_values_);
-    cb_time_.push_front(now);
-  }
+  // initialize circular buffer and fill it with zero values
+  smoother_.configure(buffer_capacity_, store_delay_, acc_limit_);
+  smoother_.reset(ros::Time::now().toSec());
 };
 
 // destructor
-cob_base_velocity_smoother::~cob_base_velocity_smoother(){}
+BufferedVelocitySmoother::~BufferedVelocitySmoother(){}
 
 // callback function to subsribe to the geometry messages cmd_vel and save them in a member variable
-void cob_base_velocity_smoother::geometryCallback(const geometry_msgs::Twist::ConstPtr &cmd_vel)
+void BufferedVelocitySmoother::geometryCallback(const geometry_msgs::Twist::ConstPtr &cmd_vel)
 {
   sub_msg_ = *cmd_vel;
   set_new_msg_received(true);
 }
 
 // calculation function called periodically in main
-void cob_base_velocity_smoother::calculationStep()
+void BufferedVelocitySmoother::calculationStep()
 {
   // set current ros::Time
   ros::Time now = ros::Time::now();
@@ -206,120 +197,21 @@ void cob_base_velocity_smoother::calculationStep()
 }
 
 // function for the actual computation
-// calls the reviseCircBuff and the meanValue-functions and limits the acceleration under thresh
-// returns the resulting geomtry message to be published to the base_controller
-geometry_msgs::Twist cob_base_velocity_smoother::setOutput(ros::Time now, geometry_msgs::Twist cmd_vel)
+// passes the command to the smoother and returns the resulting geomtry message to be published to the base_controller
+geometry_msgs::Twist BufferedVelocitySmoother::setOutput(ros::Time now, geometry_msgs::Twist cmd_vel)
 {
   geometry_msgs::Twist result = zero_values_;
 
-  // update the circular buffers
-  this->reviseCircBuff(now, cmd_vel);
-
-  // calculate the mean values for each direction
-  result.linear.x = meanValueX();
-  result.linear.y = meanValueY();
-  result.angular.z = meanValueZ();
-
-  // limit acceleration
-  this->limitAcceleration(now, result);
-
-  // insert the result-message into the circular-buffer storing the output
-  cb_out_.push_front(result);
+  Velocity2D smoothed = smoother_.update(now.toSec(), Velocity2D(cmd_vel.linear.x, cmd_vel.linear.y, cmd_vel.angular.z));
+  result.linear.x = smoothed.x;
+  result.linear.y = smoothed.y;
+  result.angular.z = smoothed.theta;
 
   return result;
 }
 
-// function that updates the circular buffer after receiving a new geometry message
-void cob_base_velocity_smoother::reviseCircBuff(ros::Time now, geometry_msgs::Twist cmd_vel)
-{
-  if(this->circBuffOutOfDate(now) == true)
-  {
-    // the circular buffer is out of date, so clear and refill with zero messages before adding the new command
-
-    // clear buffers
-    cb_.clear();
-    cb_time_.clear();
-
-    // fill circular buffer with zero_values_ and time buffer with actual time-stamp
-    while(cb_.full() == false)
-    {
-      cb_.push_front(zero_values_);
-      cb_time_.push_front(now);
-    }
-
-    // add new command velocity message to circular buffer
-    cb_.push_front(cmd_vel);
-    // add new timestamp for subscribed command velocity message
-    cb_time_.push_front(now);
-  }
-  else
-  {
-    // only some elements of the circular buffer are out of date, so only delete those
-    double delay=(now.toSec() - cb_time_.back().toSec());
-
-    while( delay >= store_delay_ )
-    {
-      // remove out-dated messages
-      cb_.pop_back();
-      cb_time_.pop_back();
-
-      delay=(now.toSec() - cb_time_.back().toSec());
-    }
-    // if the circular buffer is empty now, refill with zero values
-    if(cb_.empty() == true)
-    {
-      while(cb_.full() == false)
-      {
-        cb_.push_front(zero_values_);
-        cb_time_.push_front(now);
-      }
-    }
-    if(this->IsZeroMsg(cmd_vel))
-    {
-      // here we subscribed  a zero message, so we want to stop the robot
-      long unsigned int size = floor( cb_.size() / 3 );
-
-      // to stop the robot faster, fill the circular buffer with more than one, in fact floor (cb_.size() / 3 ), zero messages
-      for(long unsigned int i=0; i< size; i++)
-      {
-        // add new command velocity message to circular buffer
-        cb_.push_front(cmd_vel);
-        // add new timestamp for subscribed command velocity message
-        cb_time_.push_front(now);
-      }
-    }
-    else
-    {
-      // add new command velocity message to circular buffer
-      cb_.push_front(cmd_vel);
-      // add new timestamp for subscribed command velocity message
-      cb_time_.push_front(now);
-    }
-  }
-};
-
-// returns true if all messages in cb are out of date in consideration of store_delay
-bool cob_base_velocity_smoother::circBuffOutOfDate(ros::Time now)
-{
-  bool result=true;
-
-  long unsigned int count=0;
-
-  while( (count < cb_.size()) && (result == true) )
-  {
-    double delay=(now.toSec() - cb_time_[count].toSec());
-    if(delay < store_delay_)
-    {
-      result = false;
-    }
-    count++;
-  }
-
-  return result;
-};
-
 // returns true if the input msg cmd_vel equals zero_values_, false otherwise
-bool cob_base_velocity_smoother::IsZeroMsg(geometry_msgs::Twist cmd_vel)
+bool BufferedVelocitySmoother::IsZeroMsg(geometry_msgs::Twist cmd_vel)
 {
   bool result = true;
   if( (cmd_vel.linear.x) != 0 || (cmd_vel.linear.y != 0) || (cmd_vel.angular.z != 0) )
@@ -330,200 +222,13 @@ bool cob_base_velocity_smoother::IsZeroMsg(geometry_msgs::Twist cmd_vel)
   return result;
 };
 
-int cob_base_velocity_smoother::signum(double var)
-{
-  if(var < 0)
-  {
-    return -1;
-  }
-  else
-  {
-    return 1;
-  }
-};
-
-// functions to calculate the mean values for linear/x
-double cob_base_velocity_smoother::meanValueX()
-{
-  double result = 0;
-  long unsigned int size = cb_.size();
-
-  // calculate sum
-  for(long unsigned int i=0; i<size; i++)
-  {
-    result += cb_[i].linear.x;
-  }
-  result /= size;
-
-  if(size > 1)
-  {
-    double help_result = 0;
-    double max = cb_[0].linear.x;
-    long unsigned int max_ind = 0;
-    for(long unsigned int i=0; i<size; i++)
-    {
-      if(abs(result-cb_[i].linear.x) > abs(result-max))
-      {
-        max = cb_[i].linear.x;
-        max_ind = i;
-      }
-    }
-
-    // calculate sum
-    for(long unsigned int i=0; i<size; i++)
-    {
-      if(i != max_ind)
-      {
-        help_result += cb_[i].linear.x;
-      }
-    }
-    result = help_result / (size - 1);
-  }
-
-  return result;
-};
-
-// functions to calculate the mean values for linear/y
-double cob_base_velocity_smoother::meanValueY()
-{
-  double result = 0;
-  long unsigned int size = cb_.size();
-
-  // calculate sum
-  for(long unsigned int i=0; i<size; i++)
-  {
-    result += cb_[i].linear.y;
-  }
-  result /= size;
-
-  if(size > 1)
-  {
-    double help_result = 0;
-    double max = cb_[0].linear.y;
-    long unsigned int max_ind = 0;
-    for(long unsigned int i=0; i<size; i++)
-    {
-      if(abs(result-cb_[i].linear.y) > abs(result-max))
-      {
-        max = cb_[i].linear.y;
-        max_ind = i;
-      }
-    }
-
-    // calculate sum
-    for(long unsigned int i=0; i<size; i++)
-    {
-      if(i != max_ind)
-      {
-        help_result += cb_[i].linear.y;
-      }
-    }
-    result = help_result / (size - 1);
-  }
-
-  return result;
-};
-
-// functions to calculate the mean values for angular/z
-double cob_base_velocity_smoother::meanValueZ()
-{
-  double result = 0;
-  long unsigned int size = cb_.size();
-
-  // calculate sum
-  for(long unsigned int i=0; i<size; i++)
-  {
-    result += cb_[i].angular.z;
-  }
-  result /= size;
-
-  if(size > 1)
-  {
-    double help_result = 0;
-    double max = cb_[0].angular.z;
-    long unsigned int max_ind = 0;
-    for(long unsigned int i = 0; i < size; i++)
-    {
-      if(abs(result-cb_[i].angular.z) > abs(result-max))
-      {
-        max = cb_[i].angular.z;
-        max_ind = i;
-      }
-    }
-
-    // calculate sum
-    for(long unsigned int i = 0; i < size; i++)
-    {
-      if(i != max_ind)
-      {
-        help_result += cb_[i].angular.z;
-      }
-    }
-    result = help_result / (size - 1);
-  }
-
-  return result;
-};
-
 // function to make the loop rate availabe outside the class
-double cob_base_velocity_smoother::getLoopRate()
+double BufferedVelocitySmoother::getLoopRate()
 {
   return loop_rate_;
 }
 
-// function to compare two geometry messages
-bool cob_base_velocity_smoother::IsEqual(geometry_msgs::Twist msg1, geometry_msgs::Twist msg2)
-{
-  if( (msg1.linear.x == msg2.linear.x) && (msg1.linear.y == msg2.linear.y) && (msg1.angular.z == msg2.angular.z))
-  {
-    return true;
-  }
-  else
-  {
-    return false;
-  }
-}
-
-//function to limit the acceleration under the given threshhold thresh
-void cob_base_velocity_smoother::limitAcceleration(ros::Time now, geometry_msgs::Twist& result)
-{
-  // limit the acceleration under thresh
-  // only if cob_base_velocity_smoother has published a message yet
-
-  double deltaTime = 0;
-
-  if(cb_time_.size() > 1)
-  {
-    deltaTime = now.toSec() - cb_time_[2].toSec();
-  }
-
-  if( cb_out_.size() > 0)
-  {
-    if(deltaTime > 0)
-    {
-      // set delta velocity and acceleration values
-      double deltaX = result.linear.x - cb_out_.front().linear.x;
-
-      double deltaY = result.linear.y - cb_out_.front().linear.y;
-
-      double deltaZ = result.angular.z - cb_out_.front().angular.z;
-
-      if( abs(deltaX) > acc_limit_)
-      {
-        result.linear.x = cb_out_.front().linear.x + this->signum(deltaX) * acc_limit_;
-      }
-      if( abs(deltaY) > acc_limit_ )
-      {
-        result.linear.y = cb_out_.front().linear.y + this->signum(deltaY) * acc_limit_;
-      }
-      if( abs(deltaZ) > acc_limit_ )
-      {
-        result.angular.z = cb_out_.front().angular.z + this->signum(deltaZ) * acc_limit_;
-      }
-    }
-  }
-};
-
+} // cob_base_velocity_smoother
 
 int main(int argc, char **argv)
 {
@@ -531,7 +236,7 @@ int main(int argc, char **argv)
   ros::init(argc, argv, "cob_base_velocity_smoother");
 
   // create Node Class
-  cob_base_velocity_smoother my_velocity_smoother;
+  cob_base_velocity_smoother::BufferedVelocitySmoother my_velocity_smoother;
   // get loop rate from class member
   ros::Rate rate(my_velocity_smoother.getLoopRate());
   // actual calculation step with given frequency
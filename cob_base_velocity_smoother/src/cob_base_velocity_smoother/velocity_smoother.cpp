@@ -31,12 +31,18 @@
 
 namespace cob_base_velocity_smoother {
 
+static Velocity2D toVelocity2D(const geometry_msgs::Twist& twist)
+{
+  return Velocity2D(twist.linear.x, twist.linear.y, twist.angular.z);
+}
+
 /*********************
 ** Implementation
 **********************/
 
 VelocitySmoother::VelocitySmoother(const std::string &name)
 : name(name)
+, smoothing_mode(cob_base_velocity_smoother::params_ACCELERATION_LIMITED)
 , shutdown_req(false)
 , input_active(false)
 , pr_next(0)
@@ -46,8 +52,9 @@ VelocitySmoother::VelocitySmoother(const std::string &name)
 
 void VelocitySmoother::reconfigCB(cob_base_velocity_smoother::paramsConfig &config, uint32_t level)
 {
-  ROS_INFO("Reconfigure request : %f %f %f %f %f %f %f %f",
-           config.speed_lim_vx, config.speed_lim_vy, config.speed_lim_w, config.accel_lim_vx, config.accel_lim_vy, config.accel_lim_w, config.decel_factor, config.decel_factor_safe);
+  ROS_INFO("Reconfigure request : %f %f %f %f %f %f %f %f %d %f %f %f",
+           config.speed_lim_vx, config.speed_lim_vy, config.speed_lim_w, config.accel_lim_vx, config.accel_lim_vy, config.accel_lim_w, config.decel_factor, config.decel_factor_safe,
+           config.smoothing_mode, config.jerk_lim_vx, config.jerk_lim_vy, config.jerk_lim_w);
 
   speed_lim_vx  = config.speed_lim_vx;
   speed_lim_vy  = config.speed_lim_vy;
@@ -63,6 +70,10 @@ void VelocitySmoother::reconfigCB(cob_base_velocity_smoother::paramsConfig &conf
   decel_lim_vx_safe = decel_factor_safe*accel_lim_vx;
   decel_lim_vy_safe = decel_factor_safe*accel_lim_vy;
   decel_lim_w_safe = decel_factor_safe*accel_lim_w;
+  jerk_lim_vx = config.jerk_lim_vx;
+  jerk_lim_vy = config.jerk_lim_vy;
+  jerk_lim_w = config.jerk_lim_w;
+  smoothing_mode = config.smoothing_mode;
 }
 
 void VelocitySmoother::velocityCB(const geometry_msgs::Twist::ConstPtr& msg)
@@ -184,101 +195,48 @@ void VelocitySmoother::spin()
       last_cmd_vel = current_vel;
     }
 
-    geometry_msgs::TwistPtr cmd_vel;
-
-    if ((target_vel.linear.x  != last_cmd_vel.linear.x) ||
-        (target_vel.linear.y  != last_cmd_vel.linear.y) ||
-        (target_vel.angular.z != last_cmd_vel.angular.z))
-    {
-      // Try to reach target velocity ensuring that we don't exceed the acceleration limits
-      cmd_vel.reset(new geometry_msgs::Twist(target_vel));
-
-      double vx_inc, vy_inc, w_inc, max_vx_inc, max_vy_inc, max_w_inc;
-
-      vx_inc = target_vel.linear.x - last_cmd_vel.linear.x;
-      if ((robot_feedback == ODOMETRY) && (current_vel.linear.x*target_vel.linear.x < 0.0))
-      {
-        // countermarch (on robots with significant inertia; requires odometry feedback to be detected)
-        max_vx_inc = decel_vx*period;
-      }
-      else
-      {
-        max_vx_inc = ((vx_inc*target_vel.linear.x > 0.0)?accel_lim_vx:decel_vx)*period;
-      }
-
-      vy_inc = target_vel.linear.y - last_cmd_vel.linear.y;
-      if ((robot_feedback == ODOMETRY) && (current_vel.linear.y*target_vel.linear.y < 0.0))
-      {
-        // countermarch (on robots with significant inertia; requires odometry feedback to be detected)
-        max_vy_inc = decel_vy*period;
-      }
-      else
-      {
-        max_vy_inc = ((vy_inc*target_vel.linear.x > 0.0)?accel_lim_vy:decel_vy)*period;
-      }
-
-      w_inc = target_vel.angular.z - last_cmd_vel.angular.z;
-      if ((robot_feedback == ODOMETRY) && (current_vel.angular.z*target_vel.angular.z < 0.0))
-      {
-        // countermarch (on robots with significant inertia; requires odometry feedback to be detected)
-        max_w_inc = decel_w*period;
-      }
-      else
-      {
-        max_w_inc = ((w_inc*target_vel.angular.z > 0.0)?accel_lim_w:decel_w)*period;
-      }
-
-/*
-      // Calculate and normalise vectors A (desired velocity increment) and B (maximum velocity increment),
-      // where v acts as coordinate x and w as coordinate y; the sign of the angle from A to B determines
-      // which velocity (v or w) must be overconstrained to keep the direction provided as command
-      double MA = sqrt(    vx_inc *     vx_inc +     w_inc *     w_inc);
-      double MB = sqrt(max_vx_inc * max_vx_inc + max_w_inc * max_w_inc);
+    // Countermarch detection on robots with significant inertia requires odometry feedback
+    Velocity2D feedback = toVelocity2D(current_vel);
+    const Velocity2D* feedback_ptr = (robot_feedback == ODOMETRY) ? &feedback : NULL;
 
-      double Av = std::abs(vx_inc) / MA;
-      double Aw = std::abs(w_inc) / MA;
-      double Bv = max_vx_inc / MB;
-      double Bw = max_w_inc / MB;
-      double theta = atan2(Bw, Bv) - atan2(Aw, Av);
+    // The smoothers continue from the last command; it differs from their output after
+    // using the velocity feedback or switching the mode
+    const Velocity2D last_cmd = toVelocity2D(last_cmd_vel);
+    const Velocity2D target = toVelocity2D(target_vel);
+    const Velocity2D accel_lim(accel_lim_vx, accel_lim_vy, accel_lim_w);
+    const Velocity2D decel_lim(decel_vx, decel_vy, decel_w);
+    const double now = ros::Time::now().toSec();
 
-      if (theta < 0)
-      {
-        // overconstrain linear velocity
-        max_vx_inc = (max_w_inc*std::abs(vx_inc))/std::abs(w_inc);
-      }
-      else
-      {
-        // overconstrain angular velocity
-        max_w_inc = (max_vx_inc*std::abs(w_inc))/std::abs(vx_inc);
-      }
-*/
-      if (std::abs(vx_inc) > max_vx_inc)
-      {
-        // we must limit linear velocity
-        cmd_vel->linear.x  = last_cmd_vel.linear.x  + sign(vx_inc)*max_vx_inc;
-      }
-
-      if (std::abs(vy_inc) > max_vy_inc)
-      {
-        // we must limit linear velocity
-        cmd_vel->linear.y  = last_cmd_vel.linear.y  + sign(vy_inc)*max_vy_inc;
-      }
+    Velocity2D smoothed;
+    if (smoothing_mode == cob_base_velocity_smoother::params_JERK_LIMITED)
+    {
+      if (jerk_smoother.output() != last_cmd)
+        jerk_smoother.reset(last_cmd);
+      jerk_smoother.setPeriod(period);
+      jerk_smoother.setLimits(accel_lim, decel_lim);
+      jerk_smoother.setJerkLimits(Velocity2D(jerk_lim_vx, jerk_lim_vy, jerk_lim_w));
+      smoothed = jerk_smoother.update(now, target, feedback_ptr);
+    }
+    else
+    {
+      if (accel_smoother.output() != last_cmd)
+        accel_smoother.reset(last_cmd);
+      accel_smoother.setPeriod(period);
+      accel_smoother.setLimits(accel_lim, decel_lim);
+      smoothed = accel_smoother.update(now, target, feedback_ptr);
+    }
 
-      if (std::abs(w_inc) > max_w_inc)
-      {
-        // we must limit angular velocity
-        cmd_vel->angular.z = last_cmd_vel.angular.z + sign(w_inc)*max_w_inc;
-      }
+    // Publish while approaching the target velocity, afterwards keep resending last command while input is active
+    if ((target != last_cmd) || (input_active == true))
+    {
+      geometry_msgs::TwistPtr cmd_vel(new geometry_msgs::Twist());
+      cmd_vel->linear.x  = smoothed.x;
+      cmd_vel->linear.y  = smoothed.y;
+      cmd_vel->angular.z = smoothed.theta;
 
       smooth_vel_pub.publish(cmd_vel);
       last_cmd_vel = *cmd_vel;
     }
-    else if (input_active == true)
-    {
-      // We already reached target velocity; just keep resending last command while input is active
-      cmd_vel.reset(new geometry_msgs::Twist(last_cmd_vel));
-      smooth_vel_pub.publish(cmd_vel);
-    }
 
     spin_rate.sleep();
   }
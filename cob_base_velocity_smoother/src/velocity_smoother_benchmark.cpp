@@ -0,0 +1,412 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_driver
+ * ROS package name: cob_base_velocity_smoother
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+//
+// Replay benchmark of the smoothing strategies in velocity_smoothing.h.
+// A recorded command stream is fed to each strategy the way the nodes call them and the
+// added latency (time shift that best aligns output and input), the remaining tracking error,
+// the peak acceleration/jerk of the output and the CPU time per update are reported.
+// Beforehand, TrimmedMeanBuffer is checked against the plain trimmed mean on random streams,
+// the program returns 1 on a mismatch.
+//
+// usage: velocity_smoother_benchmark [commands.csv] [rate]
+//   commands.csv: output of "rostopic echo -p /cmd_vel" (time in ns, linear.x/y, angular.z),
+//                 a synthetic teleoperation stream is used if omitted
+//   rate:         loop rate of the smoothers in Hz (default 30)
+//
+#include <cob_base_velocity_smoother/velocity_smoothing.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cob_base_velocity_smoother;
+
+namespace
+{
+
+struct Command
+{
+  double stamp;
+  Velocity2D vel;
+};
+
+bool loadCommands(const char* file, std::vector<Command>& commands)
+{
+  std::ifstream in(file);
+  if (!in)
+    return false;
+
+  // %time,field.linear.x,field.linear.y,field.linear.z,field.angular.x,field.angular.y,field.angular.z
+  std::string line;
+  while (std::getline(in, line))
+  {
+    if (line.empty() || line[0] == '%')
+      continue;
+    std::vector<double> fields;
+    std::stringstream ss(line);
+    std::string field;
+    while (std::getline(ss, field, ','))
+      fields.push_back(std::atof(field.c_str()));
+    if (fields.size() < 7)
+      continue;
+
+    Command c;
+    c.stamp = fields[0]*1e-9;
+    c.vel = Velocity2D(fields[1], fields[2], fields[6]);
+    commands.push_back(c);
+  }
+
+  for (size_t i = 0; i < commands.size(); i++)
+    commands[i].stamp -= commands.front().stamp;
+  return !commands.empty();
+}
+
+// teleoperation like stream at 10 Hz: held set points, ramps, full stops and short dropouts
+void syntheticCommands(std::vector<Command>& commands)
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  std::normal_distribution<double> noise(0.0, 0.01);
+
+  Velocity2D set_point;
+  double next_change = 0.0;
+  for (double t = 0.0; t < 120.0; t += 0.1)
+  {
+    if (t >= next_change)
+    {
+      int kind = rng() % 4;
+      if (kind == 0)
+        set_point = Velocity2D();
+      else
+        set_point = Velocity2D(0.6*uniform(rng), 0.3*uniform(rng), 1.0*uniform(rng));
+      next_change = t + 1.0 + 3.0*std::abs(uniform(rng));
+    }
+    if (std::fmod(t, 30.0) > 29.0)
+      continue;  // dropout
+
+    Command c;
+    c.stamp = t;
+    c.vel = set_point.isZero() ? set_point :
+        Velocity2D(set_point.x + noise(rng), set_point.y + noise(rng), set_point.theta + noise(rng));
+    commands.push_back(c);
+  }
+}
+
+struct Trace
+{
+  std::vector<Velocity2D> input, output;
+  double cpu_ns;
+};
+
+// calls a strategy like the nodes do: once per loop period with the latest command
+template <typename Step>
+Trace replay(const std::vector<Command>& commands, double rate, Step step)
+{
+  Trace trace;
+  const double period = 1.0/rate;
+  const double end = commands.back().stamp + 2.0;
+  size_t next = 0;
+  Velocity2D latest, output;
+  double last_received = -1.0;
+  double cpu = 0.0;
+
+  for (double now = 0.0; now < end; now += period)
+  {
+    bool received = false;
+    while (next < commands.size() && commands[next].stamp <= now)
+    {
+      latest = commands[next++].vel;
+      last_received = now;
+      received = true;
+    }
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    output = step(now, latest, received, now - last_received);
+    cpu += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+
+    trace.input.push_back(latest);
+    trace.output.push_back(output);
+  }
+  trace.cpu_ns = cpu/trace.output.size();
+  return trace;
+}
+
+double axis(const Velocity2D& v, int i)
+{
+  return i == 0 ? v.x : (i == 1 ? v.y : v.theta);
+}
+
+void report(const char* name, const Trace& trace, double rate)
+{
+  const size_t n = trace.output.size();
+  const double period = 1.0/rate;
+
+  // latency: shift of the input that best matches the output
+  size_t best_lag = 0;
+  double best_error = 1e300;
+  for (size_t lag = 0; lag < std::min(n, static_cast<size_t>(3.0*rate)); lag++)
+  {
+    double error = 0.0;
+    for (size_t k = lag; k < n; k++)
+      for (int i = 0; i < 3; i++)
+      {
+        double d = axis(trace.output[k], i) - axis(trace.input[k - lag], i);
+        error += d*d;
+      }
+    error /= (n - lag);
+    if (error < best_error)
+    {
+      best_error = error;
+      best_lag = lag;
+    }
+  }
+
+  double max_acc = 0.0, max_jerk = 0.0;
+  for (size_t k = 2; k < n; k++)
+    for (int i = 0; i < 3; i++)
+    {
+      double a1 = (axis(trace.output[k], i) - axis(trace.output[k - 1], i))/period;
+      double a0 = (axis(trace.output[k - 1], i) - axis(trace.output[k - 2], i))/period;
+      max_acc = std::max(max_acc, std::abs(a1));
+      max_jerk = std::max(max_jerk, std::abs(a1 - a0)/period);
+    }
+
+  printf("%-20s latency %6.0f ms  rms error %.4f  max acc %7.2f  max jerk %8.1f  cpu %7.1f ns/update\n",
+         name, best_lag*period*1000.0, std::sqrt(best_error), max_acc, max_jerk, trace.cpu_ns);
+}
+
+struct StampedValues
+{
+  double stamp;
+  double values[TrimmedMeanBuffer::NUM_AXES];
+};
+
+// mean without the element farthest from the mean, as computed by the original cob_base_velocity_smoother
+double plainTrimmedMean(const std::deque<StampedValues>& buffer, int axis)
+{
+  const size_t size = buffer.size();
+  if (size == 0)
+    return 0.0;
+
+  double result = 0.0;
+  for (size_t i = 0; i < size; i++)
+    result += buffer[i].values[axis];
+  result /= size;
+  if (size == 1)
+    return result;
+
+  double max = buffer[0].values[axis];
+  size_t max_ind = 0;
+  for (size_t i = 0; i < size; i++)
+  {
+    if (std::abs(result - buffer[i].values[axis]) > std::abs(result - max))
+    {
+      max = buffer[i].values[axis];
+      max_ind = i;
+    }
+  }
+
+  double help_result = 0.0;
+  for (size_t i = 0; i < size; i++)
+  {
+    if (i != max_ind)
+      help_result += buffer[i].values[axis];
+  }
+  return help_result/(size - 1);
+}
+
+// feeds random streams with held values, zero runs, quantized values (ties) and gaps to TrimmedMeanBuffer
+// and to a plain buffer, returns the number of results that differ by more than rounding
+size_t checkTrimmedMean()
+{
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  size_t evaluations = 0, mismatches = 0;
+  double max_deviation = 0.0;
+
+  for (int trial = 0; trial < 200; trial++)
+  {
+    const size_t capacity = 1 + rng() % 300;
+    const double max_age = 0.05 + (rng() % 100)/20.0;
+    TrimmedMeanBuffer buffer(capacity);
+    std::deque<StampedValues> plain;
+    double now = 0.0;
+
+    for (int k = 0; k < 3000; k++)
+    {
+      now += (rng() % 10 == 0) ? (rng() % 100)/10.0 : 1.0/30.0;
+      buffer.eraseOutdated(now, max_age);
+      while (!plain.empty() && now - plain.back().stamp >= max_age)
+        plain.pop_back();
+
+      StampedValues v = { now, { 0.0, 0.0, 0.0 } };
+      size_t count = 1;
+      const int kind = rng() % 6;
+      if (kind == 0)
+      {
+        count = plain.empty() ? capacity : 1 + plain.size()/3;
+      }
+      else if (kind == 1)
+      {
+        v.values[0] = 0.5;
+        v.values[1] = -0.25;
+        v.values[2] = 0.125;
+      }
+      else
+      {
+        for (int i = 0; i < TrimmedMeanBuffer::NUM_AXES; i++)
+          v.values[i] = (kind == 2 || i == 2) ? std::round(10.0*uniform(rng))/10.0 : uniform(rng);
+      }
+
+      buffer.pushFront(v.values[0], v.values[1], v.values[2], now, count);
+      for (size_t i = 0; i < std::min(count, capacity); i++)
+      {
+        plain.push_front(v);
+        if (plain.size() > capacity)
+          plain.pop_back();
+      }
+
+      for (int i = 0; i < TrimmedMeanBuffer::NUM_AXES; i++)
+      {
+        const double deviation = std::abs(buffer.trimmedMean(static_cast<TrimmedMeanBuffer::Axis>(i))
+                                          - plainTrimmedMean(plain, i));
+        max_deviation = std::max(max_deviation, deviation);
+        if (buffer.size() != plain.size() || deviation > 1e-12)
+          mismatches++;
+        evaluations++;
+      }
+    }
+  }
+
+  printf("trimmed mean check: %zu evaluations, max deviation %g %s\n", evaluations, max_deviation,
+         mismatches == 0 ? "ok" : "MISMATCH");
+  return mismatches;
+}
+
+// limits of config/standalone.yaml
+const Velocity2D ACCEL_LIM(0.3, 0.3, 3.5);
+const Velocity2D JERK_LIM(3.0, 3.0, 30.0);
+
+struct BufferMeanStep
+{
+  BufferMeanSmoother* smoother;
+  double max_delay;  // 1/min_input_rate
+  Velocity2D output;
+
+  Velocity2D operator()(double now, const Velocity2D& cmd, bool received, double age)
+  {
+    // see BufferedVelocitySmoother::calculationStep(); the output is held between updates
+    if (received || cmd.isZero())
+      output = smoother->update(now, cmd);
+    else if (age > max_delay)
+      smoother->update(now, Velocity2D());
+    return output;
+  }
+};
+
+template <typename Smoother>
+struct RateLimitedStep
+{
+  Smoother* smoother;
+
+  Velocity2D operator()(double now, const Velocity2D& cmd, bool /*received*/, double age)
+  {
+    // see VelocitySmoother::spin(); targets are zeroed when the input gets inactive
+    return smoother->update(now, age > 0.5 ? Velocity2D() : cmd);
+  }
+};
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  const size_t mismatches = checkTrimmedMean();
+
+  std::vector<Command> commands;
+  if (argc > 1)
+  {
+    if (!loadCommands(argv[1], commands))
+    {
+      fprintf(stderr, "could not read commands from %s\n", argv[1]);
+      return 1;
+    }
+  }
+  else
+  {
+    syntheticCommands(commands);
+  }
+  double rate = (argc > 2) ? std::atof(argv[2]) : 30.0;
+
+  printf("%zu commands over %.1f s, smoothers at %.0f Hz\n", commands.size(), commands.back().stamp, rate);
+
+  // nodes' defaults
+  BufferMeanSmoother buffer_mean;
+  buffer_mean.configure(12, 4.0, 0.3);
+  buffer_mean.reset(0.0);
+  BufferMeanStep buffer_step = { &buffer_mean, 1.0/9.0, Velocity2D() };
+  report("buffer mean", replay(commands, rate, buffer_step), rate);
+
+  AccelLimitSmoother accel_limit;
+  accel_limit.setPeriod(1.0/rate);
+  accel_limit.setLimits(ACCEL_LIM, ACCEL_LIM);
+  RateLimitedStep<AccelLimitSmoother> accel_step = { &accel_limit };
+  report("acceleration limit", replay(commands, rate, accel_step), rate);
+
+  JerkLimitSmoother jerk_limit;
+  jerk_limit.setPeriod(1.0/rate);
+  jerk_limit.setLimits(ACCEL_LIM, ACCEL_LIM);
+  jerk_limit.setJerkLimits(JERK_LIM);
+  RateLimitedStep<JerkLimitSmoother> jerk_step = { &jerk_limit };
+  report("jerk limit", replay(commands, rate, jerk_step), rate);
+
+  return mismatches == 0 ? 0 : 1;
+}
@@ -34,11 +34,13 @@
 #include <vector>
 #include <string>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
 
 #include <ros/ros.h>
 #include <tf/transform_listener.h>
 #include <tf/transform_broadcaster.h>
 #include <tf/transform_datatypes.h>
+#include <geometry_msgs/TwistStamped.h>
 
 #include <actionlib/server/simple_action_server.h>
 #include <cob_cartesian_controller/CartesianControllerAction.h>
@@ -46,6 +48,8 @@
 #include <cob_cartesian_controller/trajectory_interpolator/trajectory_interpolator.h>
 #include <cob_cartesian_controller/cartesian_controller_data_types.h>
 #include <cob_cartesian_controller/cartesian_controller_utils.h>
+#include <cob_cartesian_controller/setpoint_buffer.h>
+#include <cob_frame_tracker/se3_tracking_controller.h>
 
 typedef actionlib::SimpleActionServer<cob_cartesian_controller::CartesianControllerAction> SAS_CartesianControllerAction_t;
 
@@ -58,6 +62,8 @@ public:
 
     // Main functions
     bool posePathBroadcaster(const geometry_msgs::PoseArray& cartesian_path);
+    bool posePathBroadcaster(const TrajectoryEvaluator& evaluator);
+    bool posePathStreamer(const cob_cartesian_controller::CartesianActionStruct& action_struct);
 
     // Helper function
     bool startTracking();
@@ -73,8 +79,13 @@ public:
     cob_cartesian_controller::CartesianActionStruct acceptGoal(boost::shared_ptr<const cob_cartesian_controller::CartesianControllerGoal> goal);
     cob_cartesian_controller::MoveLinStruct convertMoveLin(const cob_cartesian_controller::MoveLin& move_lin_msg);
     cob_cartesian_controller::MoveCircStruct convertMoveCirc(const cob_cartesian_controller::MoveCirc& move_circ_msg);
+    cob_cartesian_controller::MoveSegmentStruct convertMoveSegment(const cob_cartesian_controller::MoveSegment& move_segment_msg);
 
 private:
+    /// Streaming mode
+    void interpolationThread();
+    void publishStreamingTwist(const KDL::Twist& twist);
+
     ros::NodeHandle nh_;
     tf::TransformListener tf_listener_;
     tf::TransformBroadcaster tf_broadcaster_;
@@ -94,6 +105,16 @@ private:
 
     CartesianControllerUtils utils_;
     boost::shared_ptr< TrajectoryInterpolator > trajectory_interpolator_;
+    TrajectoryEvaluator evaluator_;
+
+    /// Streaming mode: setpoints are sent as twist commands to the twist_controller directly instead of via tf and frame_tracker
+    bool streaming_;
+    int streaming_buffer_size_;
+    ros::Publisher twist_pub_;
+    SE3TrackingController streaming_controller_;
+    cob_cartesian_controller::SetpointBuffer setpoint_buffer_;
+    boost::thread interpolation_thread_;
+    double t_ipo_;
 };
 
 #endif  // COB_CARTESIAN_CONTROLLER_CARTESIAN_CONTROLLER_H
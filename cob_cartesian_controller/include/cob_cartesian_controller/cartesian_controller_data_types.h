@@ -63,11 +63,21 @@ struct MoveCircStruct
     double radius;
 };
 
+struct MoveSegmentStruct
+{
+    unsigned int move_type;
+    MoveLinStruct move_lin;     // start is given by the previous segment
+    MoveCircStruct move_circ;
+    double blend_radius;
+};
+
 struct CartesianActionStruct
 {
     unsigned int move_type;
     MoveLinStruct move_lin;
     MoveCircStruct move_circ;
+    std::vector<MoveSegmentStruct> move_sequence;
+    geometry_msgs::Pose sequence_start;
     ProfileStruct profile;
 };
 
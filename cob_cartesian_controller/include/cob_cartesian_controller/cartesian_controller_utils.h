@@ -56,6 +56,7 @@ public:
     void poseToRPY(const geometry_msgs::Pose& pose, double& roll, double& pitch, double& yaw);
 
     void previewPath(const geometry_msgs::PoseArray pose_array);
+    bool hasPreviewSubscribers() const { return marker_pub_.getNumSubscribers() > 0; }
 
     void adjustArrayLength(std::vector<cob_cartesian_controller::PathArray>& m);
     void copyMatrix(std::vector<double>* path_array, std::vector<cob_cartesian_controller::PathArray>& m);
@@ -0,0 +1,144 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Bounded ring buffer passing interpolated setpoints from the interpolation thread to the streaming loop.
+ *
+ ****************************************************************/
+
+#ifndef COB_CARTESIAN_CONTROLLER_SETPOINT_BUFFER_H
+#define COB_CARTESIAN_CONTROLLER_SETPOINT_BUFFER_H
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <kdl/frames.hpp>
+
+namespace cob_cartesian_controller
+{
+
+struct Setpoint
+{
+    double time;        // time from the start of the path [s]
+    KDL::Frame pose;    // pose in root_frame
+    KDL::Twist twist;   // body twist of the setpoint frame
+};
+
+/**
+ * Single producer, single consumer.
+ * The producer blocks while the buffer is full, the consumer never blocks.
+ * The producer closes the buffer when it is done, the consumer aborts it to stop the producer.
+ */
+class SetpointBuffer
+{
+public:
+    SetpointBuffer()
+    :   head_(0), size_(0), closed_(false), aborted_(false), success_(false)
+    {}
+
+    void reset(size_t capacity)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        ring_.resize(capacity);
+        head_ = size_ = 0;
+        closed_ = aborted_ = success_ = false;
+    }
+
+    /// returns false if the consumer aborted
+    bool push(const Setpoint& setpoint)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (size_ == ring_.size() && !aborted_)
+        {
+            not_full_.wait(lock);
+        }
+        if (aborted_)
+        {
+            return false;
+        }
+        ring_[(head_ + size_) % ring_.size()] = setpoint;
+        ++size_;
+        return true;
+    }
+
+    /// producer is done, success is false if the interpolation failed
+    void close(bool success)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        closed_ = true;
+        success_ = success;
+    }
+
+    void abort()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        aborted_ = true;
+        not_full_.notify_all();
+    }
+
+    /// pops all setpoints up to time, setpoint is the latest of them; returns false if none was due
+    bool popUntil(double time, Setpoint& setpoint)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        bool popped = false;
+        while (size_ > 0 && ring_[head_].time <= time)
+        {
+            setpoint = ring_[head_];
+            head_ = (head_ + 1) % ring_.size();
+            --size_;
+            popped = true;
+        }
+        if (popped)
+        {
+            not_full_.notify_one();
+        }
+        return popped;
+    }
+
+    size_t size()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        return size_;
+    }
+
+    /// all setpoints were consumed and the producer is done
+    bool finished(bool& success)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        success = success_;
+        return closed_ && size_ == 0;
+    }
+
+    bool closed()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        return closed_;
+    }
+
+private:
+    std::vector<Setpoint> ring_;
+    size_t head_, size_;
+    bool closed_, aborted_, success_;
+
+    boost::mutex mutex_;
+    boost::condition_variable not_full_;
+};
+
+}  // namespace cob_cartesian_controller
+
+#endif  // COB_CARTESIAN_CONTROLLER_SETPOINT_BUFFER_H
@@ -0,0 +1,87 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Geometric path of a sequence of LIN and CIRC segments with blended corners.
+ *
+ ****************************************************************/
+
+#ifndef COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_BLENDED_PATH_H
+#define COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_BLENDED_PATH_H
+
+#include <vector>
+#include <geometry_msgs/Pose.h>
+#include <tf/transform_datatypes.h>
+
+#include <cob_cartesian_controller/cartesian_controller_data_types.h>
+
+/**
+ * The path is parameterized by sigma, which advances with the translational distance on the whole path, so the
+ * Cartesian speed is kept across the junctions; the orientation follows the geometry (e.g. it turns with v / radius
+ * on arcs). Pieces that only rotate advance with the rotation angle.
+ * Corners are cut at blend_radius before and after the junction and replaced by a cubic Hermite curve
+ * which is tangent to both segments. Unblended corners split the path into runs, which have to be
+ * executed with a stop in between.
+ */
+class BlendedPath
+{
+public:
+    /// start is the pose the first segment starts from, gaps before CIRC segments are bridged by straight lines
+    bool build(const std::vector<cob_cartesian_controller::MoveSegmentStruct>& segments, const geometry_msgs::Pose& start);
+
+    double getLength() const { return length_; }
+
+    /// sigma values at which the path has to stop (unblended corners), including 0 and getLength()
+    const std::vector<double>& getStops() const { return stops_; }
+
+    void getPose(double sigma, tf::Transform& pose) const;
+
+    /// derivative of the pose with respect to sigma: linear and angular velocity in root frame
+    void getDerivative(double sigma, tf::Vector3& linear, tf::Vector3& angular) const;
+
+private:
+    struct Piece
+    {
+        enum Type { LINE, ARC, BLEND } type;
+        double u_begin, u_end;              // trimmed range of the local parameter 0..1
+        double sigma_begin, sigma_length;
+
+        tf::Vector3 p0, p1, m0, m1;         // LINE: end points, BLEND: Hermite end points and tangents
+        tf::Quaternion q0, q1;              // LINE, BLEND: orientation at u = 0, 1
+
+        tf::Transform center;               // ARC
+        double radius, start_angle, direction, angle;
+
+        std::vector<double> arc_table;      // BLEND: arc length at equidistant u
+        double blend_radius;                // radius for the junction to the next piece
+        bool stop_after;                    // unblended corner to the next piece
+    };
+
+    void getLocalPose(const Piece& piece, double u, tf::Transform& pose) const;
+    tf::Vector3 getLocalTangent(const Piece& piece, double u) const;
+    double getTranslationLength(const Piece& piece) const;   // untrimmed
+    double getRotationLength(const Piece& piece) const;      // untrimmed
+    Piece makeBlend(const Piece& in, const Piece& out) const;
+    bool isSmooth(const Piece& in, const Piece& out) const;
+
+    std::vector<Piece> pieces_;
+    std::vector<double> stops_;
+    double length_;
+};
+
+#endif  // COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_BLENDED_PATH_H
@@ -0,0 +1,100 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Evaluates the linear, circular and blended sequence Cartesian paths at arbitrary times from the closed-form velocity profile.
+ *
+ ****************************************************************/
+
+#ifndef COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_TRAJECTORY_EVALUATOR_H
+#define COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_TRAJECTORY_EVALUATOR_H
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/Twist.h>
+#include <tf/transform_datatypes.h>
+
+#include <cob_cartesian_controller/cartesian_controller_data_types.h>
+#include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_base.h>
+#include <cob_cartesian_controller/trajectory_interpolator/blended_path.h>
+
+/**
+ * Nothing is sampled in advance: pose and twist are computed in O(1) (SEQUENCE: O(log n) in the number of segments)
+ * for any time 0 <= t <= getDuration().
+ * The twist is expressed in the root frame (linear velocity of the pose origin, angular velocity).
+ */
+class TrajectoryEvaluator : private boost::noncopyable
+{
+public:
+    TrajectoryEvaluator()
+    :   duration_(0.0)
+    {}
+
+    /// prepares the evaluation of a LIN, CIRC or SEQUENCE goal, returns false if no profile is available
+    bool setGoal(const cob_cartesian_controller::CartesianActionStruct& as);
+
+    double getDuration() const { return duration_; }
+
+    void getPose(double t, geometry_msgs::Pose& pose) const;
+    void getTwist(double t, geometry_msgs::Twist& twist) const;
+
+private:
+    bool setLinear();
+    bool setCircular();
+    bool setSequence();
+
+    /// SEQUENCE: path parameter and its rate at time t
+    double getSigma(double t, double& rate) const;
+
+    /// normalized progress 0..1 of a path and its derivative
+    double getProgress(double t, const cob_cartesian_controller::ProfileTimings& pt, double se, double end) const;
+    double getProgressRate(double t, const cob_cartesian_controller::ProfileTimings& pt, double se, double end) const;
+
+    cob_cartesian_controller::CartesianActionStruct as_;  // referenced by profile_
+    boost::shared_ptr<TrajectoryProfileBase> profile_;
+    double duration_;
+
+    /// LIN: position and orientation move synchronized, each with its own profile
+    tf::Vector3 p_start_, p_end_;
+    tf::Quaternion q_start_, q_end_;
+    tf::Vector3 rot_axis_;      // in root frame
+    double rot_angle_;
+    double se_lin_, se_rot_, se_path_;
+    double end_lin_, end_path_;
+    bool moving_lin_, moving_path_;
+    cob_cartesian_controller::ProfileTimings pt_lin_, pt_path_;
+
+    /// CIRC
+    tf::Transform center_;
+    double direction_;
+
+    /// SEQUENCE: one profile per run between the stops of the path, velocity is kept across blended corners
+    struct Run
+    {
+        double sigma_begin, sigma_length;
+        double t_begin, end;
+        bool moving;
+        cob_cartesian_controller::ProfileTimings pt;
+    };
+    BlendedPath path_;
+    std::vector<Run> runs_;
+};
+
+#endif  // COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_TRAJECTORY_EVALUATOR_H
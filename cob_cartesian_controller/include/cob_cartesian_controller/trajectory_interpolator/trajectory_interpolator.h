@@ -30,34 +30,42 @@
 #define COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_TRAJECTORY_INTERPOLATOR_H
 
 #include <string>
+#include <boost/function.hpp>
 #include <ros/ros.h>
 #include <geometry_msgs/PoseArray.h>
 #include <tf/transform_datatypes.h>
 
 #include <cob_cartesian_controller/cartesian_controller_data_types.h>
-#include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_builder.h>
+#include <cob_cartesian_controller/trajectory_interpolator/trajectory_evaluator.h>
 
 class TrajectoryInterpolator
 {
 public:
+    /// receives the interpolated poses one by one, returning false stops the interpolation
+    typedef boost::function<bool (const geometry_msgs::Pose&)> PoseCallback;
+
     TrajectoryInterpolator(std::string root_frame, double update_rate)
     :   root_frame_(root_frame)
     {}
 
-    ~TrajectoryInterpolator()
-    {
-        trajectory_profile_generator_.reset();
-    }
-
     bool linearInterpolation(geometry_msgs::PoseArray& pose_array,
                              const cob_cartesian_controller::CartesianActionStruct as);
 
     bool circularInterpolation(geometry_msgs::PoseArray& pose_array,
                                const cob_cartesian_controller::CartesianActionStruct as);
 
+    bool linearInterpolation(const PoseCallback& callback,
+                             const cob_cartesian_controller::CartesianActionStruct as);
+
+    bool circularInterpolation(const PoseCallback& callback,
+                               const cob_cartesian_controller::CartesianActionStruct as);
+
+    /// samples an evaluated path with the interpolation period t_ipo
+    bool sample(const TrajectoryEvaluator& evaluator, const double t_ipo, geometry_msgs::PoseArray& pose_array);
+    bool sample(const TrajectoryEvaluator& evaluator, const double t_ipo, const PoseCallback& callback);
+
 private:
     std::string root_frame_;
-    boost::shared_ptr<TrajectoryProfileBase> trajectory_profile_generator_;
 };
 
 #endif  // COB_CARTESIAN_CONTROLLER_TRAJECTORY_INTERPOLATOR_TRAJECTORY_INTERPOLATOR_H
@@ -77,6 +77,22 @@ public:
         return true;
     }
 
+    /// Closed-form alternative to calculateProfile:
+    /// timings of a path of length Se synchronized to the longest path Se_max, false if the path is too short to move
+    bool getSynchronizedTimings(const double Se_max, const double Se, cob_cartesian_controller::ProfileTimings& pt)
+    {
+        cob_cartesian_controller::ProfileTimings pt_max;
+        if (!getProfileTimings(Se_max, 0, true, pt_max))
+        {
+            return false;
+        }
+        return getProfileTimings(Se, pt_max.te, false, pt);
+    }
+
+    /// position and velocity of the profile at time t (0 <= t <= pt.te), same as the samples of getTrajectory
+    virtual double getPosition(double t, double se, const cob_cartesian_controller::ProfileTimings& pt) = 0;
+    virtual double getVelocity(double t, double se, const cob_cartesian_controller::ProfileTimings& pt) = 0;
+
 protected:
     virtual bool generatePath(cob_cartesian_controller::PathArray& pa)
     {
@@ -45,6 +45,8 @@ public:
 
     virtual bool getProfileTimings(double Se, double te, bool calcMaxTe, cob_cartesian_controller::ProfileTimings& pt);
     virtual std::vector<double> getTrajectory(double se, cob_cartesian_controller::ProfileTimings pt);
+    virtual double getPosition(double t, double se, const cob_cartesian_controller::ProfileTimings& pt);
+    virtual double getVelocity(double t, double se, const cob_cartesian_controller::ProfileTimings& pt);
 };
 /* END TrajectoryProfileSinoid **********************************************************************************************/
 
@@ -31,12 +31,15 @@
 #include <math.h>
 #include <algorithm>
 #include <string>
+#include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
 
 #include <ros/ros.h>
 #include <std_srvs/Trigger.h>
 #include <cob_srvs/SetString.h>
 
+#include <kdl_conversions/kdl_msg.h>
+
 #include <cob_cartesian_controller/cartesian_controller.h>
 
 bool CartesianController::initialize()
@@ -67,6 +70,32 @@ bool CartesianController::initialize()
         target_frame_ = DEFAULT_CARTESIAN_TARGET;
     }
 
+    nh_private.param("streaming", streaming_, false);
+    if (streaming_)
+    {
+        SE3TrackingController::Gains gains;
+        double max_vel_lin, max_vel_rot;
+        ros::NodeHandle nh_streaming(nh_private, "streaming_controller");
+        nh_streaming.param("p_gain_lin", gains.p_lin, 4.0);
+        nh_streaming.param("i_gain_lin", gains.i_lin, 0.0);
+        nh_streaming.param("i_clamp_lin", gains.i_clamp_lin, 0.1);
+        nh_streaming.param("p_gain_rot", gains.p_rot, 4.0);
+        nh_streaming.param("i_gain_rot", gains.i_rot, 0.0);
+        nh_streaming.param("i_clamp_rot", gains.i_clamp_rot, 0.1);
+        nh_streaming.param("max_vel_lin", max_vel_lin, 0.5);  // m/sec
+        nh_streaming.param("max_vel_rot", max_vel_rot, 0.5);  // rad/sec
+        nh_streaming.param("buffer_size", streaming_buffer_size_, static_cast<int>(update_rate_));  // 1 sec lookahead
+        streaming_controller_.setGains(gains);
+        streaming_controller_.setLimits(max_vel_lin, max_vel_rot);
+        if (streaming_buffer_size_ < 2)
+        {
+            streaming_buffer_size_ = 2;
+        }
+
+        twist_pub_ = nh_.advertise<geometry_msgs::TwistStamped>("twist_controller/command_twist_stamped", 1);
+        ROS_INFO("Streaming setpoints to twist_controller, frame_tracker is not used");
+    }
+
     ROS_WARN("Waiting for Services...");
     start_tracking_ = nh_.serviceClient<cob_srvs::SetString>("frame_tracker/start_tracking");
     stop_tracking_ = nh_.serviceClient<std_srvs::Trigger>("frame_tracker/stop");
@@ -182,93 +211,239 @@ bool CartesianController::posePathBroadcaster(const geometry_msgs::PoseArray& ca
     return success;
 }
 
+// Broadcasting Cartesian path evaluated at the current time
+bool CartesianController::posePathBroadcaster(const TrajectoryEvaluator& evaluator)
+{
+    bool success = true;
+    ros::Rate rate(update_rate_);
+    tf::Transform transform;
+    geometry_msgs::Pose pose;
+    ros::Time start = ros::Time::now();
+    bool done = false;
 
-void CartesianController::goalCallback()
+    while (!done)
+    {
+        if (!as_->isActive())
+        {
+            success = false;
+            break;
+        }
+
+        // the end pose is sent once after the duration passed
+        ros::Time now = ros::Time::now();
+        double t = (now - start).toSec();
+        done = (t >= evaluator.getDuration());
+        evaluator.getPose(std::min(t, evaluator.getDuration()), pose);
+
+        // Send/Refresh target Frame
+        tf::poseMsgToTF(pose, transform);
+        tf_broadcaster_.sendTransform(tf::StampedTransform(transform, now, root_frame_, target_frame_));
+
+        ros::spinOnce();
+        rate.sleep();
+    }
+
+    return success;
+}
+
+// Producer of the streaming mode: samples the path into the setpoint buffer
+void CartesianController::interpolationThread()
 {
-    geometry_msgs::PoseArray cartesian_path;
-    cob_cartesian_controller::CartesianActionStruct action_struct;
+    bool success = true;
+    const double duration = evaluator_.getDuration();
+    unsigned int steps = std::max(1.0, ceil(duration / t_ipo_ - 1e-9));
+    geometry_msgs::Pose pose;
+    geometry_msgs::Twist twist;
+    KDL::Twist kdl_twist;
 
-    action_struct = acceptGoal(as_->acceptNewGoal());
+    for (unsigned int i = 0; i <= steps && success; i++)
+    {
+        cob_cartesian_controller::Setpoint setpoint;
+        setpoint.time = std::min(i * t_ipo_, duration);
+        evaluator_.getPose(setpoint.time, pose);
+        evaluator_.getTwist(setpoint.time, twist);
+
+        // the twist of the evaluator is expressed in the root frame
+        tf::poseMsgToKDL(pose, setpoint.pose);
+        tf::twistMsgToKDL(twist, kdl_twist);
+        setpoint.twist = setpoint.pose.M.Inverse() * kdl_twist;
+        success = setpoint_buffer_.push(setpoint);
+    }
+    setpoint_buffer_.close(success);
+}
 
-    if (action_struct.move_type == cob_cartesian_controller::CartesianControllerGoal::LIN)
+void CartesianController::publishStreamingTwist(const KDL::Twist& twist)
+{
+    geometry_msgs::TwistStamped twist_msg;
+    twist_msg.header.frame_id = chain_tip_link_;
+    twist_msg.header.stamp = ros::Time::now();
+    tf::twistKDLToMsg(twist, twist_msg.twist);
+    twist_pub_.publish(twist_msg);
+}
+
+// Streaming the path evaluated by evaluator_ directly to the twist_controller
+// Execution starts as soon as the first setpoints are sampled, each cycle the setpoint due is tracked
+// by the SE(3) controller with the setpoint twist as feed-forward.
+bool CartesianController::posePathStreamer(const cob_cartesian_controller::CartesianActionStruct& action_struct)
+{
+    t_ipo_ = action_struct.profile.t_ipo;
+    setpoint_buffer_.reset(streaming_buffer_size_);
+    streaming_controller_.reset();
+
+    interpolation_thread_ = boost::thread(&CartesianController::interpolationThread, this);
+
+    // wait for the first setpoints
+    while (setpoint_buffer_.size() < 2 && !setpoint_buffer_.closed() && ros::ok())
     {
-        // Interpolate path
-        if (!trajectory_interpolator_->linearInterpolation(cartesian_path, action_struct))
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+
+    bool success = true;
+    bool have_setpoint = false;
+    cob_cartesian_controller::Setpoint setpoint;
+    ros::Rate rate(update_rate_);
+    ros::Time start = ros::Time::now();
+    ros::Time last = start;
+
+    while (ros::ok())
+    {
+        if (!as_->isActive())
         {
-            actionAbort(false, "Failed to do interpolation for 'move_lin'");
-            return;
+            success = false;
+            break;
         }
 
-        // Publish Preview
-        utils_.previewPath(cartesian_path);
-        
-        // initially broadcast target_frame
-        tf::Transform identity = tf::Transform();
-        identity.setIdentity();
-        tf_broadcaster_.sendTransform(tf::StampedTransform(identity, ros::Time::now(), chain_tip_link_, target_frame_));
-
-        // Activate Tracking
-        if (!startTracking())
+        ros::Time now = ros::Time::now();
+        if (setpoint_buffer_.popUntil((now - start).toSec(), setpoint))
         {
-            actionAbort(false, "Failed to start tracking");
-            return;
+            have_setpoint = true;
         }
-
-        // Execute path
-        if (!posePathBroadcaster(cartesian_path))
+        else if (setpoint_buffer_.finished(success))
         {
-            actionAbort(false, "Failed to execute path for 'move_lin'");
-            return;
+            break;
+        }
+        else if (have_setpoint)
+        {
+            // interpolation fell behind: hold the last setpoint
+            setpoint.twist = KDL::Twist::Zero();
+            ROS_WARN_THROTTLE(1, "Setpoint buffer underrun");
         }
 
-        // De-Activate Tracking
-        if (!stopTracking())
+        if (have_setpoint)
         {
-            actionAbort(false, "Failed to stop tracking");
-            return;
+            tf::StampedTransform tip_tf;
+            try
+            {
+                tf_listener_.lookupTransform(root_frame_, chain_tip_link_, ros::Time(0), tip_tf);
+
+                geometry_msgs::Pose tip_pose;
+                KDL::Frame tip;
+                tf::poseTFToMsg(tip_tf, tip_pose);
+                tf::poseMsgToKDL(tip_pose, tip);
+
+                // setpoint in the tip frame, the feed-forward is transformed accordingly
+                KDL::Frame error = tip.Inverse() * setpoint.pose;
+                publishStreamingTwist(streaming_controller_.computeCommand(error, error * setpoint.twist, (now - last).toSec()));
+            }
+            catch (tf::TransformException& ex)
+            {
+                ROS_ERROR_THROTTLE(1, "CartesianController::posePathStreamer: \n%s", ex.what());
+                publishStreamingTwist(KDL::Twist::Zero());
+            }
         }
+        last = now;
 
-        actionSuccess(true, "move_lin succeeded!");
+        ros::spinOnce();
+        rate.sleep();
+    }
+
+    setpoint_buffer_.abort();
+    interpolation_thread_.join();
+    publishStreamingTwist(KDL::Twist::Zero());
+
+    return success;
+}
+
+
+void CartesianController::goalCallback()
+{
+    cob_cartesian_controller::CartesianActionStruct action_struct;
+
+    action_struct = acceptGoal(as_->acceptNewGoal());
+
+    std::string move_name;
+    if (action_struct.move_type == cob_cartesian_controller::CartesianControllerGoal::LIN)
+    {
+        move_name = "move_lin";
     }
     else if (action_struct.move_type == cob_cartesian_controller::CartesianControllerGoal::CIRC)
     {
-        if (!trajectory_interpolator_->circularInterpolation(cartesian_path, action_struct))
-        {
-            actionAbort(false, "Failed to do interpolation for 'move_circ'");
-            return;
-        }
+        move_name = "move_circ";
+    }
+    else if (action_struct.move_type == cob_cartesian_controller::CartesianControllerGoal::SEQUENCE)
+    {
+        move_name = "move_sequence";
+    }
+    else
+    {
+        actionAbort(false, "Unknown trajectory action");
+        return;
+    }
+
+    // Prepare the evaluation of the path
+    if (!evaluator_.setGoal(action_struct))
+    {
+        actionAbort(false, "Failed to do interpolation for '" + move_name + "'");
+        return;
+    }
 
-        // Publish Preview
+    // Publish Preview, only sampled if there is a subscriber
+    if (utils_.hasPreviewSubscribers())
+    {
+        geometry_msgs::PoseArray cartesian_path;
+        trajectory_interpolator_->sample(evaluator_, action_struct.profile.t_ipo, cartesian_path);
         utils_.previewPath(cartesian_path);
+    }
 
-        // Activate Tracking
-        if (!startTracking())
+    if (streaming_)
+    {
+        if (!posePathStreamer(action_struct))
         {
-            actionAbort(false, "Failed to start tracking");
+            actionAbort(false, "Failed to stream path for '" + move_name + "'");
             return;
         }
 
-        // Execute path
-        if (!posePathBroadcaster(cartesian_path))
-        {
-            actionAbort(false, "Failed to execute path for 'move_circ'");
-            return;
-        }
+        actionSuccess(true, move_name + " succeeded!");
+        return;
+    }
 
-        // De-Activate Tracking
-        if (!stopTracking())
-        {
-            actionAbort(false, "Failed to stop tracking");
-            return;
-        }
+    // initially broadcast target_frame
+    tf::Transform identity = tf::Transform();
+    identity.setIdentity();
+    tf_broadcaster_.sendTransform(tf::StampedTransform(identity, ros::Time::now(), chain_tip_link_, target_frame_));
 
-        actionSuccess(true, "move_circ succeeded!");
+    // Activate Tracking
+    if (!startTracking())
+    {
+        actionAbort(false, "Failed to start tracking");
+        return;
     }
-    else
+
+    // Execute path
+    if (!posePathBroadcaster(evaluator_))
     {
-        actionAbort(false, "Unknown trajectory action");
+        actionAbort(false, "Failed to execute path for '" + move_name + "'");
         return;
     }
+
+    // De-Activate Tracking
+    if (!stopTracking())
+    {
+        actionAbort(false, "Failed to stop tracking");
+        return;
+    }
+
+    actionSuccess(true, move_name + " succeeded!");
 }
 
 cob_cartesian_controller::MoveLinStruct CartesianController::convertMoveLin(const cob_cartesian_controller::MoveLin& move_lin_msg)
@@ -300,6 +475,25 @@ cob_cartesian_controller::MoveCircStruct CartesianController::convertMoveCirc(co
     return move_circ;
 }
 
+cob_cartesian_controller::MoveSegmentStruct CartesianController::convertMoveSegment(const cob_cartesian_controller::MoveSegment& move_segment_msg)
+{
+    cob_cartesian_controller::MoveSegmentStruct move_segment;
+    move_segment.move_type = move_segment_msg.move_type;
+    move_segment.blend_radius = move_segment_msg.blend_radius;
+
+    if (move_segment.move_type == cob_cartesian_controller::MoveSegment::LIN)
+    {
+        // the start is the end of the previous segment
+        utils_.transformPose(move_segment_msg.move_lin.frame_id, root_frame_, move_segment_msg.move_lin.pose_goal, move_segment.move_lin.end);
+    }
+    else if (move_segment.move_type == cob_cartesian_controller::MoveSegment::CIRC)
+    {
+        move_segment.move_circ = convertMoveCirc(move_segment_msg.move_circ);
+    }
+
+    return move_segment;
+}
+
 cob_cartesian_controller::CartesianActionStruct CartesianController::acceptGoal(boost::shared_ptr<const cob_cartesian_controller::CartesianControllerGoal> goal)
 {
     cob_cartesian_controller::CartesianActionStruct action_struct;
@@ -319,6 +513,14 @@ cob_cartesian_controller::CartesianActionStruct CartesianController::acceptGoal(
     {
         action_struct.move_circ = convertMoveCirc(goal->move_circ);
     }
+    else if (action_struct.move_type == cob_cartesian_controller::CartesianControllerGoal::SEQUENCE)
+    {
+        action_struct.sequence_start = utils_.getPose(root_frame_, chain_tip_link_);   // current tcp pose
+        for (unsigned int i = 0; i < goal->move_sequence.size(); i++)
+        {
+            action_struct.move_sequence.push_back(convertMoveSegment(goal->move_sequence[i]));
+        }
+    }
     else
     {
         actionAbort(false, "Unknown trajectory action " + boost::lexical_cast<std::string>(action_struct.move_type));
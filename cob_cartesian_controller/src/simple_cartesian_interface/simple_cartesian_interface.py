@@ -6,7 +6,7 @@ import actionlib
 from tf.transformations import *
 from geometry_msgs.msg import Pose
 from cob_cartesian_controller.msg import CartesianControllerAction, CartesianControllerGoal
-from cob_cartesian_controller.msg import Profile
+from cob_cartesian_controller.msg import Profile, MoveSegment
 
 
 def move_lin(pose_goal, frame_id, profile):
@@ -60,6 +60,29 @@ def move_circ(pose_center, frame_id, start_angle, end_angle, radius, profile):
     result = client.get_result()
     return (result.success, result.message)
 
+def move_sequence(segments, profile):
+    action_name = rospy.get_namespace()+'cartesian_trajectory_action'
+    client = actionlib.SimpleActionClient(action_name, CartesianControllerAction)
+    rospy.logwarn("Waiting for ActionServer: %s", action_name)
+    success = client.wait_for_server(rospy.Duration(2.0))
+    if(not success):
+        return (success, "ActionServer not available within timeout")
+
+    goal = CartesianControllerGoal()
+    goal.move_type = CartesianControllerGoal.SEQUENCE
+    goal.move_sequence = segments
+    goal.profile = profile
+    # print goal
+
+    client.send_goal(goal)
+    print "goal sent"
+    state = client.get_state()
+    # print state
+    client.wait_for_result()
+    print "result received"
+    result = client.get_result()
+    return (result.success, result.message)
+
 
 
 ####################################
@@ -77,3 +100,29 @@ def gen_pose(pos=[0,0,0], rpy=[0,0,0]):
 
 
     return pose
+
+
+'''
+Generates a LIN segment for move_sequence, blend_radius rounds the corner to the next segment
+'''
+def gen_lin_segment(pose_goal, frame_id, blend_radius=0.0):
+    segment = MoveSegment()
+    segment.move_type = MoveSegment.LIN
+    segment.move_lin.pose_goal = pose_goal
+    segment.move_lin.frame_id = frame_id
+    segment.blend_radius = blend_radius
+    return segment
+
+'''
+Generates a CIRC segment for move_sequence, blend_radius rounds the corner to the next segment
+'''
+def gen_circ_segment(pose_center, frame_id, start_angle, end_angle, radius, blend_radius=0.0):
+    segment = MoveSegment()
+    segment.move_type = MoveSegment.CIRC
+    segment.move_circ.pose_center = pose_center
+    segment.move_circ.frame_id = frame_id
+    segment.move_circ.start_angle = start_angle
+    segment.move_circ.end_angle = end_angle
+    segment.move_circ.radius = radius
+    segment.blend_radius = blend_radius
+    return segment
@@ -0,0 +1,351 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Geometric path of a sequence of LIN and CIRC segments with blended corners.
+ *
+ ****************************************************************/
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+#include <ros/ros.h>
+
+#include <cob_cartesian_controller/MoveSegment.h>
+#include <cob_cartesian_controller/trajectory_interpolator/blended_path.h>
+
+#define BLEND_TABLE_SIZE 32
+#define POSITION_EPSILON 1e-4       // m
+#define ANGLE_EPSILON 1e-3          // rad
+#define DERIVATIVE_STEP 1e-6
+
+bool BlendedPath::build(const std::vector<cob_cartesian_controller::MoveSegmentStruct>& segments, const geometry_msgs::Pose& start)
+{
+    std::vector<Piece> raw;
+    tf::Transform current;
+    tf::poseMsgToTF(start, current);
+
+    pieces_.clear();
+    stops_.clear();
+    length_ = 0.0;
+
+    for (unsigned int i = 0; i < segments.size(); i++)
+    {
+        const cob_cartesian_controller::MoveSegmentStruct& segment = segments[i];
+        Piece piece;
+        piece.u_begin = 0.0;
+        piece.u_end = 1.0;
+        piece.blend_radius = std::max(segment.blend_radius, 0.0);
+        piece.stop_after = false;
+
+        if (segment.move_type == cob_cartesian_controller::MoveSegment::LIN)
+        {
+            piece.type = Piece::LINE;
+            piece.p0 = current.getOrigin();
+            piece.q0 = current.getRotation();
+            tf::pointMsgToTF(segment.move_lin.end.position, piece.p1);
+            tf::quaternionMsgToTF(segment.move_lin.end.orientation, piece.q1);
+        }
+        else if (segment.move_type == cob_cartesian_controller::MoveSegment::CIRC)
+        {
+            tf::Quaternion q;
+            tf::quaternionMsgToTF(segment.move_circ.pose_center.orientation, q);
+            piece.type = Piece::ARC;
+            piece.center = tf::Transform(q, tf::Vector3(segment.move_circ.pose_center.position.x,
+                                                         segment.move_circ.pose_center.position.y,
+                                                         segment.move_circ.pose_center.position.z));
+            piece.radius = segment.move_circ.radius;
+            piece.start_angle = segment.move_circ.start_angle;
+            piece.direction = (segment.move_circ.end_angle < segment.move_circ.start_angle) ? -1.0 : 1.0;
+            piece.angle = std::fabs(segment.move_circ.end_angle - segment.move_circ.start_angle);
+
+            // bridge the gap to the start of the circle
+            tf::Transform arc_start;
+            getLocalPose(piece, 0.0, arc_start);
+            if (arc_start.getOrigin().distance(current.getOrigin()) > POSITION_EPSILON ||
+                arc_start.getRotation().angleShortestPath(current.getRotation()) > ANGLE_EPSILON)
+            {
+                Piece bridge;
+                bridge.type = Piece::LINE;
+                bridge.u_begin = 0.0;
+                bridge.u_end = 1.0;
+                bridge.p0 = current.getOrigin();
+                bridge.q0 = current.getRotation();
+                bridge.p1 = arc_start.getOrigin();
+                bridge.q1 = arc_start.getRotation();
+                bridge.blend_radius = raw.empty() ? 0.0 : std::min(raw.back().blend_radius, piece.blend_radius);
+                bridge.stop_after = false;
+                raw.push_back(bridge);
+            }
+        }
+        else
+        {
+            ROS_ERROR_STREAM("BlendedPath: unknown move_type " << segment.move_type << " of segment " << i);
+            return false;
+        }
+
+        if (getTranslationLength(piece) < POSITION_EPSILON && getRotationLength(piece) < ANGLE_EPSILON)
+        {
+            continue;  // nothing to move
+        }
+        raw.push_back(piece);
+        getLocalPose(piece, 1.0, current);
+    }
+
+    if (raw.empty())
+    {
+        return false;
+    }
+
+    // cut the corners
+    for (unsigned int i = 0; i < raw.size(); i++)
+    {
+        pieces_.push_back(raw[i]);
+        if (i + 1 == raw.size())
+        {
+            break;
+        }
+
+        Piece& in = pieces_.back();
+        Piece& out = raw[i + 1];
+        double length_in = getTranslationLength(in);
+        double length_out = getTranslationLength(out);
+        double d = std::min(in.blend_radius, std::min(length_in * (in.u_end - in.u_begin), length_out) / 2.0);
+
+        if (d > POSITION_EPSILON)
+        {
+            in.u_end -= d / length_in;
+            out.u_begin += d / length_out;
+            Piece blend = makeBlend(in, out);
+            pieces_.push_back(blend);
+        }
+        else
+        {
+            in.stop_after = !isSmooth(in, out);
+        }
+    }
+
+    // parameterize
+    stops_.push_back(0.0);
+    std::vector<Piece> parameterized;
+    for (unsigned int i = 0; i < pieces_.size(); i++)
+    {
+        Piece& piece = pieces_[i];
+        double trans, rot;
+        if (piece.type == Piece::BLEND)
+        {
+            trans = piece.arc_table.back();
+            rot = piece.q0.angleShortestPath(piece.q1);
+        }
+        else
+        {
+            trans = getTranslationLength(piece) * (piece.u_end - piece.u_begin);
+            rot = getRotationLength(piece) * (piece.u_end - piece.u_begin);
+        }
+
+        // the same metric on all pieces keeps the Cartesian speed across the junctions,
+        // pieces without translation advance with their rotation
+        piece.sigma_begin = length_;
+        piece.sigma_length = (trans > POSITION_EPSILON) ? trans : rot;
+        if (piece.sigma_length > 0.0)
+        {
+            length_ += piece.sigma_length;
+            parameterized.push_back(piece);
+        }
+        if (piece.stop_after && stops_.back() < length_)
+        {
+            stops_.push_back(length_);
+        }
+    }
+    pieces_.swap(parameterized);
+    if (stops_.back() < length_)
+    {
+        stops_.push_back(length_);
+    }
+
+    return !pieces_.empty();
+}
+
+void BlendedPath::getPose(double sigma, tf::Transform& pose) const
+{
+    // last piece starting before sigma
+    unsigned int lo = 0, hi = pieces_.size();
+    while (hi - lo > 1)
+    {
+        unsigned int mid = (lo + hi) / 2;
+        if (pieces_[mid].sigma_begin <= sigma)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    const Piece& piece = pieces_[lo];
+    double frac = std::min(std::max((sigma - piece.sigma_begin) / piece.sigma_length, 0.0), 1.0);
+
+    if (piece.type != Piece::BLEND)
+    {
+        getLocalPose(piece, piece.u_begin + frac * (piece.u_end - piece.u_begin), pose);
+        return;
+    }
+
+    // position by arc length, orientation by fraction
+    double s = frac * piece.arc_table.back();
+    unsigned int k = std::upper_bound(piece.arc_table.begin(), piece.arc_table.end(), s) - piece.arc_table.begin();
+    k = std::min(std::max(k, 1u), static_cast<unsigned int>(BLEND_TABLE_SIZE)) - 1;
+    double ds = piece.arc_table[k + 1] - piece.arc_table[k];
+    double u = (k + ((ds > 0.0) ? (s - piece.arc_table[k]) / ds : 0.0)) / BLEND_TABLE_SIZE;
+
+    getLocalPose(piece, u, pose);
+    pose.setRotation(piece.q0.slerp(piece.q1, frac));
+}
+
+void BlendedPath::getDerivative(double sigma, tf::Vector3& linear, tf::Vector3& angular) const
+{
+    double sigma_a = std::max(sigma - DERIVATIVE_STEP, 0.0);
+    double sigma_b = std::min(sigma + DERIVATIVE_STEP, length_);
+    linear.setZero();
+    angular.setZero();
+    if (sigma_b <= sigma_a)
+    {
+        return;
+    }
+
+    tf::Transform a, b;
+    getPose(sigma_a, a);
+    getPose(sigma_b, b);
+    linear = (b.getOrigin() - a.getOrigin()) / (sigma_b - sigma_a);
+
+    tf::Quaternion q_rel = a.getRotation().inverse() * b.getRotation();
+    if (q_rel.w() < 0)
+    {
+        q_rel = -q_rel;
+    }
+    double angle = q_rel.getAngle();
+    if (angle > 0.0)
+    {
+        angular = tf::quatRotate(a.getRotation(), q_rel.getAxis()) * (angle / (sigma_b - sigma_a));
+    }
+}
+
+void BlendedPath::getLocalPose(const Piece& piece, double u, tf::Transform& pose) const
+{
+    if (piece.type == Piece::ARC)
+    {
+        double a = u * piece.angle;
+        double phi = piece.start_angle + piece.direction * a;
+        tf::Quaternion q;
+        q.setRPY(0, -piece.direction * a, 0);
+        pose = piece.center * tf::Transform(q, tf::Vector3(cos(phi) * piece.radius, 0, sin(phi) * piece.radius));
+    }
+    else if (piece.type == Piece::LINE)
+    {
+        pose.setOrigin(piece.p0.lerp(piece.p1, u));
+        pose.setRotation(piece.q0.slerp(piece.q1, u));
+    }
+    else
+    {
+        double u2 = u * u, u3 = u2 * u;
+        pose.setOrigin(piece.p0 * (2*u3 - 3*u2 + 1) + piece.m0 * (u3 - 2*u2 + u) + piece.p1 * (-2*u3 + 3*u2) + piece.m1 * (u3 - u2));
+        pose.setRotation(piece.q0.slerp(piece.q1, u));
+    }
+}
+
+tf::Vector3 BlendedPath::getLocalTangent(const Piece& piece, double u) const
+{
+    if (piece.type == Piece::ARC)
+    {
+        double phi = piece.start_angle + piece.direction * u * piece.angle;
+        return piece.center.getBasis() * tf::Vector3(-sin(phi), 0, cos(phi)) * (piece.radius * piece.direction * piece.angle);
+    }
+    if (piece.type == Piece::LINE)
+    {
+        return piece.p1 - piece.p0;
+    }
+    double u2 = u * u;
+    return piece.p0 * (6*u2 - 6*u) + piece.m0 * (3*u2 - 4*u + 1) + piece.p1 * (-6*u2 + 6*u) + piece.m1 * (3*u2 - 2*u);
+}
+
+double BlendedPath::getTranslationLength(const Piece& piece) const
+{
+    if (piece.type == Piece::ARC)
+    {
+        return piece.radius * piece.angle;
+    }
+    if (piece.type == Piece::LINE)
+    {
+        return piece.p0.distance(piece.p1);
+    }
+    return piece.arc_table.back();
+}
+
+double BlendedPath::getRotationLength(const Piece& piece) const
+{
+    if (piece.type == Piece::ARC)
+    {
+        return piece.angle;
+    }
+    return piece.q0.angleShortestPath(piece.q1);
+}
+
+BlendedPath::Piece BlendedPath::makeBlend(const Piece& in, const Piece& out) const
+{
+    tf::Transform a, b;
+    getLocalPose(in, in.u_end, a);
+    getLocalPose(out, out.u_begin, b);
+
+    Piece blend;
+    blend.type = Piece::BLEND;
+    blend.u_begin = 0.0;
+    blend.u_end = 1.0;
+    blend.blend_radius = 0.0;
+    blend.stop_after = false;
+    blend.p0 = a.getOrigin();
+    blend.p1 = b.getOrigin();
+    blend.q0 = a.getRotation();
+    blend.q1 = b.getRotation();
+
+    double chord = blend.p0.distance(blend.p1);
+    blend.m0 = getLocalTangent(in, in.u_end).normalized() * chord;
+    blend.m1 = getLocalTangent(out, out.u_begin).normalized() * chord;
+
+    blend.arc_table.resize(BLEND_TABLE_SIZE + 1);
+    blend.arc_table[0] = 0.0;
+    tf::Transform last = a, next;
+    for (unsigned int k = 1; k <= BLEND_TABLE_SIZE; k++)
+    {
+        getLocalPose(blend, static_cast<double>(k) / BLEND_TABLE_SIZE, next);
+        blend.arc_table[k] = blend.arc_table[k - 1] + next.getOrigin().distance(last.getOrigin());
+        last = next;
+    }
+    return blend;
+}
+
+/// tangent continuous junction, which can be passed without a stop
+bool BlendedPath::isSmooth(const Piece& in, const Piece& out) const
+{
+    tf::Vector3 t_in = getLocalTangent(in, in.u_end);
+    tf::Vector3 t_out = getLocalTangent(out, out.u_begin);
+    if (t_in.length() < POSITION_EPSILON || t_out.length() < POSITION_EPSILON)
+    {
+        return false;
+    }
+    return t_in.angle(t_out) < ANGLE_EPSILON * 10;
+}
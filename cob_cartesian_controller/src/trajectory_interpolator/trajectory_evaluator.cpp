@@ -0,0 +1,264 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Evaluates the linear, circular and blended sequence Cartesian paths at arbitrary times from the closed-form velocity profile.
+ *
+ ****************************************************************/
+
+#include <math.h>
+#include <algorithm>
+
+#include <cob_cartesian_controller/CartesianControllerAction.h>
+#include <cob_cartesian_controller/trajectory_interpolator/trajectory_evaluator.h>
+#include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_builder.h>
+
+bool TrajectoryEvaluator::setGoal(const cob_cartesian_controller::CartesianActionStruct& as)
+{
+    as_ = as;
+    duration_ = 0.0;
+    moving_path_ = false;
+    profile_.reset(TrajectoryProfileBuilder::createProfile(as_));
+    if (!profile_)
+    {
+        return false;
+    }
+
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::LIN)
+    {
+        return setLinear();
+    }
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::CIRC)
+    {
+        return setCircular();
+    }
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::SEQUENCE)
+    {
+        return setSequence();
+    }
+    return false;
+}
+
+bool TrajectoryEvaluator::setLinear()
+{
+    tf::pointMsgToTF(as_.move_lin.start.position, p_start_);
+    tf::pointMsgToTF(as_.move_lin.end.position, p_end_);
+    tf::quaternionMsgToTF(as_.move_lin.start.orientation, q_start_);
+    tf::quaternionMsgToTF(as_.move_lin.end.orientation, q_end_);
+
+    se_lin_ = p_start_.distance(p_end_);
+    se_rot_ = q_start_.angleShortestPath(q_end_);
+
+    // rotation axis of the slerp (shortest path) in root frame
+    tf::Quaternion q_rel = q_start_.inverse() * q_end_;
+    if (q_rel.w() < 0)
+    {
+        q_rel = -q_rel;
+    }
+    rot_angle_ = q_rel.getAngle();
+    rot_axis_ = (rot_angle_ > 0) ? tf::quatRotate(q_start_, q_rel.getAxis()) : tf::Vector3(0, 0, 0);
+
+    double se_max = std::max(se_lin_, se_rot_);
+    cob_cartesian_controller::ProfileTimings pt_rot;
+    moving_lin_ = profile_->getSynchronizedTimings(se_max, se_lin_, pt_lin_);
+    bool moving_rot = profile_->getSynchronizedTimings(se_max, se_rot_, pt_rot);
+
+    end_lin_ = moving_lin_ ? profile_->getPosition(pt_lin_.te, se_lin_, pt_lin_) : 0.0;
+    double end_rot = moving_rot ? profile_->getPosition(pt_rot.te, se_rot_, pt_rot) : 0.0;
+
+    // the orientation follows the profile which covers the larger distance
+    if (fabs(end_lin_) > fabs(end_rot))
+    {
+        moving_path_ = moving_lin_;
+        pt_path_ = pt_lin_;
+        se_path_ = se_lin_;
+        end_path_ = end_lin_;
+    }
+    else
+    {
+        moving_path_ = moving_rot;
+        pt_path_ = pt_rot;
+        se_path_ = se_rot_;
+        end_path_ = end_rot;
+    }
+
+    if (moving_lin_)
+    {
+        duration_ = std::max(duration_, pt_lin_.te);
+    }
+    if (moving_rot)
+    {
+        duration_ = std::max(duration_, pt_rot.te);
+    }
+    return true;
+}
+
+bool TrajectoryEvaluator::setCircular()
+{
+    tf::Quaternion q;
+    tf::quaternionMsgToTF(as_.move_circ.pose_center.orientation, q);
+    center_.setOrigin(tf::Vector3(as_.move_circ.pose_center.position.x,
+                                  as_.move_circ.pose_center.position.y,
+                                  as_.move_circ.pose_center.position.z));
+    center_.setRotation(q);
+
+    double Se = as_.move_circ.end_angle - as_.move_circ.start_angle;
+    direction_ = (Se < 0) ? -1.0 : 1.0;  // circle direction
+    se_path_ = std::fabs(Se);
+
+    moving_path_ = profile_->getSynchronizedTimings(se_path_, se_path_, pt_path_);
+    if (moving_path_)
+    {
+        end_path_ = profile_->getPosition(pt_path_.te, se_path_, pt_path_);
+        duration_ = pt_path_.te;
+    }
+    return true;
+}
+
+bool TrajectoryEvaluator::setSequence()
+{
+    runs_.clear();
+    if (!path_.build(as_.move_sequence, as_.sequence_start))
+    {
+        return false;
+    }
+
+    const std::vector<double>& stops = path_.getStops();
+    for (unsigned int i = 0; i + 1 < stops.size(); i++)
+    {
+        Run run;
+        run.sigma_begin = stops[i];
+        run.sigma_length = stops[i + 1] - stops[i];
+        run.t_begin = duration_;
+        run.moving = profile_->getSynchronizedTimings(run.sigma_length, run.sigma_length, run.pt);
+        run.end = run.moving ? profile_->getPosition(run.pt.te, run.sigma_length, run.pt) : 0.0;
+        if (run.moving)
+        {
+            duration_ += run.pt.te;
+        }
+        runs_.push_back(run);
+    }
+    return true;
+}
+
+double TrajectoryEvaluator::getSigma(double t, double& rate) const
+{
+    // last run starting before t
+    unsigned int lo = 0, hi = runs_.size();
+    while (hi - lo > 1)
+    {
+        unsigned int mid = (lo + hi) / 2;
+        if (runs_[mid].t_begin <= t)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    const Run& run = runs_[lo];
+
+    if (!run.moving)
+    {
+        rate = 0.0;
+        return run.sigma_begin + run.sigma_length;
+    }
+    rate = run.sigma_length * profile_->getVelocity(t - run.t_begin, run.sigma_length, run.pt) / run.end;
+    return run.sigma_begin + run.sigma_length * profile_->getPosition(t - run.t_begin, run.sigma_length, run.pt) / run.end;
+}
+
+double TrajectoryEvaluator::getProgress(double t, const cob_cartesian_controller::ProfileTimings& pt, double se, double end) const
+{
+    return profile_->getPosition(t, se, pt) / end;
+}
+
+double TrajectoryEvaluator::getProgressRate(double t, const cob_cartesian_controller::ProfileTimings& pt, double se, double end) const
+{
+    return profile_->getVelocity(t, se, pt) / end;
+}
+
+void TrajectoryEvaluator::getPose(double t, geometry_msgs::Pose& pose) const
+{
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::SEQUENCE)
+    {
+        double rate;
+        tf::Transform transform;
+        path_.getPose(getSigma(t, rate), transform);
+        tf::poseTFToMsg(transform, pose);
+        return;
+    }
+
+    double s_path = moving_path_ ? getProgress(t, pt_path_, se_path_, end_path_) : 1.0;
+
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::LIN)
+    {
+        double s_lin = moving_lin_ ? getProgress(t, pt_lin_, se_lin_, end_lin_) : 1.0;
+        tf::pointTFToMsg(p_start_.lerp(p_end_, s_lin), pose.position);
+        tf::quaternionTFToMsg(q_start_.slerp(q_end_, s_path), pose.orientation);
+    }
+    else
+    {
+        double angle = s_path * se_path_;
+        double phi = as_.move_circ.start_angle + direction_ * angle;
+
+        tf::Transform T;
+        tf::Quaternion q;
+        T.setOrigin(tf::Vector3(cos(phi) * as_.move_circ.radius, 0, sin(phi) * as_.move_circ.radius));
+        q.setRPY(0, -direction_ * angle, 0);
+        T.setRotation(q);
+
+        // Calculate TCP Position
+        tf::Transform P = center_ * T;
+        tf::pointTFToMsg(P.getOrigin(), pose.position);
+        tf::quaternionTFToMsg(P.getRotation(), pose.orientation);
+    }
+}
+
+void TrajectoryEvaluator::getTwist(double t, geometry_msgs::Twist& twist) const
+{
+    tf::Vector3 vel(0, 0, 0), rot(0, 0, 0);
+
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::SEQUENCE)
+    {
+        double rate;
+        path_.getDerivative(getSigma(t, rate), vel, rot);
+        tf::vector3TFToMsg(vel * rate, twist.linear);
+        tf::vector3TFToMsg(rot * rate, twist.angular);
+        return;
+    }
+    double ds_path = moving_path_ ? getProgressRate(t, pt_path_, se_path_, end_path_) : 0.0;
+
+    if (as_.move_type == cob_cartesian_controller::CartesianControllerGoal::LIN)
+    {
+        double ds_lin = moving_lin_ ? getProgressRate(t, pt_lin_, se_lin_, end_lin_) : 0.0;
+        vel = (p_end_ - p_start_) * ds_lin;
+        rot = rot_axis_ * (rot_angle_ * ds_path);
+    }
+    else
+    {
+        double phi = as_.move_circ.start_angle + direction_ * (moving_path_ ? getProgress(t, pt_path_, se_path_, end_path_) : 1.0) * se_path_;
+        double dphi = direction_ * ds_path * se_path_;
+
+        vel = center_.getBasis() * tf::Vector3(-sin(phi), 0, cos(phi)) * (as_.move_circ.radius * dphi);
+        rot = center_.getBasis() * tf::Vector3(0, -dphi, 0);
+    }
+
+    tf::vector3TFToMsg(vel, twist.linear);
+    tf::vector3TFToMsg(rot, twist.angular);
+}
@@ -27,143 +27,86 @@
  ****************************************************************/
 
 #include <math.h>
-#include <vector>
+#include <algorithm>
+#include <boost/bind.hpp>
 
+#include <cob_cartesian_controller/CartesianControllerAction.h>
 #include <cob_cartesian_controller/trajectory_interpolator/trajectory_interpolator.h>
-#include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_builder.h>
+
+namespace
+{
+bool appendPose(geometry_msgs::PoseArray& pose_array, const geometry_msgs::Pose& pose)
+{
+    pose_array.poses.push_back(pose);
+    return true;
+}
+}  // namespace
 
 bool TrajectoryInterpolator::linearInterpolation(geometry_msgs::PoseArray& pose_array,
                                                  const cob_cartesian_controller::CartesianActionStruct as)
 {
-    this->trajectory_profile_generator_.reset(TrajectoryProfileBuilder::createProfile(as));
-
     pose_array.header.stamp = ros::Time::now();
     pose_array.header.frame_id = root_frame_;
 
-    tf::Quaternion q_start, q_end;
-
-    std::vector<double> linear_path, angular_path, path;
-    std::vector<double> path_matrix[2];
-    geometry_msgs::Pose pose;
-
-    double norm_factor;
-    tf::quaternionMsgToTF(as.move_lin.start.orientation, q_start);
-    tf::quaternionMsgToTF(as.move_lin.end.orientation, q_end);
+    return linearInterpolation(boost::bind(&appendPose, boost::ref(pose_array), _1), as);
+}
 
-    double Se_lin = sqrt(pow((as.move_lin.end.position.x - as.move_lin.start.position.x), 2) +
-                         pow((as.move_lin.end.position.y - as.move_lin.start.position.y), 2) +
-                         pow((as.move_lin.end.position.z - as.move_lin.start.position.z), 2));
+bool TrajectoryInterpolator::circularInterpolation(geometry_msgs::PoseArray& pose_array,
+                                                   const cob_cartesian_controller::CartesianActionStruct as)
+{
+    pose_array.header.stamp = ros::Time::now();
+    pose_array.header.frame_id = root_frame_;
 
-    double Se_rot = q_start.angleShortestPath(q_end);
+    return circularInterpolation(boost::bind(&appendPose, boost::ref(pose_array), _1), as);
+}
 
-    if (!trajectory_profile_generator_->calculateProfile(path_matrix, Se_lin, Se_rot))
+bool TrajectoryInterpolator::linearInterpolation(const PoseCallback& callback,
+                                                 const cob_cartesian_controller::CartesianActionStruct as)
+{
+    TrajectoryEvaluator evaluator;
+    cob_cartesian_controller::CartesianActionStruct goal = as;
+    goal.move_type = cob_cartesian_controller::CartesianControllerGoal::LIN;
+    if (!evaluator.setGoal(goal))
     {
         return false;
     }
+    return sample(evaluator, as.profile.t_ipo, callback);
+}
 
-    linear_path  = path_matrix[0];
-    angular_path = path_matrix[1];
-
-    if (fabs(linear_path.back()) > fabs(angular_path.back()))
-    {
-        path = linear_path;
-    }
-    else
-    {
-        path = angular_path;
-    }
-    norm_factor = 1/path.back();
-
-    // Interpolate the linear path
-    for (unsigned int i = 0; i < linear_path.size(); i++)
+bool TrajectoryInterpolator::circularInterpolation(const PoseCallback& callback,
+                                                   const cob_cartesian_controller::CartesianActionStruct as)
+{
+    TrajectoryEvaluator evaluator;
+    cob_cartesian_controller::CartesianActionStruct goal = as;
+    goal.move_type = cob_cartesian_controller::CartesianControllerGoal::CIRC;
+    if (!evaluator.setGoal(goal))
     {
-        if (linear_path.back() == 0)
-        {
-            pose.position.x = as.move_lin.start.position.x;
-            pose.position.y = as.move_lin.start.position.y;
-            pose.position.z = as.move_lin.start.position.z;
-        }
-        else
-        {
-            pose.position.x = as.move_lin.start.position.x + linear_path.at(i) * (as.move_lin.end.position.x - as.move_lin.start.position.x) / linear_path.back();
-            pose.position.y = as.move_lin.start.position.y + linear_path.at(i) * (as.move_lin.end.position.y - as.move_lin.start.position.y) / linear_path.back();
-            pose.position.z = as.move_lin.start.position.z + linear_path.at(i) * (as.move_lin.end.position.z - as.move_lin.start.position.z) / linear_path.back();
-        }
-
-        tf::quaternionTFToMsg(q_start.slerp(q_end, path.at(i) * norm_factor), pose.orientation);
-        pose_array.poses.push_back(pose);
+        return false;
     }
-    return true;
+    return sample(evaluator, as.profile.t_ipo, callback);
 }
 
-bool TrajectoryInterpolator::circularInterpolation(geometry_msgs::PoseArray& pose_array,
-                                                   const cob_cartesian_controller::CartesianActionStruct as)
+bool TrajectoryInterpolator::sample(const TrajectoryEvaluator& evaluator, const double t_ipo, geometry_msgs::PoseArray& pose_array)
 {
-     pose_array.header.stamp = ros::Time::now();
-     pose_array.header.frame_id = root_frame_;
-
-     tf::Quaternion q;
-     tf::Transform C, P, T;
-
-     std::vector<double> path_array;
-     std::vector<double> path_matrix[2];
-
-     geometry_msgs::Pose pose;
-
-     double Se = as.move_circ.end_angle - as.move_circ.start_angle;
-
-     bool forward;
-
-     // Needed for the circle direction!
-     if (Se < 0)
-     {
-         forward = false;
-     }
-     else
-     {
-         forward = true;
-     }
-     Se = std::fabs(Se);
-
-     // Calculates the Path with RAMP or SINOID profile
-     if (!this->trajectory_profile_generator_->calculateProfile(path_matrix, Se, 0))
-     {
-         return false;
-     }
-
-     path_array = path_matrix[0];
-     // Define Center Pose
-     C.setOrigin(tf::Vector3(as.move_circ.pose_center.position.x, as.move_circ.pose_center.position.y, as.move_circ.pose_center.position.z));
-     tf::quaternionMsgToTF(as.move_circ.pose_center.orientation, q);
-     C.setRotation(q);
-
-     // Interpolate the circular path
-     for (unsigned int i = 0; i < path_array.size(); i++)
-     {
-         // Rotate T
-         T.setOrigin(tf::Vector3(cos(path_array.at(i)) * as.move_circ.radius, 0, sin(path_array.at(i)) * as.move_circ.radius));
-
-         if (forward)
-         {
-             T.setOrigin(tf::Vector3(cos(path_array.at(i)) * as.move_circ.radius, 0, sin(path_array.at(i)) * as.move_circ.radius));
-             q.setRPY(0, -path_array.at(i), 0);
-         }
-         else
-         {
-             T.setOrigin(tf::Vector3(cos(as.move_circ.start_angle - path_array.at(i)) * as.move_circ.radius, 0, sin(as.move_circ.start_angle - path_array.at(i)) * as.move_circ.radius));
-             q.setRPY(0, path_array.at(i), 0);
-         }
-
-         T.setRotation(q);
-
-         // Calculate TCP Position
-         P = C * T;
+    pose_array.header.stamp = ros::Time::now();
+    pose_array.header.frame_id = root_frame_;
 
-         tf::pointTFToMsg(P.getOrigin(), pose.position);
-         tf::quaternionTFToMsg(P.getRotation(), pose.orientation);
+    return sample(evaluator, t_ipo, boost::bind(&appendPose, boost::ref(pose_array), _1));
+}
 
-         pose_array.poses.push_back(pose);
-     }
+// Samples every t_ipo, the last sample is the end of the path
+bool TrajectoryInterpolator::sample(const TrajectoryEvaluator& evaluator, const double t_ipo, const PoseCallback& callback)
+{
+    geometry_msgs::Pose pose;
+    unsigned int steps = std::max(1.0, ceil(evaluator.getDuration() / t_ipo - 1e-9));
 
+    for (unsigned int i = 1; i <= steps; i++)
+    {
+        evaluator.getPose(std::min(i * t_ipo, evaluator.getDuration()), pose);
+        if (!callback(pose))
+        {
+            return false;
+        }
+    }
     return true;
 }
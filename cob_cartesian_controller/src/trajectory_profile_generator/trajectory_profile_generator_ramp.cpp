@@ -27,6 +27,7 @@
  ****************************************************************/
 
 #include <vector>
+#include <algorithm>
 #include <ros/ros.h>
 #include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_ramp.h>
 
@@ -96,4 +97,41 @@ std::vector<double> TrajectoryProfileRamp::getTrajectory(double se, cob_cartesia
 
     return array;
 }
+
+double TrajectoryProfileRamp::getPosition(double t, double se, const cob_cartesian_controller::ProfileTimings& pt)
+{
+    double direction = se/std::fabs(se);
+    double accl = params_.profile.accl;
+    t = std::min(std::max(t, 0.0), pt.te);
+
+    if (t <= pt.tb)
+    {
+        return direction * (0.5*accl*pow(t, 2));
+    }
+    if (t <= pt.tv)
+    {
+        return direction * (pt.vel*t - 0.5*pow(pt.vel, 2)/accl);
+    }
+    return direction * (pt.vel * pt.tv - 0.5 * accl * pow(pt.te-t, 2));
+}
+
+double TrajectoryProfileRamp::getVelocity(double t, double se, const cob_cartesian_controller::ProfileTimings& pt)
+{
+    double direction = se/std::fabs(se);
+    double accl = params_.profile.accl;
+
+    if (t <= 0 || t >= pt.te)
+    {
+        return 0.0;
+    }
+    if (t <= pt.tb)
+    {
+        return direction * accl*t;
+    }
+    if (t <= pt.tv)
+    {
+        return direction * pt.vel;
+    }
+    return direction * accl * (pt.te-t);
+}
 /* END TrajectoryProfileRamp **********************************************************************************************/
@@ -27,6 +27,7 @@
  ****************************************************************/
 
 #include <vector>
+#include <algorithm>
 #include <ros/ros.h>
 #include <cob_cartesian_controller/trajectory_profile_generator/trajectory_profile_generator_sinoid.h>
 
@@ -96,4 +97,41 @@ std::vector<double> TrajectoryProfileSinoid::getTrajectory(double se, cob_cartes
 
     return array;
 }
+
+double TrajectoryProfileSinoid::getPosition(double t, double se, const cob_cartesian_controller::ProfileTimings& pt)
+{
+    double direction = se/std::fabs(se);
+    double accl = params_.profile.accl;
+    t = std::min(std::max(t, 0.0), pt.te);
+
+    if (t <= pt.tb)
+    {
+        return direction * (accl*(0.25*pow(t, 2) + pow(pt.tb, 2)/(8*pow(M_PI, 2)) *(cos(2*M_PI/pt.tb * t)-1)));
+    }
+    if (t <= pt.tv)
+    {
+        return direction * (pt.vel*(t-0.5*pt.tb));
+    }
+    return direction * (0.5 * accl *(pt.te*(t + pt.tb) - 0.5*(pow(t, 2)+pow(pt.te, 2)+2*pow(pt.tb, 2)) + (pow(pt.tb, 2)/(4*pow(M_PI, 2))) * (1-cos(((2*M_PI)/pt.tb) * (t-pt.tv)))));
+}
+
+double TrajectoryProfileSinoid::getVelocity(double t, double se, const cob_cartesian_controller::ProfileTimings& pt)
+{
+    double direction = se/std::fabs(se);
+    double accl = params_.profile.accl;
+
+    if (t <= 0 || t >= pt.te)
+    {
+        return 0.0;
+    }
+    if (t <= pt.tb)
+    {
+        return direction * (accl*(0.5*t - pt.tb/(4*M_PI) * sin(2*M_PI/pt.tb * t)));
+    }
+    if (t <= pt.tv)
+    {
+        return direction * pt.vel;
+    }
+    return direction * (0.5 * accl * (pt.te - t + pt.tb/(2*M_PI) * sin(((2*M_PI)/pt.tb) * (t-pt.tv))));
+}
 /* END TrajectoryProfileSinoid ******************************************************************************************/
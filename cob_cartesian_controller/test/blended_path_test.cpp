@@ -0,0 +1,103 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_cartesian_controller
+ *
+ * \brief
+ *   Checks that BlendedPath keeps the Cartesian speed across LINE->ARC junctions.
+ *
+ ****************************************************************/
+
+#include <math.h>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <cob_cartesian_controller/MoveSegment.h>
+#include <cob_cartesian_controller/trajectory_interpolator/blended_path.h>
+
+namespace
+{
+
+/// LIN from the origin to (1, 0, 0), followed by a tangential quarter circle of the given radius
+std::vector<cob_cartesian_controller::MoveSegmentStruct> lineArc(double radius, double blend_radius)
+{
+    std::vector<cob_cartesian_controller::MoveSegmentStruct> segments(2);
+
+    segments[0].move_type = cob_cartesian_controller::MoveSegment::LIN;
+    segments[0].move_lin.end.position.x = 1.0;
+    segments[0].move_lin.end.orientation.w = 1.0;
+    segments[0].blend_radius = blend_radius;
+
+    // the circle lies in the x-z plane of the center, it starts at (1, 0, 0) heading in x direction
+    segments[1].move_type = cob_cartesian_controller::MoveSegment::CIRC;
+    segments[1].move_circ.pose_center.position.x = 1.0;
+    segments[1].move_circ.pose_center.position.z = radius;
+    segments[1].move_circ.pose_center.orientation.w = 1.0;
+    segments[1].move_circ.start_angle = -M_PI / 2.0;
+    segments[1].move_circ.end_angle = 0.0;
+    segments[1].move_circ.radius = radius;
+    segments[1].blend_radius = 0.0;
+    return segments;
+}
+
+geometry_msgs::Pose origin()
+{
+    geometry_msgs::Pose pose;
+    pose.orientation.w = 1.0;
+    return pose;
+}
+
+/// |dp/dsigma| along the whole path, it has to be 1 everywhere for a constant Cartesian speed
+/// (up to the arc length table of the blends, which deviates by less than 1e-3)
+void expectUnitSpeed(const BlendedPath& path)
+{
+    const unsigned int samples = 1000;
+    for (unsigned int i = 1; i < samples; i++)
+    {
+        double sigma = path.getLength() * i / samples;
+        tf::Vector3 linear, angular;
+        path.getDerivative(sigma, linear, angular);
+        EXPECT_NEAR(1.0, linear.length(), 5e-3) << "sigma " << sigma << " of " << path.getLength();
+    }
+}
+
+}  // namespace
+
+TEST(BlendedPath, SpeedKeptAtUnblendedLineArcJunction)
+{
+    BlendedPath path;
+    ASSERT_TRUE(path.build(lineArc(0.2, 0.0), origin()));
+
+    // the junction is tangential, so the path runs through without stop
+    EXPECT_EQ(2u, path.getStops().size());
+    EXPECT_NEAR(1.0 + 0.2 * M_PI / 2.0, path.getLength(), 1e-9);
+    expectUnitSpeed(path);
+}
+
+TEST(BlendedPath, SpeedKeptAtBlendedLineArcJunction)
+{
+    BlendedPath path;
+    ASSERT_TRUE(path.build(lineArc(0.2, 0.05), origin()));
+
+    EXPECT_EQ(2u, path.getStops().size());
+    expectUnitSpeed(path);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -60,7 +60,10 @@
 #include <ros/ros.h>
 #include <XmlRpc.h>
 
-#include <pthread.h>
+#include <ros/callback_queue.h>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 // ROS message includes
 #include <geometry_msgs/Twist.h>
@@ -82,9 +85,55 @@
 // BUT velocity limited marker
 #include "velocity_limited_marker.h"
 
+// obstacle classification kernels and incremental obstacle tracking
+#include "obstacle_classifier.h"
+#include "obstacle_tracker.h"
+#include "footprint_sweep.h"
+#include "snapshot_buffer.h"
+#include "update_bounds_layer.h"
+
 // Costmap for obstacle detection
 #include <tf/transform_listener.h>
 #include <costmap_2d/costmap_2d_ros.h>
+
+namespace cob_collision_velocity_filter
+{
+
+///
+/// @brief  velocity command handed from the command callback to the obstacle update
+///
+struct VelocityCommand
+{
+  double vx, vy, vtheta;
+};
+
+///
+/// @brief  result of an obstacle update, handed from the obstacle update to the command callback
+///
+struct ObstacleSnapshot
+{
+  bool valid;
+  ros::Time stamp;
+
+  // command for which the relevant obstacles were determined and whether the swept polygon was used
+  VelocityCommand command;
+  bool swept;
+  double closest_obstacle_dist, closest_obstacle_angle;
+
+  // closest obstacle regardless of the driving direction, used if the command changed since the update
+  double closest_any_obstacle_dist, closest_any_obstacle_angle;
+
+  // distance to the first contact of the footprint swept along the command, used for the time to collision law
+  // together with the speed of the current command
+  bool time_to_collision_mode;
+  double contact_dist, ttc_threshold, footprint_radius;
+
+  // parameters the update was done with
+  double influence_radius, stop_threshold, obstacle_damping_dist;
+};
+
+}
+
 ///
 /// @class CollisionVelocityFilter
 /// @brief checks for obstacles in driving direction and stops the robot
@@ -105,12 +154,17 @@ public:
   ~CollisionVelocityFilter();
 
   ///
-  /// @brief  reads twist command from teleop device (joystick, teleop_keyboard, ...) and calls functions
-  ///         for collision check (obstacleHandler) and driving of the robot (performControllerStep)
+  /// @brief  reads twist command from teleop device (joystick, teleop_keyboard, ...), hands it over to the
+  ///         obstacle update and filters it against the latest obstacle snapshot (performControllerStep)
   /// @param  twist - velocity command sent as twist message (twist.linear.x/y/z, twist.angular.x/y/z)
   ///
   void joystickVelocityCB(const geometry_msgs::Twist::ConstPtr &twist);
 
+  ///
+  /// @brief  Timer callback of the obstacle update thread, calls obstacleHandler
+  ///
+  void obstacleUpdateCB(const ros::TimerEvent&);
+
   ///
   /// @brief  reads obstacles from costmap
   /// @param  obstacles - 2D occupancy grid in rolling window mode!
@@ -140,6 +194,11 @@ public:
   /// Timer for periodically calling GetFootprint Service
   ros::Timer get_footprint_timer_;
 
+  /// Timer, callback queue and spinner of the obstacle update thread
+  ros::Timer obstacle_update_timer_;
+  ros::CallbackQueue obstacle_queue_;
+  boost::scoped_ptr<ros::AsyncSpinner> obstacle_spinner_;
+
   /// declaration of publisher
   ros::Publisher topic_pub_command_;
   ros::Publisher topic_pub_relevant_obstacles_;
@@ -159,12 +218,21 @@ private:
   ///
   /// @brief  checks distance to obstacles in driving direction and slows down/stops
   ///         robot and publishes command velocity to robot
+  /// @param  obstacles - latest result of the obstacle update
+  ///
+  void performControllerStep(const cob_collision_velocity_filter::ObstacleSnapshot& obstacles);
+
+  ///
+  /// @brief  computes the factor the command has to be scaled with to keep the time to collision above
+  ///         ttc_threshold and to be able to stop before stop_threshold
+  /// @param  obstacles - latest result of the obstacle update
+  /// @param  command_matches - true if the time to collision was determined for the current command
   ///
-  void performControllerStep();
+  double timeToCollisionScale(const cob_collision_velocity_filter::ObstacleSnapshot& obstacles, bool command_matches);
 
   ///
-  /// @brief  checks for obstacles in driving direction of the robot (rotation included)
-  ///         and publishes relevant obstacles
+  /// @brief  checks for obstacles in driving direction of the robot (rotation included),
+  ///         publishes relevant obstacles and the obstacle snapshot
   ///
   void obstacleHandler();
 
@@ -176,26 +244,22 @@ private:
   double sign(double x);
 
   ///
-  /// @brief  computes distance between two points
-  /// @param  a,b - Points
-  /// @return distance
+  /// @brief  checks whether the obstacle snapshot was determined for a command with similar driving direction
   ///
-  double getDistance2d(geometry_msgs::Point a, geometry_msgs::Point b);
-
-  ///
-  /// @brief  checks if obstacle lies already within footprint -> this is ignored due to sensor readings of the hull etc
-  /// @param  x_obstacle - x coordinate of obstacle in occupancy grid local costmap
-  /// @param  y_obstacle - y coordinate of obstacle in occupancy grid local costmap
-  /// @return true if obstacle outside of footprint
-  ///
-  bool obstacleValid(double x_obstacle, double y_obstacle);
+  bool commandMatches(const cob_collision_velocity_filter::ObstacleSnapshot& obstacles) const;
 
   ///
   /// @brief  stops movement of the robot
   ///
   void stopMovement();
 
-  pthread_mutex_t m_mutex;
+  /// protects footprint and parameters used by the obstacle update, never locked by the command callback
+  boost::mutex config_mutex_;
+
+  /// lock-free hand over of commands to the obstacle update and of its results to the command callback
+  cob_collision_velocity_filter::SnapshotBuffer<cob_collision_velocity_filter::VelocityCommand> command_snapshot_;
+  cob_collision_velocity_filter::SnapshotBuffer<cob_collision_velocity_filter::ObstacleSnapshot> obstacle_snapshot_;
+  ros::Duration obstacle_timeout_;
 
   //obstacle_treshold
   int costmap_obstacle_treshold_;
@@ -216,6 +280,24 @@ private:
   nav_msgs::OccupancyGrid last_costmap_received_, relevant_obstacles_;
   double influence_radius_, stop_threshold_, obstacle_damping_dist_, use_circumscribed_threshold_;
   double closest_obstacle_dist_, closest_obstacle_angle_;
+  double closest_any_obstacle_dist_, closest_any_obstacle_angle_;
+
+  // classification of obstacle cells and set of occupied cells within influence radius
+  cob_collision_velocity_filter::ObstacleClassifier classifier_;
+  cob_collision_velocity_filter::ObstacleTracker obstacle_tracker_;
+
+  // polygon footprint swept along the command, used instead of tube and circumscribed circle if enabled
+  cob_collision_velocity_filter::FootprintSweep footprint_sweep_;
+  bool use_polygon_footprint_;
+
+  // slow down law and minimum time to collision
+  int control_mode_;
+  double ttc_threshold_;
+  ros::Duration obstacle_resync_period_;
+  ros::Time last_obstacle_resync_;
+
+  // collects the cells touched by the costmap updates between two obstacle cycles, none if it isn't loaded
+  boost::shared_ptr<cob_collision_velocity_filter::UpdateBoundsLayer> update_bounds_layer_;
 
   // variables for slow down behavior
   double last_time_;
@@ -0,0 +1,186 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#ifndef COB_FOOTPRINT_SWEEP_H
+#define COB_FOOTPRINT_SWEEP_H
+
+#include <cstddef>
+#include <vector>
+
+#include "obstacle_classifier.h"
+
+namespace cob_collision_velocity_filter
+{
+
+///
+/// @brief  edge of the footprint polygon at the start of a sweep step
+///
+/// An obstacle p is hit during the step at fraction s of the step if n * (p - s * d) <= c for all edges,
+/// where d is the translation during the step. With a = n * p - c and b = n * d every edge bounds s from
+/// below (b > 0), from above (b < 0) or excludes p altogether (b = 0 and a > 0).
+///
+struct SweepEdge
+{
+  enum Kind
+  {
+    LOWER, UPPER, PARALLEL
+  };
+
+  double nx, ny;  ///< outward normal
+  double c;       ///< offset, inflated by the rotation during the step
+  double inv_b;   ///< 1 / (n * d)
+  int kind;
+};
+
+struct SweepStep
+{
+  double t0, dt;  ///< start time and duration of the step
+  size_t first_edge;
+};
+
+///
+/// @class FootprintSweep
+/// @brief sweeps the convex footprint polygon along the commanded twist and finds the time of first contact
+///        with obstacle cells
+///
+/// The motion is split into steps in which the footprint is translated without rotation, which is exact for
+/// pure translation. The rotation within a step is accounted for by inflating the footprint by the maximum
+/// displacement it causes, which is kept below the given tolerance.
+///
+class FootprintSweep
+{
+public:
+  FootprintSweep();
+
+  ///
+  /// @brief  sets the footprint polygon, non-convex polygons are replaced by their convex hull
+  /// @return false if the polygon had to be replaced by its convex hull
+  ///
+  bool setFootprint(const std::vector<Point2D>& footprint);
+
+  ///
+  /// @brief  precomputes the sweep steps for a command
+  /// @param  vx, vy, vtheta - commanded velocity
+  /// @param  max_contact_distance - the sweep ends when the footprint has moved this distance
+  /// @param  tolerance - maximum inflation of the footprint due to rotation within a step
+  ///
+  void setCommand(double vx, double vy, double vtheta, double max_contact_distance, double tolerance);
+
+  ///
+  /// @return true if the command moves the footprint
+  ///
+  bool active() const
+  {
+    return !steps_.empty();
+  }
+
+  ///
+  /// @return distance of the footprint point farthest from the robot center
+  ///
+  double radius() const
+  {
+    return radius_;
+  }
+
+  ///
+  /// @return upper bound of the velocity of any footprint point, converts contact times to contact distances
+  ///
+  double speedBound() const
+  {
+    return speed_bound_;
+  }
+
+  size_t numSteps() const
+  {
+    return steps_.size();
+  }
+
+  double stepEnd(size_t step) const
+  {
+    return steps_[step].t0 + steps_[step].dt;
+  }
+
+  ///
+  /// @return true if the point lies within the footprint at its current pose
+  ///
+  bool inside(double x, double y) const;
+
+  ///
+  /// @return lower bound of the distance of the point to the footprint at its current pose, 0 if inside
+  ///
+  double clearance(double x, double y) const;
+
+  ///
+  /// @brief  finds the obstacles hit during a step
+  /// @param  step - index of the step
+  /// @param  x, y - coordinates of the obstacle cells in robot frame
+  /// @param  n - number of cells
+  /// @param  contact_time - lowered to the time of contact for every cell that is hit during the step
+  /// @return number of cells hit during the step
+  ///
+  size_t contactStep(size_t step, const double* x, const double* y, size_t n, double* contact_time) const;
+
+  void enableAvx2(bool enable);
+
+private:
+  std::vector<Point2D> hull_;
+  std::vector<Point2D> normals_;
+  std::vector<double> offsets_;
+  double radius_, speed_bound_;
+
+  std::vector<SweepStep> steps_;
+  std::vector<SweepEdge> edges_;
+  bool use_avx2_;
+};
+
+namespace kernels
+{
+size_t contactScalar(const SweepStep& step, const SweepEdge* edges, size_t num_edges, const double* x,
+                     const double* y, size_t begin, size_t end, double* contact_time);
+size_t contactAvx2(const SweepStep& step, const SweepEdge* edges, size_t num_edges, const double* x,
+                   const double* y, size_t n, double* contact_time);
+}
+
+}
+
+#endif // COB_FOOTPRINT_SWEEP_H
@@ -0,0 +1,181 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#ifndef COB_OBSTACLE_CLASSIFIER_H
+#define COB_OBSTACLE_CLASSIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace cob_collision_velocity_filter
+{
+
+struct Point2D
+{
+  double x;
+  double y;
+};
+
+///
+/// @brief  geometry used by the classification kernels, precomputed once per cycle
+///
+/// All tests are expressed as projections onto the velocity direction u and its normal n,
+/// so that no trigonometric function has to be evaluated per obstacle cell.
+///
+struct ClassifierFrame
+{
+  bool use_tube, use_circumscribed;
+
+  // velocity direction and its left-hand normal
+  double ux, uy, nx, ny;
+
+  // tube borders (along n) and origins (along u) in robot frame
+  double tube_left_border, tube_right_border;
+  double tube_left_origin, tube_right_origin;
+
+  double circumscribed_radius_sq, influence_radius_sq;
+
+  // rectangular footprint approximation and its absolute values
+  double front, rear, left, right;
+  double abs_front, abs_rear, abs_left, abs_right;
+};
+
+///
+/// @brief  result of a classification pass
+///
+struct ClosestObstacle
+{
+  double distance;    ///< distance of the closest relevant obstacle to the footprint border
+  long index;         ///< index of the closest relevant obstacle in the cell arrays, -1 if none is closer than distance
+  size_t num_inside;  ///< number of obstacle cells that were skipped because they lie within the footprint
+};
+
+///
+/// @class ObstacleClassifier
+/// @brief decides which obstacle cells lie in the tube or the circumscribed circle of the robot
+///        and finds the closest one to the footprint border
+///
+class ObstacleClassifier
+{
+public:
+  ///
+  /// @brief  Constructor, selects the AVX2 kernel if it is compiled in and supported by the cpu
+  ///
+  ObstacleClassifier();
+
+  ///
+  /// @brief  sets the footprint polygon and its rectangular approximation
+  ///
+  void setFootprint(const std::vector<Point2D>& footprint, double front, double rear, double left, double right);
+
+  ///
+  /// @brief  sets the radius beyond which obstacles are ignored by the tube test
+  ///
+  void setInfluenceRadius(double influence_radius);
+
+  ///
+  /// @brief  decides whether tube and/or circumscribed test are used and computes the tube for the given command
+  /// @param  vx, vy, vtheta - commanded velocity
+  /// @param  use_circumscribed_threshold - rotational velocity above which the circumscribed test is used while driving
+  ///
+  void setCommand(double vx, double vy, double vtheta, double use_circumscribed_threshold);
+
+  ///
+  /// @return radius around the robot center beyond which no obstacle can be relevant for the current command
+  ///
+  double relevantRadius() const;
+
+  ///
+  /// @brief  classifies obstacle cells given in robot frame
+  /// @param  x, y - coordinates of the obstacle cells
+  /// @param  n - number of cells
+  /// @param  relevant - if not NULL, set to 100 for every relevant cell and 0 otherwise
+  /// @param  closest - closest.distance has to be initialized with the maximum distance of interest,
+  ///                   it is updated together with closest.index if a closer relevant obstacle is found
+  ///
+  void classify(const double* x, const double* y, size_t n, unsigned char* relevant, ClosestObstacle& closest) const;
+
+  ///
+  /// @return true if the AVX2 kernel is used
+  ///
+  bool usesAvx2() const
+  {
+    return use_avx2_;
+  }
+
+  ///
+  /// @brief  enables or disables the AVX2 kernel, has no effect if it is not available
+  ///
+  void enableAvx2(bool enable);
+
+  const ClassifierFrame& frame() const
+  {
+    return frame_;
+  }
+
+private:
+  std::vector<Point2D> footprint_;
+  ClassifierFrame frame_;
+  double influence_radius_;
+  bool use_avx2_;
+};
+
+namespace kernels
+{
+///
+/// @brief  distance of a point outside the footprint rectangle to its border, measured along the ray from the robot center
+/// @param  r - distance of the point to the robot center
+///
+double borderDistance(const ClassifierFrame& f, double x, double y, double r);
+
+void classifyScalar(const ClassifierFrame& f, const double* x, const double* y, size_t begin, size_t end,
+                    unsigned char* relevant, ClosestObstacle& closest);
+
+bool avx2Available();
+void classifyAvx2(const ClassifierFrame& f, const double* x, const double* y, size_t n, unsigned char* relevant,
+                  ClosestObstacle& closest);
+}
+
+}
+
+#endif // COB_OBSTACLE_CLASSIFIER_H
@@ -0,0 +1,175 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#ifndef COB_OBSTACLE_TRACKER_H
+#define COB_OBSTACLE_TRACKER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "obstacle_classifier.h"
+#include "footprint_sweep.h"
+
+namespace cob_collision_velocity_filter
+{
+
+///
+/// @brief  closest relevant obstacle found by the ObstacleTracker
+///
+struct TrackedObstacle
+{
+  double distance;    ///< distance to the footprint border
+  double x, y;        ///< position in robot frame
+  long cell;          ///< index in the costmap, -1 if none was found
+  size_t num_inside;  ///< number of obstacle cells that were skipped because they lie within the footprint
+};
+
+///
+/// @class ObstacleTracker
+/// @brief keeps the set of occupied costmap cells within the tracking radius up to date
+///
+/// The set is updated incrementally from the bounds of the last costmap update. Cells are binned by their
+/// distance to the footprint border, so the closest relevant obstacle for a command is found by classifying
+/// the bins in ascending order until the first relevant obstacle shows up.
+///
+class ObstacleTracker
+{
+public:
+  ObstacleTracker();
+
+  ///
+  /// @return true if the tracked set was built for another map geometry, tracking radius or footprint
+  ///
+  bool outdated(unsigned int size_x, unsigned int size_y, double resolution, double origin_x, double origin_y,
+                double tracking_radius, const ClassifierFrame& frame) const;
+
+  ///
+  /// @brief  clears the tracked set and sets up the map geometry, call update on the whole map afterwards
+  ///
+  void reset(unsigned int size_x, unsigned int size_y, double resolution, double origin_x, double origin_y,
+             double tracking_radius, const ClassifierFrame& frame);
+
+  ///
+  /// @brief  compares the cells within [x0, xn) x [y0, yn) to the tracked set and inserts or removes them
+  /// @param  char_map - costmap data
+  /// @param  threshold - cost at which a cell is considered an obstacle
+  ///
+  void update(const unsigned char* char_map, unsigned int threshold, unsigned int x0, unsigned int xn,
+              unsigned int y0, unsigned int yn);
+
+  ///
+  /// @brief  finds the relevant obstacle closest to the footprint border
+  /// @param  max_distance - obstacles with a larger distance are ignored
+  /// @return true if a relevant obstacle was found
+  ///
+  bool findClosest(const ObstacleClassifier& classifier, double max_distance, TrackedObstacle& closest) const;
+
+  ///
+  /// @brief  finds the obstacle closest to the footprint border regardless of the commanded direction
+  /// @param  max_distance - obstacles with a larger distance are ignored
+  /// @return true if an obstacle was found
+  ///
+  bool findClosestAny(double max_distance, TrackedObstacle& closest) const;
+
+  ///
+  /// @brief  finds the obstacle that is hit first when sweeping the footprint along the command
+  /// @param  max_distance - obstacles hit after the footprint moved this distance are ignored
+  /// @param  closest - closest.distance is the distance the footprint moves until the contact
+  /// @return true if an obstacle is hit
+  ///
+  bool findFirstContact(const FootprintSweep& sweep, double max_distance, TrackedObstacle& closest) const;
+
+  ///
+  /// @brief  marks all obstacles hit by the swept footprint with 100 in grid
+  /// @return number of obstacle cells within the footprint
+  ///
+  size_t markContacts(const FootprintSweep& sweep, std::vector<signed char>& grid) const;
+
+  ///
+  /// @brief  marks all relevant obstacles with 100 in grid, which has to be of costmap size and zero initialized
+  /// @return number of obstacle cells within the footprint
+  ///
+  size_t markRelevant(const ObstacleClassifier& classifier, std::vector<signed char>& grid) const;
+
+  size_t size() const
+  {
+    return num_tracked_;
+  }
+
+private:
+  struct Bin
+  {
+    // sorted by cell index, so that ties are resolved like in a sequential scan of the costmap
+    std::vector<unsigned int> cell;
+    std::vector<double> x, y;
+  };
+
+  void insert(unsigned int cell, double x, double y);
+  void remove(unsigned int cell);
+
+  ///
+  /// @brief  copies the tracked cells outside the footprint to contiguous sweep buffers
+  /// @return number of cells within the footprint
+  ///
+  size_t gatherSweepCells(const FootprintSweep& sweep) const;
+
+  unsigned int size_x_, size_y_;
+  double resolution_, origin_x_, origin_y_;
+  double tracking_radius_;
+  ClassifierFrame frame_;
+
+  // window of cells that may lie within the tracking radius
+  unsigned int window_x0_, window_xn_, window_y0_, window_yn_;
+
+  std::vector<Bin> bins_;
+  std::vector<int> cell_bin_;  ///< bin of every costmap cell, -1 if it is not tracked
+  size_t num_tracked_;
+
+  mutable std::vector<unsigned char> relevant_buffer_;
+  mutable std::vector<unsigned int> sweep_cell_;
+  mutable std::vector<double> sweep_x_, sweep_y_, sweep_time_;
+};
+
+}
+
+#endif // COB_OBSTACLE_TRACKER_H
@@ -0,0 +1,112 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#ifndef COB_SNAPSHOT_BUFFER_H
+#define COB_SNAPSHOT_BUFFER_H
+
+#include <atomic>
+
+namespace cob_collision_velocity_filter
+{
+
+///
+/// @class SnapshotBuffer
+/// @brief lock-free triple buffer handing the latest value from one writer thread to one reader thread
+///
+/// The writer fills writeBuffer() and calls publish(), the reader calls read() and always gets the most
+/// recently published value. Neither side ever blocks or waits for the other one.
+///
+template <class T>
+class SnapshotBuffer
+{
+public:
+  SnapshotBuffer()
+    : write_index_(0), read_index_(1), middle_(2)
+  {
+  }
+
+  ///
+  /// @brief  buffer to be filled by the writer before calling publish()
+  ///
+  T& writeBuffer()
+  {
+    return buffers_[write_index_];
+  }
+
+  ///
+  /// @brief  makes the content of writeBuffer() the latest value
+  ///
+  void publish()
+  {
+    write_index_ = middle_.exchange(write_index_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  void write(const T& value)
+  {
+    writeBuffer() = value;
+    publish();
+  }
+
+  ///
+  /// @brief  latest published value, stays valid until the next call of read()
+  ///
+  const T& read()
+  {
+    if (middle_.load(std::memory_order_acquire) & FRESH)
+      read_index_ = middle_.exchange(read_index_, std::memory_order_acq_rel) & INDEX_MASK;
+    return buffers_[read_index_];
+  }
+
+private:
+  static const unsigned int INDEX_MASK = 3;
+  static const unsigned int FRESH = 4;
+
+  T buffers_[3];
+  unsigned int write_index_;  ///< only accessed by the writer
+  unsigned int read_index_;   ///< only accessed by the reader
+  std::atomic<unsigned int> middle_;
+};
+
+}
+
+#endif // COB_SNAPSHOT_BUFFER_H
@@ -0,0 +1,93 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#ifndef COB_UPDATE_BOUNDS_LAYER_H
+#define COB_UPDATE_BOUNDS_LAYER_H
+
+#include <boost/thread/mutex.hpp>
+
+#include <costmap_2d/layer.h>
+
+namespace cob_collision_velocity_filter
+{
+
+///
+/// @class UpdateBoundsLayer
+/// @brief costmap layer that changes no costs, but collects the cells touched by the costmap updates
+///
+/// The union of the update bounds is kept until it is consumed, so the ObstacleTracker sees every update
+/// even if several of them happen between two obstacle cycles. Resets and moves or resizes of the costmap
+/// mark the whole costmap. The layer has to be the last one of the costmap.
+///
+class UpdateBoundsLayer : public costmap_2d::Layer
+{
+public:
+  UpdateBoundsLayer();
+
+  virtual void updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j);
+  virtual void reset();
+
+  ///
+  /// @brief  returns the cells [x0, xn) x [y0, yn) touched since the last call and clears them
+  /// @return false if the costmap was not updated since the last call
+  ///
+  bool consumeBounds(unsigned int& x0, unsigned int& xn, unsigned int& y0, unsigned int& yn);
+
+protected:
+  virtual void onInitialize();
+
+private:
+  void addBounds(unsigned int x0, unsigned int xn, unsigned int y0, unsigned int yn);
+
+  boost::mutex mutex_;
+  bool updated_;
+  unsigned int x0_, xn_, y0_, yn_;
+
+  // geometry of the costmap at the last update
+  unsigned int size_x_, size_y_;
+  double origin_x_, origin_y_;
+};
+
+}
+
+#endif
@@ -0,0 +1,216 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#include <obstacle_classifier.h>
+#include <footprint_sweep.h>
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace cob_collision_velocity_filter
+{
+namespace kernels
+{
+
+void classifyAvx2(const ClassifierFrame& f, const double* x, const double* y, size_t n, unsigned char* relevant,
+                  ClosestObstacle& closest)
+{
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d sign_bit = _mm256_set1_pd(-0.0);
+  const __m256d use_circumscribed = _mm256_castsi256_pd(_mm256_set1_epi64x(f.use_circumscribed ? -1 : 0));
+  const __m256d use_tube = _mm256_castsi256_pd(_mm256_set1_epi64x(f.use_tube ? -1 : 0));
+
+  const __m256d circumscribed_radius_sq = _mm256_set1_pd(f.circumscribed_radius_sq);
+  const __m256d influence_radius_sq = _mm256_set1_pd(f.influence_radius_sq);
+  const __m256d ux = _mm256_set1_pd(f.ux), uy = _mm256_set1_pd(f.uy);
+  const __m256d nx = _mm256_set1_pd(f.nx), ny = _mm256_set1_pd(f.ny);
+  const __m256d tube_left_border = _mm256_set1_pd(f.tube_left_border);
+  const __m256d tube_right_border = _mm256_set1_pd(f.tube_right_border);
+  const __m256d tube_left_origin = _mm256_set1_pd(f.tube_left_origin);
+  const __m256d tube_right_origin = _mm256_set1_pd(f.tube_right_origin);
+  const __m256d front = _mm256_set1_pd(f.front), rear = _mm256_set1_pd(f.rear);
+  const __m256d left = _mm256_set1_pd(f.left), right = _mm256_set1_pd(f.right);
+  const __m256d abs_front = _mm256_set1_pd(f.abs_front), abs_rear = _mm256_set1_pd(f.abs_rear);
+  const __m256d abs_left = _mm256_set1_pd(f.abs_left), abs_right = _mm256_set1_pd(f.abs_right);
+
+  __m256d best_dist = _mm256_set1_pd(closest.distance);
+  __m256d best_index = _mm256_set1_pd(-1.0);
+  __m256d index = _mm256_setr_pd(0.0, 1.0, 2.0, 3.0);
+  const __m256d index_step = _mm256_set1_pd(4.0);
+  size_t num_inside = 0;
+
+  const size_t n4 = n & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < n4; i += 4, index = _mm256_add_pd(index, index_step))
+  {
+    const __m256d px = _mm256_loadu_pd(x + i);
+    const __m256d py = _mm256_loadu_pd(y + i);
+    const __m256d r_sq = _mm256_add_pd(_mm256_mul_pd(px, px), _mm256_mul_pd(py, py));
+
+    const __m256d in_circumscribed = _mm256_and_pd(use_circumscribed,
+                                                   _mm256_cmp_pd(r_sq, circumscribed_radius_sq, _CMP_LE_OQ));
+    const __m256d in_influence = _mm256_and_pd(use_tube, _mm256_cmp_pd(r_sq, influence_radius_sq, _CMP_LT_OQ));
+    const __m256d candidate = _mm256_or_pd(in_circumscribed, in_influence);
+    if (_mm256_movemask_pd(candidate) == 0)
+    {
+      if (relevant)
+        memset(relevant + i, 0, 4);
+      continue;
+    }
+
+    const __m256d inside = _mm256_and_pd(
+        _mm256_and_pd(_mm256_cmp_pd(px, front, _CMP_LT_OQ), _mm256_cmp_pd(px, rear, _CMP_GT_OQ)),
+        _mm256_and_pd(_mm256_cmp_pd(py, right, _CMP_GT_OQ), _mm256_cmp_pd(py, left, _CMP_LT_OQ)));
+    num_inside += __builtin_popcount(_mm256_movemask_pd(_mm256_and_pd(candidate, inside)));
+
+    const __m256d dist_vel_dir = _mm256_add_pd(_mm256_mul_pd(nx, px), _mm256_mul_pd(ny, py));
+    const __m256d dist_along_vel = _mm256_add_pd(_mm256_mul_pd(ux, px), _mm256_mul_pd(uy, py));
+    const __m256d tube_origin = _mm256_blendv_pd(tube_right_origin, tube_left_origin,
+                                                 _mm256_cmp_pd(dist_vel_dir, zero, _CMP_GE_OQ));
+    const __m256d in_tube = _mm256_and_pd(
+        _mm256_and_pd(_mm256_cmp_pd(dist_vel_dir, tube_left_border, _CMP_LE_OQ),
+                      _mm256_cmp_pd(dist_vel_dir, tube_right_border, _CMP_GE_OQ)),
+        _mm256_cmp_pd(dist_along_vel, tube_origin, _CMP_GE_OQ));
+
+    const __m256d is_relevant = _mm256_andnot_pd(inside,
+                                                 _mm256_and_pd(candidate, _mm256_or_pd(in_circumscribed, in_tube)));
+    const int relevant_bits = _mm256_movemask_pd(is_relevant);
+    if (relevant)
+    {
+      relevant[i] = (relevant_bits & 1) ? 100 : 0;
+      relevant[i + 1] = (relevant_bits & 2) ? 100 : 0;
+      relevant[i + 2] = (relevant_bits & 4) ? 100 : 0;
+      relevant[i + 3] = (relevant_bits & 8) ? 100 : 0;
+    }
+    if (relevant_bits == 0)
+      continue;
+
+    // distance to the border of the footprint rectangle, see borderDistance()
+    const __m256d cross_front_right = _mm256_sub_pd(_mm256_mul_pd(front, py), _mm256_mul_pd(right, px));
+    const __m256d cross_front_left = _mm256_sub_pd(_mm256_mul_pd(front, py), _mm256_mul_pd(left, px));
+    const __m256d cross_rear_left = _mm256_sub_pd(_mm256_mul_pd(rear, py), _mm256_mul_pd(left, px));
+    const __m256d cross_rear_right = _mm256_sub_pd(_mm256_mul_pd(rear, py), _mm256_mul_pd(right, px));
+    const __m256d sector_front = _mm256_and_pd(_mm256_cmp_pd(cross_front_right, zero, _CMP_GE_OQ),
+                                               _mm256_cmp_pd(cross_front_left, zero, _CMP_LT_OQ));
+    const __m256d sector_left = _mm256_and_pd(_mm256_cmp_pd(cross_front_left, zero, _CMP_GE_OQ),
+                                              _mm256_cmp_pd(cross_rear_left, zero, _CMP_LT_OQ));
+    const __m256d sector_rear = _mm256_and_pd(_mm256_cmp_pd(cross_rear_left, zero, _CMP_GE_OQ),
+                                              _mm256_cmp_pd(cross_rear_right, zero, _CMP_LT_OQ));
+
+    // sectors are disjoint, so the blends below apply the first matching sector as the scalar if/else chain does
+    __m256d bound = _mm256_blendv_pd(abs_right, abs_rear, sector_rear);
+    bound = _mm256_blendv_pd(bound, abs_left, sector_left);
+    bound = _mm256_blendv_pd(bound, abs_front, sector_front);
+    const __m256d abs_px = _mm256_andnot_pd(sign_bit, px);
+    const __m256d abs_py = _mm256_andnot_pd(sign_bit, py);
+    const __m256d coord = _mm256_blendv_pd(abs_py, abs_px, _mm256_or_pd(sector_front, sector_rear));
+
+    const __m256d r = _mm256_sqrt_pd(r_sq);
+    const __m256d dist = _mm256_sub_pd(r, _mm256_div_pd(_mm256_mul_pd(bound, r), coord));
+
+    const __m256d closer = _mm256_and_pd(is_relevant, _mm256_cmp_pd(dist, best_dist, _CMP_LT_OQ));
+    best_dist = _mm256_blendv_pd(best_dist, dist, closer);
+    best_index = _mm256_blendv_pd(best_index, index, closer);
+  }
+
+  // reduce the lanes, ties are resolved towards the lower index like in the sequential scan
+  double lane_dist[4], lane_index[4];
+  _mm256_storeu_pd(lane_dist, best_dist);
+  _mm256_storeu_pd(lane_index, best_index);
+  for (int l = 0; l < 4; l++)
+  {
+    if (lane_index[l] < 0.0)
+      continue;
+    if (lane_dist[l] < closest.distance
+        || (lane_dist[l] == closest.distance && lane_index[l] < static_cast<double>(closest.index)))
+    {
+      closest.distance = lane_dist[l];
+      closest.index = static_cast<long>(lane_index[l]);
+    }
+  }
+  closest.num_inside += num_inside;
+
+  classifyScalar(f, x, y, n4, n, relevant, closest);
+}
+
+size_t contactAvx2(const SweepStep& step, const SweepEdge* edges, size_t num_edges, const double* x,
+                   const double* y, size_t n, double* contact_time)
+{
+  const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+  const __m256d t0 = _mm256_set1_pd(step.t0), dt = _mm256_set1_pd(step.dt);
+  size_t contacts = 0;
+
+  const size_t n4 = n & ~static_cast<size_t>(3);
+  for (size_t i = 0; i < n4; i += 4)
+  {
+    const __m256d px = _mm256_loadu_pd(x + i);
+    const __m256d py = _mm256_loadu_pd(y + i);
+    __m256d lower = zero, upper = one, excluded = zero;
+    for (size_t e = 0; e < num_edges; e++)
+    {
+      const __m256d a = _mm256_sub_pd(
+          _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(edges[e].nx), px), _mm256_mul_pd(_mm256_set1_pd(edges[e].ny), py)),
+          _mm256_set1_pd(edges[e].c));
+      if (edges[e].kind == SweepEdge::LOWER)
+        lower = _mm256_max_pd(lower, _mm256_mul_pd(a, _mm256_set1_pd(edges[e].inv_b)));
+      else if (edges[e].kind == SweepEdge::UPPER)
+        upper = _mm256_min_pd(upper, _mm256_mul_pd(a, _mm256_set1_pd(edges[e].inv_b)));
+      else
+        excluded = _mm256_or_pd(excluded, _mm256_cmp_pd(a, zero, _CMP_GT_OQ));
+    }
+    const __m256d hit = _mm256_andnot_pd(excluded, _mm256_cmp_pd(lower, upper, _CMP_LE_OQ));
+    const int hit_bits = _mm256_movemask_pd(hit);
+    if (hit_bits == 0)
+      continue;
+    contacts += __builtin_popcount(hit_bits);
+
+    const __m256d t = _mm256_add_pd(t0, _mm256_mul_pd(lower, dt));
+    const __m256d current = _mm256_loadu_pd(contact_time + i);
+    _mm256_storeu_pd(contact_time + i,
+                     _mm256_blendv_pd(current, t, _mm256_and_pd(hit, _mm256_cmp_pd(t, current, _CMP_LT_OQ))));
+  }
+
+  return contacts + contactScalar(step, edges, num_edges, x, y, n4, n, contact_time);
+}
+
+}
+}
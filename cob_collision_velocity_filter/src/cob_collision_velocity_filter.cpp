@@ -51,6 +51,11 @@
 
 #include <visualization_msgs/Marker.h>
 
+#include <algorithm>
+#include <limits>
+
+using namespace cob_collision_velocity_filter;
+
 // Constructor
 CollisionVelocityFilter::CollisionVelocityFilter(costmap_2d::Costmap2DROS * costmap)
 {
@@ -58,12 +63,25 @@ CollisionVelocityFilter::CollisionVelocityFilter(costmap_2d::Costmap2DROS * cost
   nh_ = ros::NodeHandle("");
   pnh_ = ros::NodeHandle("~");
 
-  m_mutex = PTHREAD_MUTEX_INITIALIZER;
-
   anti_collision_costmap_ = costmap;
 
   pnh_.param("costmap_obstacle_treshold", costmap_obstacle_treshold_, 250);
 
+  // tracked obstacles are updated from the cells touched by the costmap updates (see UpdateBoundsLayer)
+  // and fully resynchronized with this period
+  double obstacle_resync_period;
+  pnh_.param("obstacle_resync_period", obstacle_resync_period, 1.0);
+  obstacle_resync_period_ = ros::Duration(obstacle_resync_period);
+  last_obstacle_resync_ = ros::Time(0);
+
+  // the layer is appended to the costmap layers in main
+  std::vector<boost::shared_ptr<costmap_2d::Layer> >* plugins =
+      anti_collision_costmap_->getLayeredCostmap()->getPlugins();
+  for (unsigned int i = 0; i < plugins->size() && !update_bounds_layer_; i++)
+    update_bounds_layer_ = boost::dynamic_pointer_cast<UpdateBoundsLayer>((*plugins)[i]);
+  if (!update_bounds_layer_)
+    ROS_WARN("No UpdateBoundsLayer in anti_collision_costmap: tracked obstacles are updated from the whole costmap.");
+
   // implementation of topics to publish (command for base and list of relevant obstacles)
   topic_pub_command_ = nh_.advertise<geometry_msgs::Twist>("command", 1);
   topic_pub_relevant_obstacles_ = nh_.advertise<nav_msgs::OccupancyGrid>("relevant_obstacles_grid", 1);
@@ -94,6 +112,8 @@ CollisionVelocityFilter::CollisionVelocityFilter(costmap_2d::Costmap2DROS * cost
   pnh_.param("influence_radius", influence_radius_, 1.5);
   closest_obstacle_dist_ = influence_radius_;
   closest_obstacle_angle_ = 0.0;
+  closest_any_obstacle_dist_ = influence_radius_;
+  closest_any_obstacle_angle_ = 0.0;
 
   // parameters for obstacle avoidance and velocity adjustment
   if (!pnh_.hasParam("stop_threshold"))
@@ -133,11 +153,16 @@ CollisionVelocityFilter::CollisionVelocityFilter(costmap_2d::Costmap2DROS * cost
     ROS_WARN("Used default parameter for pot_ctrl_virt_mass [0.8]");
   pnh_.param("pot_ctrl_virt_mass", virt_mass_, 0.8);
 
-  robot_footprint_ = anti_collision_costmap_->getRobotFootprint();
+  // footprint is adjusted to the polygon by getFootprint
+  footprint_front_initial_ = footprint_rear_initial_ = footprint_left_initial_ = footprint_right_initial_ = 0.0;
+  use_polygon_footprint_ = false;
+  control_mode_ = cob_collision_velocity_filter::CollisionVelocityFilter_POTENTIAL_FIELD;
+  ttc_threshold_ = 1.0;
+  getFootprint(ros::TimerEvent());
 
   if (robot_footprint_.size() > 4)
     ROS_WARN(
-        "You have set more than 4 points as robot_footprint, cob_collision_velocity_filter can deal only with rectangular footprints so far!");
+        "You have set more than 4 points as robot_footprint, cob_collision_velocity_filter can deal only with rectangular footprints unless use_polygon_footprint is set!");
 
   // try to get the max_acceleration values from the parameter server
   if (!pnh_.hasParam("max_acceleration"))
@@ -165,14 +190,37 @@ CollisionVelocityFilter::CollisionVelocityFilter(costmap_2d::Costmap2DROS * cost
   // dynamic reconfigure
   dynCB_ = boost::bind(&CollisionVelocityFilter::dynamicReconfigureCB, this, _1, _2);
   dyn_server_.setCallback(dynCB_);
+
+  // no obstacle update done yet
+  VelocityCommand no_command = { 0.0, 0.0, 0.0 };
+  command_snapshot_.write(no_command);
+  ObstacleSnapshot& no_obstacles = obstacle_snapshot_.writeBuffer();
+  no_obstacles.valid = false;
+  obstacle_snapshot_.publish();
+
+  // obstacles are updated at a fixed rate in a separate thread, commands are filtered against the latest result
+  double obstacle_update_frequency;
+  if (!pnh_.hasParam("obstacle_update_frequency"))
+    ROS_WARN("Used default parameter for obstacle_update_frequency [20.0 Hz]");
+  pnh_.param("obstacle_update_frequency", obstacle_update_frequency, 20.0);
+  obstacle_timeout_ = ros::Duration(5.0 / obstacle_update_frequency);
+
+  ros::NodeHandle obstacle_nh(pnh_);
+  obstacle_nh.setCallbackQueue(&obstacle_queue_);
+  obstacle_update_timer_ = obstacle_nh.createTimer(ros::Duration(1.0 / obstacle_update_frequency),
+                                                   &CollisionVelocityFilter::obstacleUpdateCB, this);
+  obstacle_spinner_.reset(new ros::AsyncSpinner(1, &obstacle_queue_));
+  obstacle_spinner_->start();
+  if (classifier_.usesAvx2())
+    ROS_DEBUG("[cob_collision_velocity_filter] Using AVX2 obstacle classification");
   ROS_DEBUG("[cob_collision_velocity_filter] Initialized");
 }
 
 // Destructor
 CollisionVelocityFilter::~CollisionVelocityFilter()
 {
-//  costmap_thread_->interrupt();
-//  costmap_thread_->join();
+  obstacle_update_timer_.stop();
+  obstacle_spinner_->stop();
 }
 
 // joystick_velocityCB reads twist command from joystick
@@ -180,18 +228,26 @@ void CollisionVelocityFilter::joystickVelocityCB(const geometry_msgs::Twist::Con
 {
   //std::cout << "received command" << std::endl;
   ROS_DEBUG_NAMED("joystickVelocityCB", "[cob_collision_velocity_filter] Received command");
-  pthread_mutex_lock(&m_mutex);
 
   robot_twist_linear_ = twist->linear;
   robot_twist_angular_ = twist->angular;
 
-  pthread_mutex_unlock(&m_mutex);
+  // hand over command to obstacle update
+  VelocityCommand& command = command_snapshot_.writeBuffer();
+  command.vx = twist->linear.x;
+  command.vy = twist->linear.y;
+  command.vtheta = twist->angular.z;
+  command_snapshot_.publish();
 
-  // check for relevant obstacles
-  obstacleHandler();
   // stop if we are about to run in an obstacle
-  performControllerStep();
+  performControllerStep(obstacle_snapshot_.read());
+}
 
+// timer callback of obstacle update thread
+void CollisionVelocityFilter::obstacleUpdateCB(const ros::TimerEvent& event)
+{
+  // check for relevant obstacles
+  obstacleHandler();
 }
 
 // timer callback for periodically checking footprint
@@ -202,7 +258,7 @@ void CollisionVelocityFilter::getFootprint(const ros::TimerEvent& event)
   std::vector<geometry_msgs::Point> footprint;
   footprint = anti_collision_costmap_->getRobotFootprint();
 
-  pthread_mutex_lock(&m_mutex);
+  boost::mutex::scoped_lock lock(config_mutex_);
 
   footprint_front_ = footprint_front_initial_;
   footprint_rear_ = footprint_rear_initial_;
@@ -210,6 +266,7 @@ void CollisionVelocityFilter::getFootprint(const ros::TimerEvent& event)
   footprint_right_ = footprint_right_initial_;
 
   robot_footprint_ = footprint;
+  std::vector<Point2D> footprint_2d(footprint.size());
   for (unsigned int i = 0; i < footprint.size(); i++)
   {
     if (footprint[i].x > footprint_front_)
@@ -220,16 +277,18 @@ void CollisionVelocityFilter::getFootprint(const ros::TimerEvent& event)
       footprint_left_ = footprint[i].y;
     if (footprint[i].y < footprint_right_)
       footprint_right_ = footprint[i].y;
+    footprint_2d[i].x = footprint[i].x;
+    footprint_2d[i].y = footprint[i].y;
   }
-
-  pthread_mutex_unlock(&m_mutex);
-
+  classifier_.setFootprint(footprint_2d, footprint_front_, footprint_rear_, footprint_left_, footprint_right_);
+  if (!footprint_sweep_.setFootprint(footprint_2d) && use_polygon_footprint_)
+    ROS_WARN_ONCE("robot_footprint is not convex, using its convex hull!");
 }
 
 void CollisionVelocityFilter::dynamicReconfigureCB(
     const cob_collision_velocity_filter::CollisionVelocityFilterConfig &config, const uint32_t level)
 {
-  pthread_mutex_lock(&m_mutex);
+  boost::mutex::scoped_lock lock(config_mutex_);
 
   stop_threshold_ = config.stop_threshold;
   obstacle_damping_dist_ = config.obstacle_damping_dist;
@@ -250,12 +309,31 @@ void CollisionVelocityFilter::dynamicReconfigureCB(
 
   if (stop_threshold_ <= 0.0 || influence_radius_ <= 0.0)
     ROS_WARN("Turned off obstacle avoidance!");
-  pthread_mutex_unlock(&m_mutex);
+
+  use_polygon_footprint_ = config.use_polygon_footprint;
+  control_mode_ = config.control_mode;
+  ttc_threshold_ = config.ttc_threshold;
 }
 
 // sets corrected velocity of joystick command
-void CollisionVelocityFilter::performControllerStep()
+void CollisionVelocityFilter::performControllerStep(const ObstacleSnapshot& obstacles)
 {
+  if (!obstacles.valid || ros::Time::now() - obstacles.stamp > obstacle_timeout_)
+  {
+    ROS_WARN_THROTTLE(1.0, "[cob_collision_velocity_filter] No recent obstacle update, stopping the robot!");
+    stopMovement();
+    return;
+  }
+
+  // obstacles determined for another driving direction can't be used, take the closest one in any direction instead
+  const bool command_matches = commandMatches(obstacles);
+  const double closest_obstacle_dist = command_matches ? obstacles.closest_obstacle_dist
+                                                       : obstacles.closest_any_obstacle_dist;
+  const double closest_obstacle_angle = command_matches ? obstacles.closest_obstacle_angle
+                                                        : obstacles.closest_any_obstacle_angle;
+  const double influence_radius = obstacles.influence_radius;
+  const double stop_threshold = obstacles.stop_threshold;
+  const double obstacle_damping_dist = obstacles.obstacle_damping_dist;
 
   double dt;
   double vx_max, vy_max;
@@ -277,23 +355,31 @@ void CollisionVelocityFilter::performControllerStep()
   if (vy_max > fabs(cmd_vel.linear.y))
     vy_max = fabs(cmd_vel.linear.y);
 
+  if (obstacles.time_to_collision_mode)
+  {
+    //Scale command along its path to keep time to collision above threshold:
+    double scale = timeToCollisionScale(obstacles, command_matches);
+    cmd_vel.linear.x *= scale;
+    cmd_vel.linear.y *= scale;
+    cmd_vel.angular.z *= scale;
+  }
   //Slow down in any way while approximating an obstacle:
-  if (closest_obstacle_dist_ < influence_radius_)
+  else if (closest_obstacle_dist < influence_radius)
   {
     double F_x, F_y;
     double vx_d, vy_d, vx_factor, vy_factor;
     double kv_obst = kv_, vx_max_obst = vx_max, vy_max_obst = vy_max;
 
     //implementation for linear decrease of v_max:
-    double obstacle_linear_slope_x = vx_max / (obstacle_damping_dist_ - stop_threshold_);
-    vx_max_obst = (closest_obstacle_dist_ - stop_threshold_ + stop_threshold_ / 10.0f) * obstacle_linear_slope_x;
+    double obstacle_linear_slope_x = vx_max / (obstacle_damping_dist - stop_threshold);
+    vx_max_obst = (closest_obstacle_dist - stop_threshold + stop_threshold / 10.0f) * obstacle_linear_slope_x;
     if (vx_max_obst > vx_max)
       vx_max_obst = vx_max;
     else if (vx_max_obst < 0.0f)
       vx_max_obst = 0.0f;
 
-    double obstacle_linear_slope_y = vy_max / (obstacle_damping_dist_ - stop_threshold_);
-    vy_max_obst = (closest_obstacle_dist_ - stop_threshold_ + stop_threshold_ / 10.0f) * obstacle_linear_slope_y;
+    double obstacle_linear_slope_y = vy_max / (obstacle_damping_dist - stop_threshold);
+    vy_max_obst = (closest_obstacle_dist - stop_threshold + stop_threshold / 10.0f) * obstacle_linear_slope_y;
     if (vy_max_obst > vy_max)
       vy_max_obst = vy_max;
     else if (vy_max_obst < 0.0f)
@@ -301,8 +387,8 @@ void CollisionVelocityFilter::performControllerStep()
 
     //Translational movement
     //calculation of v factor to limit maxspeed
-    double closest_obstacle_dist_x = closest_obstacle_dist_ * cos(closest_obstacle_angle_);
-    double closest_obstacle_dist_y = closest_obstacle_dist_ * sin(closest_obstacle_angle_);
+    double closest_obstacle_dist_x = closest_obstacle_dist * cos(closest_obstacle_angle);
+    double closest_obstacle_dist_y = closest_obstacle_dist * sin(closest_obstacle_angle);
     vx_d = kp_ / kv_obst * closest_obstacle_dist_x;
     vy_d = kp_ / kv_obst * closest_obstacle_dist_y;
     vx_factor = vx_max_obst / sqrt(vy_d * vy_d + vx_d * vx_d);
@@ -354,17 +440,15 @@ void CollisionVelocityFilter::performControllerStep()
       cmd_vel.angular.z = vtheta_last_ - atheta_max_ * dt;
   }
 
-  pthread_mutex_lock(&m_mutex);
   vx_last_ = cmd_vel.linear.x;
   vy_last_ = cmd_vel.linear.y;
   vtheta_last_ = cmd_vel.angular.z;
-  pthread_mutex_unlock(&m_mutex);
 
   velocity_limited_marker_.publishMarkers(cmd_vel_in.linear.x, cmd_vel.linear.x, cmd_vel_in.linear.y, cmd_vel.linear.y,
                                           cmd_vel_in.angular.z, cmd_vel.angular.z);
 
   // if closest obstacle is within stop_threshold, then do not move
-  if (closest_obstacle_dist_ < stop_threshold_)
+  if (closest_obstacle_dist < stop_threshold)
   {
     stopMovement();
   }
@@ -378,221 +462,129 @@ void CollisionVelocityFilter::performControllerStep()
 
 void CollisionVelocityFilter::obstacleHandler()
 {
-  pthread_mutex_lock(&m_mutex);
+  const VelocityCommand& command = command_snapshot_.read();
+
+  boost::mutex::scoped_lock lock(config_mutex_);
   closest_obstacle_dist_ = influence_radius_;
-  pthread_mutex_unlock(&m_mutex);
-
-  double cur_distance_to_center, cur_distance_to_border;
-  double obstacle_theta_robot, obstacle_delta_theta_robot, obstacle_dist_vel_dir;
-  bool cur_obstacle_relevant;
-  geometry_msgs::Point cur_obstacle_robot;
-  geometry_msgs::Point zero_position;
-  zero_position.x = 0.0f;
-  zero_position.y = 0.0f;
-  zero_position.z = 0.0f;
-  bool use_circumscribed = true, use_tube = true;
-
-  //Calculate corner angles in robot_frame:
-  double corner_front_left, corner_rear_left, corner_rear_right, corner_front_right;
-  corner_front_left = atan2(footprint_left_, footprint_front_);
-  corner_rear_left = atan2(footprint_left_, footprint_rear_);
-  corner_rear_right = atan2(footprint_right_, footprint_rear_);
-  corner_front_right = atan2(footprint_right_, footprint_front_);
-
-  //Decide, whether circumscribed or tube argument should be used for filtering:
-  if (fabs(robot_twist_linear_.x) <= 0.005f && fabs(robot_twist_linear_.y) <= 0.005f)
+  closest_any_obstacle_dist_ = influence_radius_;
+
+  //Decide on tube/circumscribed filtering and project footprint onto velocity direction
+  classifier_.setInfluenceRadius(influence_radius_);
+  classifier_.setCommand(command.vx, command.vy, command.vtheta, use_circumscribed_threshold_);
+  const bool time_to_collision_mode = control_mode_
+      == cob_collision_velocity_filter::CollisionVelocityFilter_TIME_TO_COLLISION;
+  double tracking_radius = std::max(influence_radius_, sqrt(classifier_.frame().circumscribed_radius_sq));
+  if (use_polygon_footprint_ || time_to_collision_mode)
   {
-    use_tube = false;
-    //disable tube filter at very slow velocities
+    //footprint may be moved by up to influence_radius along the command
+    tracking_radius = influence_radius_ + footprint_sweep_.radius();
   }
-  if (!use_tube)
+
+  //update tracked obstacles from the cells touched by the last costmap update
+  costmap_2d::Costmap2D* costmap = anti_collision_costmap_->getCostmap();
   {
-    if (fabs(robot_twist_angular_.z) <= 0.01f)
+    boost::unique_lock<costmap_2d::Costmap2D::mutex_t> costmap_lock(*(costmap->getMutex()));
+    const unsigned int size_x = costmap->getSizeInCellsX(), size_y = costmap->getSizeInCellsY();
+    ros::Time now = ros::Time::now();
+
+    //cells touched by all costmap updates since the last cycle, taken before reading the costmap
+    unsigned int x0 = 0, xn = size_x, y0 = 0, yn = size_y;
+    bool updated = true;
+    if (update_bounds_layer_)
+      updated = update_bounds_layer_->consumeBounds(x0, xn, y0, yn);
+
+    if (obstacle_tracker_.outdated(size_x, size_y, costmap->getResolution(), costmap->getOriginX(),
+                                   costmap->getOriginY(), tracking_radius, classifier_.frame()))
     {
-      use_circumscribed = false;
-    } //when tube filter inactive, start circumscribed filter at very low rot-velocities
+      obstacle_tracker_.reset(size_x, size_y, costmap->getResolution(), costmap->getOriginX(), costmap->getOriginY(),
+                              tracking_radius, classifier_.frame());
+      obstacle_tracker_.update(costmap->getCharMap(), costmap_obstacle_treshold_, 0, size_x, 0, size_y);
+      last_obstacle_resync_ = now;
+    }
+    else if (now - last_obstacle_resync_ > obstacle_resync_period_)
+    {
+      //full pass from time to time, in case cells were changed outside of the costmap updates
+      obstacle_tracker_.update(costmap->getCharMap(), costmap_obstacle_treshold_, 0, size_x, 0, size_y);
+      last_obstacle_resync_ = now;
+    }
+    else if (updated)
+    {
+      obstacle_tracker_.update(costmap->getCharMap(), costmap_obstacle_treshold_, x0, xn, y0, yn);
+    }
+  }
+
+  //find closest relevant obstacle, i.e. the one hit first by the swept footprint or the closest one in the tube
+  TrackedObstacle closest, contact;
+  bool contact_found = false;
+  if (use_polygon_footprint_ || time_to_collision_mode)
+  {
+    footprint_sweep_.setCommand(command.vx, command.vy, command.vtheta, influence_radius_,
+                                costmap->getResolution() / 2.0);
+    contact_found = obstacle_tracker_.findFirstContact(footprint_sweep_, influence_radius_, contact);
+  }
+  bool found;
+  if (use_polygon_footprint_)
+  {
+    closest = contact;
+    found = contact_found;
   }
   else
   {
-    if (fabs(robot_twist_angular_.z) <= use_circumscribed_threshold_)
-    {
-      use_circumscribed = false;
-    } //when tube filter running, disable circum-filter in a wider range of rot-velocities
+    found = obstacle_tracker_.findClosest(classifier_, closest_obstacle_dist_, closest);
   }
-
-  //Calculation of tube in driving-dir considered for obstacle avoidence
-  double velocity_angle = 0.0f, velocity_ortho_angle;
-  double corner_angle, delta_corner_angle;
-  double ortho_corner_dist;
-  double tube_left_border = 0.0f, tube_right_border = 0.0f;
-  double tube_left_origin = 0.0f, tube_right_origin = 0.0f;
-  double corner_dist, circumscribed_radius = 0.0f;
-
-  for (unsigned i = 0; i < robot_footprint_.size(); i++)
+  if (found)
   {
-    corner_dist = sqrt(robot_footprint_[i].x * robot_footprint_[i].x + robot_footprint_[i].y * robot_footprint_[i].y);
-    if (corner_dist > circumscribed_radius)
-      circumscribed_radius = corner_dist;
+    ROS_DEBUG_STREAM_NAMED("obstacleHandler", "[cob_collision_velocity_filter] Detected an obstacle");
+    closest_obstacle_dist_ = closest.distance;
+    closest_obstacle_angle_ = atan2(closest.y, closest.x);
   }
-
-  if (use_tube)
+  if (closest.num_inside > 0)
+    ROS_WARN("Found %u obstacles inside robot_footprint: Skip!", (unsigned int)closest.num_inside);
+  if (obstacle_tracker_.findClosestAny(closest_any_obstacle_dist_, closest))
   {
-    //use commanded vel-value for vel-vector direction.. ?
-    velocity_angle = atan2(robot_twist_linear_.y, robot_twist_linear_.x);
-    velocity_ortho_angle = velocity_angle + M_PI / 2.0f;
-
-    for (unsigned i = 0; i < robot_footprint_.size(); i++)
-    {
-      corner_angle = atan2(robot_footprint_[i].y, robot_footprint_[i].x);
-      delta_corner_angle = velocity_ortho_angle - corner_angle;
-      corner_dist = sqrt(robot_footprint_[i].x * robot_footprint_[i].x + robot_footprint_[i].y * robot_footprint_[i].y);
-      ortho_corner_dist = cos(delta_corner_angle) * corner_dist;
-
-      if (ortho_corner_dist < tube_right_border)
-      {
-        tube_right_border = ortho_corner_dist;
-        tube_right_origin = sin(delta_corner_angle) * corner_dist;
-      }
-      else if (ortho_corner_dist > tube_left_border)
-      {
-        tube_left_border = ortho_corner_dist;
-        tube_left_origin = sin(delta_corner_angle) * corner_dist;
-      }
-    }
+    closest_any_obstacle_dist_ = closest.distance;
+    closest_any_obstacle_angle_ = atan2(closest.y, closest.x);
   }
 
-  //find relevant obstacles
-  pthread_mutex_lock(&m_mutex);
-  relevant_obstacles_.header.frame_id = global_frame_;
-  relevant_obstacles_.header.stamp = ros::Time::now();
-  relevant_obstacles_.data.clear();
-  for (unsigned int i = 0;
-      i
-          < anti_collision_costmap_->getCostmap()->getSizeInCellsX()
-              * anti_collision_costmap_->getCostmap()->getSizeInCellsY(); i++)
+  //hand over result to command callback
+  ObstacleSnapshot& obstacles = obstacle_snapshot_.writeBuffer();
+  obstacles.valid = true;
+  obstacles.stamp = ros::Time::now();
+  obstacles.command = command;
+  obstacles.swept = use_polygon_footprint_ || time_to_collision_mode;
+  obstacles.closest_obstacle_dist = closest_obstacle_dist_;
+  obstacles.closest_obstacle_angle = closest_obstacle_angle_;
+  obstacles.closest_any_obstacle_dist = closest_any_obstacle_dist_;
+  obstacles.closest_any_obstacle_angle = closest_any_obstacle_angle_;
+  obstacles.time_to_collision_mode = time_to_collision_mode;
+  obstacles.contact_dist = contact_found ? contact.distance : influence_radius_;
+  obstacles.ttc_threshold = ttc_threshold_;
+  obstacles.footprint_radius = footprint_sweep_.radius();
+  obstacles.influence_radius = influence_radius_;
+  obstacles.stop_threshold = stop_threshold_;
+  obstacles.obstacle_damping_dist = obstacle_damping_dist_;
+  obstacle_snapshot_.publish();
+
+  //relevant obstacles are only marked if someone listens
+  bool publish_relevant_obstacles = topic_pub_relevant_obstacles_.getNumSubscribers() > 0;
+  if (publish_relevant_obstacles)
   {
-    if (anti_collision_costmap_->getCostmap()->getCharMap()[i] == -1)
-    {
-      relevant_obstacles_.data.push_back(-1);
-    }
-    else if (anti_collision_costmap_->getCostmap()->getCharMap()[i] < costmap_obstacle_treshold_)
-    { // add trshold
-      relevant_obstacles_.data.push_back(0);
-    }
+    relevant_obstacles_.header.frame_id = global_frame_;
+    relevant_obstacles_.header.stamp = ros::Time::now();
+    relevant_obstacles_.data.assign(costmap->getSizeInCellsX() * costmap->getSizeInCellsY(), 0);
+    if (use_polygon_footprint_)
+      obstacle_tracker_.markContacts(footprint_sweep_, relevant_obstacles_.data);
     else
-    {
-
-      // calculate cell in 2D space where robot is is point (0, 0)
-      geometry_msgs::Point cell;
-      cell.x = (i % (int)(anti_collision_costmap_->getCostmap()->getSizeInCellsX()))
-          * anti_collision_costmap_->getCostmap()->getResolution()
-          + anti_collision_costmap_->getCostmap()->getOriginX();
-      cell.y = (i / (int)(anti_collision_costmap_->getCostmap()->getSizeInCellsX()))
-          * anti_collision_costmap_->getCostmap()->getResolution()
-          + anti_collision_costmap_->getCostmap()->getOriginY();
-      cell.z = 0.0f;
-
-      cur_obstacle_relevant = false;
-      cur_distance_to_center = getDistance2d(zero_position, cell);
-      //check whether current obstacle lies inside the circumscribed_radius of the robot -> prevent collisions while rotating
-      if (use_circumscribed && cur_distance_to_center <= circumscribed_radius)
-      {
-        cur_obstacle_robot = cell;
-
-        if (obstacleValid(cur_obstacle_robot.x, cur_obstacle_robot.y))
-        {
-          cur_obstacle_relevant = true;
-          obstacle_theta_robot = atan2(cur_obstacle_robot.y, cur_obstacle_robot.x);
-        }
-
-        //for each obstacle, now check whether it lies in the tube or not:
-      }
-      else if (use_tube && cur_distance_to_center < influence_radius_)
-      {
-        cur_obstacle_robot = cell;
-
-        if (obstacleValid(cur_obstacle_robot.x, cur_obstacle_robot.y))
-        {
-          obstacle_theta_robot = atan2(cur_obstacle_robot.y, cur_obstacle_robot.x);
-          obstacle_delta_theta_robot = obstacle_theta_robot - velocity_angle;
-          obstacle_dist_vel_dir = sin(obstacle_delta_theta_robot) * cur_distance_to_center;
-
-          if (obstacle_dist_vel_dir <= tube_left_border && obstacle_dist_vel_dir >= tube_right_border)
-          {
-            //found obstacle that lies inside of observation tube
-
-            if (sign(obstacle_dist_vel_dir) >= 0)
-            {
-              if (cos(obstacle_delta_theta_robot) * cur_distance_to_center >= tube_left_origin)
-              {
-                //relevant obstacle in tube found
-                cur_obstacle_relevant = true;
-              }
-            }
-            else
-            { // obstacle in right part of tube
-              if (cos(obstacle_delta_theta_robot) * cur_distance_to_center >= tube_right_origin)
-              {
-                //relevant obstacle in tube found
-                cur_obstacle_relevant = true;
-              }
-            }
-          }
-        }
-      }
-
-      if (cur_obstacle_relevant)
-      {
-        ROS_DEBUG_STREAM_NAMED("obstacleHandler", "[cob_collision_velocity_filter] Detected an obstacle");
-        //relevant obstacle in tube found
-        relevant_obstacles_.data.push_back(100);
-
-        //now calculate distance of current, relevant obstacle to robot
-        if (obstacle_theta_robot >= corner_front_right && obstacle_theta_robot < corner_front_left)
-        {
-          //obstacle in front:
-          cur_distance_to_border = cur_distance_to_center - fabs(footprint_front_) / fabs(cos(obstacle_theta_robot));
-        }
-        else if (obstacle_theta_robot >= corner_front_left && obstacle_theta_robot < corner_rear_left)
-        {
-          //obstacle left:
-          cur_distance_to_border = cur_distance_to_center - fabs(footprint_left_) / fabs(sin(obstacle_theta_robot));
-        }
-        else if (obstacle_theta_robot >= corner_rear_left || obstacle_theta_robot < corner_rear_right)
-        {
-          //obstacle in rear:
-          cur_distance_to_border = cur_distance_to_center - fabs(footprint_rear_) / fabs(cos(obstacle_theta_robot));
-        }
-        else
-        {
-          //obstacle right:
-          cur_distance_to_border = cur_distance_to_center - fabs(footprint_right_) / fabs(sin(obstacle_theta_robot));
-        }
-
-        if (cur_distance_to_border < closest_obstacle_dist_)
-        {
-          closest_obstacle_dist_ = cur_distance_to_border;
-          closest_obstacle_angle_ = obstacle_theta_robot;
-        }
-      }
-      else
-      {
-        relevant_obstacles_.data.push_back(0);
-      }
-    }
+      obstacle_tracker_.markRelevant(classifier_, relevant_obstacles_.data);
   }
-  pthread_mutex_unlock(&m_mutex);
+  lock.unlock();
 
-  topic_pub_relevant_obstacles_.publish(relevant_obstacles_);
+  if (publish_relevant_obstacles)
+    topic_pub_relevant_obstacles_.publish(relevant_obstacles_);
   ROS_DEBUG_STREAM_NAMED("obstacleHandler",
                          "[cob_collision_velocity_filter] closest_obstacle_dist_ = " << closest_obstacle_dist_);
 }
 
-double CollisionVelocityFilter::getDistance2d(geometry_msgs::Point a, geometry_msgs::Point b)
-{
-  return sqrt(pow(a.x - b.x, 2) + pow(a.y - b.y, 2));
-}
-
 double CollisionVelocityFilter::sign(double x)
 {
   if (x >= 0.0f)
@@ -601,14 +593,80 @@ double CollisionVelocityFilter::sign(double x)
     return -1.0f;
 }
 
-bool CollisionVelocityFilter::obstacleValid(double x_obstacle, double y_obstacle)
+double CollisionVelocityFilter::timeToCollisionScale(const ObstacleSnapshot& obstacles, bool command_matches)
 {
-  if (x_obstacle < footprint_front_ && x_obstacle > footprint_rear_ && y_obstacle > footprint_right_
-      && y_obstacle < footprint_left_)
+  const double vx = robot_twist_linear_.x, vy = robot_twist_linear_.y, vtheta = robot_twist_angular_.z;
+
+  // upper bound of the speed of any footprint point
+  const double v = sqrt(vx * vx + vy * vy);
+  const double speed = v + fabs(vtheta) * obstacles.footprint_radius;
+  if (speed <= 0.0)
+    return 1.0;
+
+  double contact_dist;
+  if (command_matches)
   {
-    ROS_WARN("Found an obstacle inside robot_footprint: Skip!");
-    return false;
+    // the path matches the swept one, but the command may be faster or slower than the swept command
+    contact_dist = obstacles.contact_dist;
+  }
+  else
+  {
+    // path of the current command unknown, assume it heads straight for the closest obstacle
+    contact_dist = obstacles.closest_any_obstacle_dist;
   }
+  if (contact_dist >= obstacles.influence_radius)
+    return 1.0;
+  const double time_to_collision = contact_dist / speed;
+
+  // scaling the command by s scales the time to collision by 1/s
+  double scale = time_to_collision / obstacles.ttc_threshold;
+
+  // it must be possible to stop at stop_threshold from the scaled command
+  const double braking_dist = contact_dist - obstacles.stop_threshold;
+  if (braking_dist <= 0.0)
+    return 0.0;
+
+  // max_acceleration is used as deceleration limit as well, like in performControllerStep: translation and
+  // rotation stop independently, the footprint point moves by v^2 / 2a plus r * w^2 / 2alpha until then, which both
+  // grow with s^2
+  const double a = std::min(ax_max_, ay_max_);
+  double braking_dist_unscaled = 0.0;
+  if (v > 0.0)
+    braking_dist_unscaled += (a > 0.0) ? v * v / (2.0 * a) : std::numeric_limits<double>::infinity();
+  if (vtheta != 0.0)
+    braking_dist_unscaled += (atheta_max_ > 0.0)
+        ? obstacles.footprint_radius * vtheta * vtheta / (2.0 * atheta_max_) : std::numeric_limits<double>::infinity();
+  scale = std::min(scale, sqrt(braking_dist / braking_dist_unscaled));
+
+  return std::max(0.0, std::min(1.0, scale));
+}
+
+bool CollisionVelocityFilter::commandMatches(const ObstacleSnapshot& obstacles) const
+{
+  // maximum angle between the driving directions (10 deg)
+  static const double cos_direction_tolerance = cos(10.0 / 180.0 * M_PI);
+
+  const double vx = robot_twist_linear_.x, vy = robot_twist_linear_.y, vtheta = robot_twist_angular_.z;
+  const VelocityCommand& snapshot = obstacles.command;
+
+  // same decision on tube filtering as in ObstacleClassifier::setCommand
+  const bool use_tube = !(fabs(vx) <= 0.005f && fabs(vy) <= 0.005f);
+  const bool snapshot_use_tube = !(fabs(snapshot.vx) <= 0.005f && fabs(snapshot.vy) <= 0.005f);
+  if (use_tube != snapshot_use_tube)
+    return false;
+  if (use_tube
+      && vx * snapshot.vx + vy * snapshot.vy
+          < cos_direction_tolerance * sqrt(vx * vx + vy * vy) * sqrt(snapshot.vx * snapshot.vx + snapshot.vy * snapshot.vy))
+    return false;
+
+  // circumscribed filtering needed, but not done for snapshot
+  const double circumscribed_threshold = use_tube ? use_circumscribed_threshold_ : 0.01f;
+  if (fabs(vtheta) > circumscribed_threshold && fabs(snapshot.vtheta) <= circumscribed_threshold)
+    return false;
+
+  // swept footprint depends on rotational velocity as well (0.1 rad/s)
+  if (obstacles.swept && fabs(vtheta - snapshot.vtheta) > 0.1)
+    return false;
 
   return true;
 }
@@ -635,6 +693,28 @@ int main(int argc, char** argv)
   // initialize ROS, spezify name of node
   ros::init(argc, argv, "cob_collision_velocity_filter");
 
+  // append the UpdateBoundsLayer to the costmap layers, so no costmap update is missed by the obstacle tracking
+  ros::NodeHandle costmap_nh("~anti_collision_costmap");
+  XmlRpc::XmlRpcValue plugins;
+  if (costmap_nh.getParam("plugins", plugins) && plugins.getType() == XmlRpc::XmlRpcValue::TypeArray)
+  {
+    bool found = false;
+    for (int i = 0; i < plugins.size(); i++)
+    {
+      if (plugins[i].hasMember("type")
+          && static_cast<std::string>(plugins[i]["type"]) == "cob_collision_velocity_filter::UpdateBoundsLayer")
+        found = true;
+    }
+    if (!found)
+    {
+      XmlRpc::XmlRpcValue layer;
+      layer["name"] = std::string("update_bounds_layer");
+      layer["type"] = std::string("cob_collision_velocity_filter::UpdateBoundsLayer");
+      plugins[plugins.size()] = layer;
+      costmap_nh.setParam("plugins", plugins);
+    }
+  }
+
   // create nodeClass
   tf::TransformListener tf(ros::Duration(10));
   costmap_2d::Costmap2DROS* costmap = new costmap_2d::Costmap2DROS("anti_collision_costmap", tf);
@@ -0,0 +1,284 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#include <footprint_sweep.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cob_collision_velocity_filter
+{
+
+namespace
+{
+
+// maximum number of sweep steps per command
+const size_t MAX_STEPS = 200;
+
+// edges with |n * d| below this are treated as parallel to the translation
+const double PARALLEL_EPS = 1e-12;
+
+bool lessXY(const Point2D& a, const Point2D& b)
+{
+  return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+double cross(const Point2D& o, const Point2D& a, const Point2D& b)
+{
+  return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// counter-clockwise convex hull (monotone chain)
+std::vector<Point2D> convexHull(std::vector<Point2D> points)
+{
+  if (points.size() < 3)
+    return points;
+  std::sort(points.begin(), points.end(), lessXY);
+
+  std::vector<Point2D> hull(2 * points.size());
+  size_t k = 0;
+  for (size_t i = 0; i < points.size(); i++)
+  {
+    while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0.0)
+      k--;
+    hull[k++] = points[i];
+  }
+  for (size_t i = points.size() - 1, t = k + 1; i > 0; i--)
+  {
+    while (k >= t && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0)
+      k--;
+    hull[k++] = points[i - 1];
+  }
+  hull.resize(k - 1);
+  return hull;
+}
+
+}
+
+FootprintSweep::FootprintSweep()
+  : radius_(0.0), speed_bound_(0.0), use_avx2_(kernels::avx2Available())
+{
+}
+
+void FootprintSweep::enableAvx2(bool enable)
+{
+  use_avx2_ = enable && kernels::avx2Available();
+}
+
+bool FootprintSweep::setFootprint(const std::vector<Point2D>& footprint)
+{
+  hull_ = convexHull(footprint);
+  steps_.clear();
+
+  normals_.resize(hull_.size());
+  offsets_.resize(hull_.size());
+  radius_ = 0.0;
+  for (size_t i = 0; i < hull_.size(); i++)
+  {
+    const Point2D& a = hull_[i];
+    const Point2D& b = hull_[(i + 1) % hull_.size()];
+    double length = sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+    normals_[i].x = (b.y - a.y) / length;
+    normals_[i].y = -(b.x - a.x) / length;
+    offsets_[i] = normals_[i].x * a.x + normals_[i].y * a.y;
+    radius_ = std::max(radius_, sqrt(a.x * a.x + a.y * a.y));
+  }
+  return hull_.size() == footprint.size();
+}
+
+void FootprintSweep::setCommand(double vx, double vy, double vtheta, double max_contact_distance, double tolerance)
+{
+  steps_.clear();
+  edges_.clear();
+
+  // same thresholds as the tube and circumscribed decision of the ObstacleClassifier
+  const bool moving = !(fabs(vx) <= 0.005f && fabs(vy) <= 0.005f);
+  const bool rotating = fabs(vtheta) > 0.01f;
+  if (hull_.size() < 3 || (!moving && !rotating))
+    return;
+
+  const double v = moving ? sqrt(vx * vx + vy * vy) : 0.0;
+  const double w = rotating ? vtheta : 0.0;
+  speed_bound_ = v + fabs(w) * radius_;
+
+  // sweep until the footprint moved max_contact_distance, at most one full turn
+  double horizon = max_contact_distance / speed_bound_;
+  if (rotating)
+    horizon = std::min(horizon, 2.0 * M_PI / fabs(w));
+
+  // rotation within a step displaces footprint points by at most radius * |w| * dt, the chord of the
+  // curved path deviates from it by at most v * |w| * dt^2 / 8
+  size_t num_steps = 1;
+  if (rotating && radius_ > 0.0)
+    num_steps = std::min(MAX_STEPS, (size_t)ceil(horizon * radius_ * fabs(w) / tolerance));
+  num_steps = std::max(num_steps, (size_t)1);
+  const double dt = horizon / num_steps;
+  const double inflation = fabs(w) * dt * (radius_ + v * dt / 8.0);
+
+  steps_.resize(num_steps);
+  edges_.resize(num_steps * hull_.size());
+  for (size_t k = 0; k < num_steps; k++)
+  {
+    const double t0 = k * dt, t1 = (k + 1) * dt;
+    double theta = w * t0;
+    double px0, py0, px1, py1;
+    if (rotating)
+    {
+      // exact pose of the robot driving a constant twist
+      px0 = (vx * sin(w * t0) - vy * (1.0 - cos(w * t0))) / w;
+      py0 = (vx * (1.0 - cos(w * t0)) + vy * sin(w * t0)) / w;
+      px1 = (vx * sin(w * t1) - vy * (1.0 - cos(w * t1))) / w;
+      py1 = (vx * (1.0 - cos(w * t1)) + vy * sin(w * t1)) / w;
+    }
+    else
+    {
+      px0 = vx * t0;
+      py0 = vy * t0;
+      px1 = vx * t1;
+      py1 = vy * t1;
+    }
+    if (!moving)
+    {
+      px0 = py0 = px1 = py1 = 0.0;
+    }
+    const double dx = px1 - px0, dy = py1 - py0;
+    const double cos_theta = cos(theta), sin_theta = sin(theta);
+
+    steps_[k].t0 = t0;
+    steps_[k].dt = dt;
+    steps_[k].first_edge = k * hull_.size();
+    for (size_t e = 0; e < hull_.size(); e++)
+    {
+      SweepEdge& edge = edges_[k * hull_.size() + e];
+      edge.nx = cos_theta * normals_[e].x - sin_theta * normals_[e].y;
+      edge.ny = sin_theta * normals_[e].x + cos_theta * normals_[e].y;
+      edge.c = offsets_[e] + edge.nx * px0 + edge.ny * py0 + inflation;
+      const double b = edge.nx * dx + edge.ny * dy;
+      if (fabs(b) < PARALLEL_EPS)
+      {
+        edge.kind = SweepEdge::PARALLEL;
+        edge.inv_b = 0.0;
+      }
+      else
+      {
+        edge.kind = b > 0.0 ? SweepEdge::LOWER : SweepEdge::UPPER;
+        edge.inv_b = 1.0 / b;
+      }
+    }
+  }
+}
+
+bool FootprintSweep::inside(double x, double y) const
+{
+  if (hull_.size() < 3)
+    return false;
+  for (size_t e = 0; e < hull_.size(); e++)
+  {
+    if (normals_[e].x * x + normals_[e].y * y >= offsets_[e])
+      return false;
+  }
+  return true;
+}
+
+double FootprintSweep::clearance(double x, double y) const
+{
+  // the distance to a convex polygon is at least the distance to the line of any edge
+  double d = 0.0;
+  for (size_t e = 0; e < hull_.size(); e++)
+    d = std::max(d, normals_[e].x * x + normals_[e].y * y - offsets_[e]);
+  return d;
+}
+
+size_t FootprintSweep::contactStep(size_t step, const double* x, const double* y, size_t n,
+                                   double* contact_time) const
+{
+  const SweepStep& s = steps_[step];
+  if (use_avx2_)
+    return kernels::contactAvx2(s, &edges_[s.first_edge], hull_.size(), x, y, n, contact_time);
+  return kernels::contactScalar(s, &edges_[s.first_edge], hull_.size(), x, y, 0, n, contact_time);
+}
+
+namespace kernels
+{
+
+size_t contactScalar(const SweepStep& step, const SweepEdge* edges, size_t num_edges, const double* x,
+                     const double* y, size_t begin, size_t end, double* contact_time)
+{
+  size_t contacts = 0;
+  for (size_t i = begin; i < end; i++)
+  {
+    double lower = 0.0, upper = 1.0;
+    bool excluded = false;
+    for (size_t e = 0; e < num_edges; e++)
+    {
+      const double a = edges[e].nx * x[i] + edges[e].ny * y[i] - edges[e].c;
+      if (edges[e].kind == SweepEdge::LOWER)
+        lower = std::max(lower, a * edges[e].inv_b);
+      else if (edges[e].kind == SweepEdge::UPPER)
+        upper = std::min(upper, a * edges[e].inv_b);
+      else if (a > 0.0)
+        excluded = true;
+    }
+    if (excluded || lower > upper)
+      continue;
+
+    contacts++;
+    const double t = step.t0 + lower * step.dt;
+    if (t < contact_time[i])
+      contact_time[i] = t;
+  }
+  return contacts;
+}
+
+#ifndef COB_COLLISION_VELOCITY_FILTER_AVX2
+size_t contactAvx2(const SweepStep& step, const SweepEdge* edges, size_t num_edges, const double* x,
+                   const double* y, size_t n, double* contact_time)
+{
+  return contactScalar(step, edges, num_edges, x, y, 0, n, contact_time);
+}
+#endif
+
+}
+
+}
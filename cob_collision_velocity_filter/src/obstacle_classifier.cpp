@@ -0,0 +1,266 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#include <obstacle_classifier.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace cob_collision_velocity_filter
+{
+
+ObstacleClassifier::ObstacleClassifier()
+  : influence_radius_(0.0), use_avx2_(kernels::avx2Available())
+{
+  setFootprint(std::vector<Point2D>(), 0.0, 0.0, 0.0, 0.0);
+  setCommand(0.0, 0.0, 0.0, 0.0);
+}
+
+void ObstacleClassifier::enableAvx2(bool enable)
+{
+  use_avx2_ = enable && kernels::avx2Available();
+}
+
+void ObstacleClassifier::setFootprint(const std::vector<Point2D>& footprint, double front, double rear, double left,
+                                      double right)
+{
+  footprint_ = footprint;
+
+  frame_.front = front;
+  frame_.rear = rear;
+  frame_.left = left;
+  frame_.right = right;
+  frame_.abs_front = fabs(front);
+  frame_.abs_rear = fabs(rear);
+  frame_.abs_left = fabs(left);
+  frame_.abs_right = fabs(right);
+
+  frame_.circumscribed_radius_sq = 0.0;
+  for (unsigned i = 0; i < footprint_.size(); i++)
+  {
+    double corner_dist_sq = footprint_[i].x * footprint_[i].x + footprint_[i].y * footprint_[i].y;
+    if (corner_dist_sq > frame_.circumscribed_radius_sq)
+      frame_.circumscribed_radius_sq = corner_dist_sq;
+  }
+}
+
+void ObstacleClassifier::setInfluenceRadius(double influence_radius)
+{
+  influence_radius_ = influence_radius;
+  frame_.influence_radius_sq = influence_radius * influence_radius;
+}
+
+void ObstacleClassifier::setCommand(double vx, double vy, double vtheta, double use_circumscribed_threshold)
+{
+  //Decide, whether circumscribed or tube argument should be used for filtering:
+  frame_.use_tube = true;
+  frame_.use_circumscribed = true;
+  if (fabs(vx) <= 0.005f && fabs(vy) <= 0.005f)
+  {
+    frame_.use_tube = false;
+    //disable tube filter at very slow velocities
+  }
+  if (!frame_.use_tube)
+  {
+    if (fabs(vtheta) <= 0.01f)
+      frame_.use_circumscribed = false; //when tube filter inactive, start circumscribed filter at very low rot-velocities
+  }
+  else
+  {
+    if (fabs(vtheta) <= use_circumscribed_threshold)
+      frame_.use_circumscribed = false; //when tube filter running, disable circum-filter in a wider range of rot-velocities
+  }
+
+  frame_.ux = 1.0;
+  frame_.uy = 0.0;
+  frame_.tube_left_border = 0.0;
+  frame_.tube_right_border = 0.0;
+  frame_.tube_left_origin = 0.0;
+  frame_.tube_right_origin = 0.0;
+
+  if (frame_.use_tube)
+  {
+    double v = sqrt(vx * vx + vy * vy);
+    frame_.ux = vx / v;
+    frame_.uy = vy / v;
+  }
+  frame_.nx = -frame_.uy;
+  frame_.ny = frame_.ux;
+
+  if (frame_.use_tube)
+  {
+    //project the corners onto the velocity normal (tube width) and the velocity direction (tube origin)
+    for (unsigned i = 0; i < footprint_.size(); i++)
+    {
+      double ortho_corner_dist = frame_.nx * footprint_[i].x + frame_.ny * footprint_[i].y;
+      double corner_origin = frame_.ux * footprint_[i].x + frame_.uy * footprint_[i].y;
+
+      if (ortho_corner_dist < frame_.tube_right_border)
+      {
+        frame_.tube_right_border = ortho_corner_dist;
+        frame_.tube_right_origin = corner_origin;
+      }
+      else if (ortho_corner_dist > frame_.tube_left_border)
+      {
+        frame_.tube_left_border = ortho_corner_dist;
+        frame_.tube_left_origin = corner_origin;
+      }
+    }
+  }
+}
+
+double ObstacleClassifier::relevantRadius() const
+{
+  double radius_sq = 0.0;
+  if (frame_.use_tube)
+    radius_sq = frame_.influence_radius_sq;
+  if (frame_.use_circumscribed && frame_.circumscribed_radius_sq > radius_sq)
+    radius_sq = frame_.circumscribed_radius_sq;
+  return sqrt(radius_sq);
+}
+
+void ObstacleClassifier::classify(const double* x, const double* y, size_t n, unsigned char* relevant,
+                                  ClosestObstacle& closest) const
+{
+  closest.index = -1;
+  closest.num_inside = 0;
+  if (!frame_.use_tube && !frame_.use_circumscribed)
+  {
+    if (relevant)
+      std::fill(relevant, relevant + n, 0);
+    return;
+  }
+
+  if (use_avx2_)
+    kernels::classifyAvx2(frame_, x, y, n, relevant, closest);
+  else
+    kernels::classifyScalar(frame_, x, y, 0, n, relevant, closest);
+}
+
+namespace kernels
+{
+
+double borderDistance(const ClassifierFrame& f, double x, double y, double r)
+{
+  // sectors are bounded by the rays through the footprint corners, tested by the sign of the cross products
+  double cross_front_right = f.front * y - f.right * x;
+  double cross_front_left = f.front * y - f.left * x;
+  double cross_rear_left = f.rear * y - f.left * x;
+  double cross_rear_right = f.rear * y - f.right * x;
+
+  if (cross_front_right >= 0.0 && cross_front_left < 0.0)
+    return r - f.abs_front * r / fabs(x); //obstacle in front
+  else if (cross_front_left >= 0.0 && cross_rear_left < 0.0)
+    return r - f.abs_left * r / fabs(y); //obstacle left
+  else if (cross_rear_left >= 0.0 && cross_rear_right < 0.0)
+    return r - f.abs_rear * r / fabs(x); //obstacle in rear
+  else
+    return r - f.abs_right * r / fabs(y); //obstacle right
+}
+
+void classifyScalar(const ClassifierFrame& f, const double* x, const double* y, size_t begin, size_t end,
+                    unsigned char* relevant, ClosestObstacle& closest)
+{
+  for (size_t i = begin; i < end; i++)
+  {
+    const double xi = x[i], yi = y[i];
+    const double r_sq = xi * xi + yi * yi;
+    const bool in_circumscribed = f.use_circumscribed && r_sq <= f.circumscribed_radius_sq;
+    bool is_relevant = false;
+
+    if (in_circumscribed || (f.use_tube && r_sq < f.influence_radius_sq))
+    {
+      if (xi < f.front && xi > f.rear && yi > f.right && yi < f.left)
+      {
+        closest.num_inside++;
+      }
+      else if (in_circumscribed)
+      {
+        is_relevant = true;
+      }
+      else
+      {
+        const double dist_vel_dir = f.nx * xi + f.ny * yi;
+        if (dist_vel_dir <= f.tube_left_border && dist_vel_dir >= f.tube_right_border)
+        {
+          const double dist_along_vel = f.ux * xi + f.uy * yi;
+          is_relevant = dist_along_vel >= (dist_vel_dir >= 0.0 ? f.tube_left_origin : f.tube_right_origin);
+        }
+      }
+    }
+
+    if (relevant)
+      relevant[i] = is_relevant ? 100 : 0;
+
+    if (is_relevant)
+    {
+      double dist = borderDistance(f, xi, yi, sqrt(r_sq));
+      if (dist < closest.distance)
+      {
+        closest.distance = dist;
+        closest.index = i;
+      }
+    }
+  }
+}
+
+bool avx2Available()
+{
+#if defined(COB_COLLISION_VELOCITY_FILTER_AVX2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+#ifndef COB_COLLISION_VELOCITY_FILTER_AVX2
+void classifyAvx2(const ClassifierFrame& f, const double* x, const double* y, size_t n, unsigned char* relevant,
+                  ClosestObstacle& closest)
+{
+  classifyScalar(f, x, y, 0, n, relevant, closest);
+}
+#endif
+
+}
+
+}
@@ -0,0 +1,541 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+//
+// Micro-benchmark of the obstacle classification stage on a dense 200x200 costmap.
+// Compares the scalar and the AVX2 kernel against the trigonometric reference formulation
+// that obstacleHandler used before and reports mismatches and the time per cycle.
+// The incremental ObstacleTracker is checked against and timed like the full classification,
+// the swept polygon footprint is checked against a densely sampled motion.
+//
+#include <obstacle_classifier.h>
+#include <obstacle_tracker.h>
+#include <footprint_sweep.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+using namespace cob_collision_velocity_filter;
+
+namespace
+{
+
+struct Costmap
+{
+  unsigned size_x, size_y;
+  double resolution, origin_x, origin_y;
+  std::vector<unsigned char> data;
+};
+
+struct Footprint
+{
+  std::vector<Point2D> points;
+  double front, rear, left, right;
+};
+
+double sign(double x)
+{
+  return x >= 0.0f ? 1.0f : -1.0f;
+}
+
+// former obstacleHandler loop, kept as reference for the projection based kernels
+void referenceClassify(const Costmap& map, const Footprint& fp, double vx, double vy, double vtheta,
+                       double influence_radius, double use_circumscribed_threshold, std::vector<unsigned char>& relevant,
+                       double& closest_dist, double& closest_angle)
+{
+  closest_dist = influence_radius;
+  bool use_circumscribed = true, use_tube = true;
+  double corner_front_left = atan2(fp.left, fp.front);
+  double corner_rear_left = atan2(fp.left, fp.rear);
+  double corner_rear_right = atan2(fp.right, fp.rear);
+  double corner_front_right = atan2(fp.right, fp.front);
+
+  if (fabs(vx) <= 0.005f && fabs(vy) <= 0.005f)
+    use_tube = false;
+  if (!use_tube)
+  {
+    if (fabs(vtheta) <= 0.01f)
+      use_circumscribed = false;
+  }
+  else if (fabs(vtheta) <= use_circumscribed_threshold)
+    use_circumscribed = false;
+
+  double velocity_angle = 0.0f, velocity_ortho_angle;
+  double tube_left_border = 0.0f, tube_right_border = 0.0f;
+  double tube_left_origin = 0.0f, tube_right_origin = 0.0f;
+  double corner_dist, circumscribed_radius = 0.0f;
+  for (unsigned i = 0; i < fp.points.size(); i++)
+  {
+    corner_dist = sqrt(fp.points[i].x * fp.points[i].x + fp.points[i].y * fp.points[i].y);
+    if (corner_dist > circumscribed_radius)
+      circumscribed_radius = corner_dist;
+  }
+  if (use_tube)
+  {
+    velocity_angle = atan2(vy, vx);
+    velocity_ortho_angle = velocity_angle + M_PI / 2.0f;
+    for (unsigned i = 0; i < fp.points.size(); i++)
+    {
+      double corner_angle = atan2(fp.points[i].y, fp.points[i].x);
+      double delta_corner_angle = velocity_ortho_angle - corner_angle;
+      corner_dist = sqrt(fp.points[i].x * fp.points[i].x + fp.points[i].y * fp.points[i].y);
+      double ortho_corner_dist = cos(delta_corner_angle) * corner_dist;
+      if (ortho_corner_dist < tube_right_border)
+      {
+        tube_right_border = ortho_corner_dist;
+        tube_right_origin = sin(delta_corner_angle) * corner_dist;
+      }
+      else if (ortho_corner_dist > tube_left_border)
+      {
+        tube_left_border = ortho_corner_dist;
+        tube_left_origin = sin(delta_corner_angle) * corner_dist;
+      }
+    }
+  }
+
+  relevant.assign(map.data.size(), 0);
+  for (unsigned i = 0; i < map.data.size(); i++)
+  {
+    if (map.data[i] < 250)
+      continue;
+    double x = (i % map.size_x) * map.resolution + map.origin_x;
+    double y = (i / map.size_x) * map.resolution + map.origin_y;
+    double cur_distance_to_center = sqrt(pow(x, 2) + pow(y, 2));
+    bool valid = !(x < fp.front && x > fp.rear && y > fp.right && y < fp.left);
+    bool cur_obstacle_relevant = false;
+    double obstacle_theta_robot = 0.0;
+    if (use_circumscribed && cur_distance_to_center <= circumscribed_radius)
+    {
+      if (valid)
+      {
+        cur_obstacle_relevant = true;
+        obstacle_theta_robot = atan2(y, x);
+      }
+    }
+    else if (use_tube && cur_distance_to_center < influence_radius)
+    {
+      if (valid)
+      {
+        obstacle_theta_robot = atan2(y, x);
+        double obstacle_delta_theta_robot = obstacle_theta_robot - velocity_angle;
+        double obstacle_dist_vel_dir = sin(obstacle_delta_theta_robot) * cur_distance_to_center;
+        if (obstacle_dist_vel_dir <= tube_left_border && obstacle_dist_vel_dir >= tube_right_border)
+        {
+          double origin = sign(obstacle_dist_vel_dir) >= 0 ? tube_left_origin : tube_right_origin;
+          if (cos(obstacle_delta_theta_robot) * cur_distance_to_center >= origin)
+            cur_obstacle_relevant = true;
+        }
+      }
+    }
+    if (!cur_obstacle_relevant)
+      continue;
+    relevant[i] = 100;
+    double cur_distance_to_border;
+    if (obstacle_theta_robot >= corner_front_right && obstacle_theta_robot < corner_front_left)
+      cur_distance_to_border = cur_distance_to_center - fabs(fp.front) / fabs(cos(obstacle_theta_robot));
+    else if (obstacle_theta_robot >= corner_front_left && obstacle_theta_robot < corner_rear_left)
+      cur_distance_to_border = cur_distance_to_center - fabs(fp.left) / fabs(sin(obstacle_theta_robot));
+    else if (obstacle_theta_robot >= corner_rear_left || obstacle_theta_robot < corner_rear_right)
+      cur_distance_to_border = cur_distance_to_center - fabs(fp.rear) / fabs(cos(obstacle_theta_robot));
+    else
+      cur_distance_to_border = cur_distance_to_center - fabs(fp.right) / fabs(sin(obstacle_theta_robot));
+    if (cur_distance_to_border < closest_dist)
+    {
+      closest_dist = cur_distance_to_border;
+      closest_angle = obstacle_theta_robot;
+    }
+  }
+}
+
+// gathers the occupied cells within the relevant radius and classifies them, as obstacleHandler does
+void gatherCells(const Costmap& map, const ObstacleClassifier& classifier, std::vector<double>& x,
+                 std::vector<double>& y, std::vector<unsigned>& cells)
+{
+  x.clear();
+  y.clear();
+  cells.clear();
+  const double radius = classifier.relevantRadius();
+  const int x0 = std::max(0, (int)floor((-radius - map.origin_x) / map.resolution));
+  const int xn = std::min((int)map.size_x, (int)ceil((radius - map.origin_x) / map.resolution) + 1);
+  const int y0 = std::max(0, (int)floor((-radius - map.origin_y) / map.resolution));
+  const int yn = std::min((int)map.size_y, (int)ceil((radius - map.origin_y) / map.resolution) + 1);
+  for (int j = y0; j < yn; j++)
+  {
+    for (int k = x0; k < xn; k++)
+    {
+      unsigned i = j * map.size_x + k;
+      if (map.data[i] < 250)
+        continue;
+      x.push_back((i % map.size_x) * map.resolution + map.origin_x);
+      y.push_back((i / map.size_x) * map.resolution + map.origin_y);
+      cells.push_back(i);
+    }
+  }
+}
+
+void kernelClassify(const Costmap& map, const ObstacleClassifier& classifier, double influence_radius,
+                    std::vector<double>& x, std::vector<double>& y, std::vector<unsigned>& cells,
+                    std::vector<unsigned char>& cell_relevant, std::vector<unsigned char>& relevant,
+                    double& closest_dist, double& closest_angle)
+{
+  gatherCells(map, classifier, x, y, cells);
+  cell_relevant.resize(cells.size() + 1);
+
+  ClosestObstacle closest;
+  closest.distance = influence_radius;
+  classifier.classify(&x[0], &y[0], x.size(), &cell_relevant[0], closest);
+
+  relevant.assign(map.data.size(), 0);
+  for (unsigned j = 0; j < cells.size(); j++)
+    relevant[cells[j]] = cell_relevant[j];
+  closest_dist = closest.distance;
+  if (closest.index >= 0)
+    closest_angle = atan2(y[closest.index], x[closest.index]);
+}
+
+// first contact of the footprint with a point found by densely sampling the motion
+double referenceContact(const std::vector<Point2D>& polygon, double vx, double vy, double vtheta, double horizon,
+                        double px, double py)
+{
+  const int samples = 20000;
+  for (int s = 0; s <= samples; s++)
+  {
+    double t = horizon * s / samples, theta = vtheta * t, tx, ty;
+    if (fabs(vtheta) > 0.01)
+    {
+      tx = (vx * sin(theta) - vy * (1.0 - cos(theta))) / vtheta;
+      ty = (vx * (1.0 - cos(theta)) + vy * sin(theta)) / vtheta;
+    }
+    else
+    {
+      tx = vx * t;
+      ty = vy * t;
+    }
+    double qx = cos(theta) * (px - tx) + sin(theta) * (py - ty);
+    double qy = -sin(theta) * (px - tx) + cos(theta) * (py - ty);
+    bool inside = true;
+    for (size_t e = 0; e < polygon.size() && inside; e++)
+    {
+      const Point2D& a = polygon[e];
+      const Point2D& b = polygon[(e + 1) % polygon.size()];
+      inside = (b.x - a.x) * (qy - a.y) - (b.y - a.y) * (qx - a.x) >= 0.0;
+    }
+    if (inside)
+      return t;
+  }
+  return -1.0;
+}
+
+// distance of a point outside of the polygon to its boundary
+double referenceGap(const std::vector<Point2D>& polygon, double px, double py)
+{
+  double gap = std::numeric_limits<double>::infinity();
+  for (size_t e = 0; e < polygon.size(); e++)
+  {
+    const Point2D& a = polygon[e];
+    const Point2D& b = polygon[(e + 1) % polygon.size()];
+    double dx = b.x - a.x, dy = b.y - a.y;
+    double u = std::max(0.0, std::min(1.0, ((px - a.x) * dx + (py - a.y) * dy) / (dx * dx + dy * dy)));
+    gap = std::min(gap, hypot(px - a.x - u * dx, py - a.y - u * dy));
+  }
+  return gap;
+}
+
+double elapsedUs(std::chrono::steady_clock::time_point start, int cycles)
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / cycles;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  const int cycles = argc > 1 ? atoi(argv[1]) : 200;
+  const double influence_radius = 1.5, use_circumscribed_threshold = 0.2, tolerance = 1e-9;
+
+  Costmap map;
+  map.size_x = map.size_y = 200;
+  map.resolution = 0.05;
+  map.origin_x = map.origin_y = -5.0;
+  map.data.resize(map.size_x * map.size_y);
+  srand(42);
+  for (unsigned i = 0; i < map.data.size(); i++)
+    map.data[i] = (rand() % 100 < 30) ? 254 : 0;
+
+  Footprint fp;
+  Point2D corners[4] = { { 0.345, 0.305 }, { -0.295, 0.305 }, { -0.295, -0.305 }, { 0.345, -0.305 } };
+  fp.points.assign(corners, corners + 4);
+  fp.front = 0.345;
+  fp.rear = -0.295;
+  fp.left = 0.305;
+  fp.right = -0.305;
+
+  const double commands[][3] = { { 0.5, 0.0, 0.0 }, { 0.3, 0.3, 0.0 }, { -0.2, 0.4, 0.5 }, { 0.0, -0.4, 0.1 },
+                                 { 0.0, 0.0, 0.6 }, { -0.5, -0.1, 0.3 } };
+  const unsigned num_commands = sizeof(commands) / sizeof(commands[0]);
+
+  ObstacleClassifier classifier;
+  classifier.setFootprint(fp.points, fp.front, fp.rear, fp.left, fp.right);
+  classifier.setInfluenceRadius(influence_radius);
+  const bool avx2 = classifier.usesAvx2();
+
+  std::vector<double> x, y;
+  std::vector<unsigned> cells;
+  std::vector<unsigned char> cell_relevant, relevant_ref, relevant;
+  x.reserve(map.data.size());
+  y.reserve(map.data.size());
+  cells.reserve(map.data.size());
+
+  // check compatibility with the reference formulation
+  unsigned mismatches = 0;
+  for (unsigned c = 0; c < num_commands; c++)
+  {
+    double dist_ref, angle_ref = 0.0;
+    referenceClassify(map, fp, commands[c][0], commands[c][1], commands[c][2], influence_radius,
+                      use_circumscribed_threshold, relevant_ref, dist_ref, angle_ref);
+    classifier.setCommand(commands[c][0], commands[c][1], commands[c][2], use_circumscribed_threshold);
+    for (int k = 0; k < 2; k++)
+    {
+      classifier.enableAvx2(k == 1);
+      if (k == 1 && !classifier.usesAvx2())
+        continue;
+      double dist, angle = 0.0;
+      kernelClassify(map, classifier, influence_radius, x, y, cells, cell_relevant, relevant, dist, angle);
+      unsigned cell_mismatches = 0;
+      for (unsigned i = 0; i < relevant.size(); i++)
+        if (relevant[i] != relevant_ref[i])
+          cell_mismatches++;
+      bool ok = cell_mismatches == 0 && fabs(dist - dist_ref) < tolerance && fabs(angle - angle_ref) < tolerance;
+      printf("command %u %-6s: dist %.6f (ref %.6f) angle %.6f (ref %.6f) cell mismatches %u %s\n", c,
+             k ? "avx2" : "scalar", dist, dist_ref, angle, angle_ref, cell_mismatches, ok ? "ok" : "MISMATCH");
+      if (!ok)
+        mismatches++;
+    }
+  }
+
+  // timing
+  double dist, angle;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < cycles; i++)
+  {
+    const double* cmd = commands[i % num_commands];
+    referenceClassify(map, fp, cmd[0], cmd[1], cmd[2], influence_radius, use_circumscribed_threshold, relevant_ref,
+                      dist, angle);
+  }
+  printf("reference: %10.1f us/cycle\n", elapsedUs(start, cycles));
+
+  for (int k = 0; k < 2; k++)
+  {
+    classifier.enableAvx2(k == 1);
+    if (k == 1 && !classifier.usesAvx2())
+    {
+      printf("avx2     : not available\n");
+      continue;
+    }
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++)
+    {
+      const double* cmd = commands[i % num_commands];
+      classifier.setCommand(cmd[0], cmd[1], cmd[2], use_circumscribed_threshold);
+      kernelClassify(map, classifier, influence_radius, x, y, cells, cell_relevant, relevant, dist, angle);
+    }
+    printf("%-9s: %10.1f us/cycle\n", k ? "avx2" : "scalar", elapsedUs(start, cycles));
+
+    // classification of the gathered cells only
+    ClosestObstacle closest;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++)
+    {
+      closest.distance = influence_radius;
+      classifier.classify(&x[0], &y[0], x.size(), &cell_relevant[0], closest);
+    }
+    printf("%-9s: %10.1f us/cycle for %u cells (kernel only)\n", k ? "avx2" : "scalar", elapsedUs(start, cycles),
+           (unsigned)x.size());
+  }
+  classifier.enableAvx2(avx2);
+
+  // incremental tracking
+  ObstacleTracker tracker;
+  const double tracking_radius = std::max(influence_radius, sqrt(classifier.frame().circumscribed_radius_sq));
+  tracker.reset(map.size_x, map.size_y, map.resolution, map.origin_x, map.origin_y, tracking_radius,
+                classifier.frame());
+  tracker.update(&map.data[0], 250, 0, map.size_x, 0, map.size_y);
+
+  std::vector<signed char> grid;
+  for (unsigned c = 0; c < num_commands; c++)
+  {
+    double dist_ref, angle_ref = 0.0;
+    referenceClassify(map, fp, commands[c][0], commands[c][1], commands[c][2], influence_radius,
+                      use_circumscribed_threshold, relevant_ref, dist_ref, angle_ref);
+    classifier.setCommand(commands[c][0], commands[c][1], commands[c][2], use_circumscribed_threshold);
+    TrackedObstacle closest;
+    double angle = tracker.findClosest(classifier, influence_radius, closest) ? atan2(closest.y, closest.x) : 0.0;
+    grid.assign(map.data.size(), 0);
+    tracker.markRelevant(classifier, grid);
+    unsigned cell_mismatches = 0;
+    for (unsigned i = 0; i < grid.size(); i++)
+      if ((unsigned char)grid[i] != relevant_ref[i])
+        cell_mismatches++;
+    bool ok = cell_mismatches == 0 && fabs(closest.distance - dist_ref) < tolerance
+        && fabs(angle - angle_ref) < tolerance;
+    printf("command %u tracker: dist %.6f (ref %.6f) angle %.6f (ref %.6f) cell mismatches %u %s\n", c,
+           closest.distance, dist_ref, angle, angle_ref, cell_mismatches, ok ? "ok" : "MISMATCH");
+    if (!ok)
+      mismatches++;
+  }
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < cycles; i++)
+  {
+    const double* cmd = commands[i % num_commands];
+    classifier.setCommand(cmd[0], cmd[1], cmd[2], use_circumscribed_threshold);
+    TrackedObstacle closest;
+    tracker.findClosest(classifier, influence_radius, closest);
+  }
+  printf("tracker  : %10.1f us/cycle for %u tracked cells (query only)\n", elapsedUs(start, cycles),
+         (unsigned)tracker.size());
+
+  // toggle cells in a 20x20 window in front of the robot and update from these bounds
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < cycles; i++)
+  {
+    unsigned x0 = 105 + i % 20, y0 = 90;
+    for (unsigned j = y0; j < y0 + 20; j++)
+      for (unsigned k = x0; k < x0 + 20; k++)
+        map.data[j * map.size_x + k] = (rand() % 100 < 30) ? 254 : 0;
+    tracker.update(&map.data[0], 250, x0, x0 + 20, y0, y0 + 20);
+  }
+  printf("tracker  : %10.1f us/cycle (update of 20x20 cells)\n", elapsedUs(start, cycles));
+
+  // the incrementally updated set has to match a freshly built one
+  ObstacleTracker rebuilt;
+  rebuilt.reset(map.size_x, map.size_y, map.resolution, map.origin_x, map.origin_y, tracking_radius,
+                classifier.frame());
+  rebuilt.update(&map.data[0], 250, 0, map.size_x, 0, map.size_y);
+  for (unsigned c = 0; c < num_commands; c++)
+  {
+    classifier.setCommand(commands[c][0], commands[c][1], commands[c][2], use_circumscribed_threshold);
+    TrackedObstacle a, b;
+    tracker.findClosest(classifier, influence_radius, a);
+    rebuilt.findClosest(classifier, influence_radius, b);
+    if (tracker.size() != rebuilt.size() || a.cell != b.cell || a.distance != b.distance)
+    {
+      printf("command %u tracker: incremental update differs from rebuild MISMATCH\n", c);
+      mismatches++;
+    }
+  }
+
+  // swept polygon footprint (octagon)
+  std::vector<Point2D> octagon;
+  for (int i = 0; i < 8; i++)
+  {
+    Point2D p = { 0.35 * cos(M_PI / 8.0 + i * M_PI / 4.0) + 0.0025, 0.3 * sin(M_PI / 8.0 + i * M_PI / 4.0) + 0.0025 };
+    octagon.push_back(p);
+  }
+  FootprintSweep sweep;
+  sweep.setFootprint(octagon);
+  const double tolerance_sweep = map.resolution / 2.0;
+  for (unsigned c = 0; c < num_commands; c++)
+  {
+    sweep.setCommand(commands[c][0], commands[c][1], commands[c][2], influence_radius, tolerance_sweep);
+    if (!sweep.active())
+      continue;
+    TrackedObstacle closest[2];
+    for (int k = 0; k < 2; k++)
+    {
+      sweep.enableAvx2(k == 1);
+      rebuilt.findFirstContact(sweep, influence_radius, closest[k]);
+    }
+
+    // reference: first contact over all tracked cells
+    double horizon = influence_radius / sweep.speedBound();
+    if (fabs(commands[c][2]) > 0.01)
+      horizon = std::min(horizon, 2.0 * M_PI / fabs(commands[c][2]));
+    double t_ref = -1.0, gap = std::numeric_limits<double>::infinity();
+    for (unsigned i = 0; i < map.data.size(); i++)
+    {
+      if (map.data[i] < 250)
+        continue;
+      double px = (i % map.size_x) * map.resolution + map.origin_x;
+      double py = (i / map.size_x) * map.resolution + map.origin_y;
+      if (sqrt(px * px + py * py) > tracking_radius || sweep.inside(px, py))
+        continue;
+      double t = referenceContact(octagon, commands[c][0], commands[c][1], commands[c][2], horizon, px, py);
+      if (t >= 0.0 && (t_ref < 0.0 || t < t_ref))
+        t_ref = t;
+      gap = std::min(gap, referenceGap(octagon, px, py));
+    }
+    double dist_ref = t_ref >= 0.0 ? t_ref * sweep.speedBound() : influence_radius;
+
+    // the sweep is conservative by at most the tolerance, but no footprint point reaches an obstacle before it
+    // moved the gap, of which the edge lines of the octagon see at least cos(pi/8)
+    bool ok = closest[0].cell == closest[1].cell && closest[0].distance == closest[1].distance
+        && closest[0].distance <= dist_ref + 1e-3 && closest[0].distance >= dist_ref - 2.0 * tolerance_sweep
+        && closest[0].distance >= cos(M_PI / 8.0) * std::min(gap, dist_ref);
+    printf("command %u sweep  : dist %.6f (ref %.6f) gap %.6f steps %u %s\n", c, closest[0].distance, dist_ref, gap,
+           (unsigned)sweep.numSteps(), ok ? "ok" : "MISMATCH");
+    if (!ok)
+      mismatches++;
+  }
+
+  for (int k = 0; k < 2; k++)
+  {
+    sweep.enableAvx2(k == 1);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++)
+    {
+      const double* cmd = commands[i % num_commands];
+      sweep.setCommand(cmd[0], cmd[1], cmd[2], influence_radius, tolerance_sweep);
+      TrackedObstacle closest;
+      rebuilt.findFirstContact(sweep, influence_radius, closest);
+    }
+    printf("sweep %-4s: %9.1f us/cycle\n", k ? "avx2" : "", elapsedUs(start, cycles));
+  }
+
+  return mismatches == 0 ? 0 : 1;
+}
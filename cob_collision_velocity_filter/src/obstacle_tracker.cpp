@@ -0,0 +1,331 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#include <obstacle_tracker.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cob_collision_velocity_filter
+{
+
+ObstacleTracker::ObstacleTracker()
+  : size_x_(0), size_y_(0), resolution_(0.0), origin_x_(0.0), origin_y_(0.0), tracking_radius_(0.0),
+    window_x0_(0), window_xn_(0), window_y0_(0), window_yn_(0), num_tracked_(0)
+{
+  frame_.front = frame_.rear = frame_.left = frame_.right = 0.0;
+}
+
+bool ObstacleTracker::outdated(unsigned int size_x, unsigned int size_y, double resolution, double origin_x,
+                               double origin_y, double tracking_radius, const ClassifierFrame& frame) const
+{
+  return size_x != size_x_ || size_y != size_y_ || resolution != resolution_ || origin_x != origin_x_
+      || origin_y != origin_y_ || tracking_radius != tracking_radius_ || frame.front != frame_.front
+      || frame.rear != frame_.rear || frame.left != frame_.left || frame.right != frame_.right;
+}
+
+void ObstacleTracker::reset(unsigned int size_x, unsigned int size_y, double resolution, double origin_x,
+                            double origin_y, double tracking_radius, const ClassifierFrame& frame)
+{
+  size_x_ = size_x;
+  size_y_ = size_y;
+  resolution_ = resolution;
+  origin_x_ = origin_x;
+  origin_y_ = origin_y;
+  tracking_radius_ = tracking_radius;
+  frame_ = frame;
+
+  window_x0_ = std::max(0, (int)floor((-tracking_radius - origin_x) / resolution));
+  window_xn_ = std::max(0, std::min((int)size_x, (int)ceil((tracking_radius - origin_x) / resolution) + 1));
+  window_y0_ = std::max(0, (int)floor((-tracking_radius - origin_y) / resolution));
+  window_yn_ = std::max(0, std::min((int)size_y, (int)ceil((tracking_radius - origin_y) / resolution) + 1));
+
+  // one bin per cell width of border distance, cells within the footprint go to the first bin
+  bins_.clear();
+  bins_.resize((size_t)ceil(tracking_radius / resolution) + 2);
+  cell_bin_.assign(size_x * size_y, -1);
+  num_tracked_ = 0;
+}
+
+void ObstacleTracker::update(const unsigned char* char_map, unsigned int threshold, unsigned int x0, unsigned int xn,
+                             unsigned int y0, unsigned int yn)
+{
+  x0 = std::max(x0, window_x0_);
+  xn = std::min(xn, window_xn_);
+  y0 = std::max(y0, window_y0_);
+  yn = std::min(yn, window_yn_);
+  const double tracking_radius_sq = tracking_radius_ * tracking_radius_;
+
+  for (unsigned int j = y0; j < yn; j++)
+  {
+    for (unsigned int k = x0; k < xn; k++)
+    {
+      const unsigned int i = j * size_x_ + k;
+      const bool tracked = cell_bin_[i] >= 0;
+      if (char_map[i] < threshold)
+      {
+        if (tracked)
+          remove(i);
+        continue;
+      }
+      if (tracked)
+        continue;
+
+      // calculate cell in 2D space where robot is is point (0, 0)
+      const double x = (i % size_x_) * resolution_ + origin_x_;
+      const double y = (i / size_x_) * resolution_ + origin_y_;
+      if (x * x + y * y <= tracking_radius_sq)
+        insert(i, x, y);
+    }
+  }
+}
+
+void ObstacleTracker::insert(unsigned int cell, double x, double y)
+{
+  double border_dist = kernels::borderDistance(frame_, x, y, sqrt(x * x + y * y));
+  size_t b = border_dist > 0.0 ? (size_t)(border_dist / resolution_) : 0;
+  b = std::min(b, bins_.size() - 1);
+
+  Bin& bin = bins_[b];
+  size_t pos = std::lower_bound(bin.cell.begin(), bin.cell.end(), cell) - bin.cell.begin();
+  bin.cell.insert(bin.cell.begin() + pos, cell);
+  bin.x.insert(bin.x.begin() + pos, x);
+  bin.y.insert(bin.y.begin() + pos, y);
+  cell_bin_[cell] = b;
+  num_tracked_++;
+}
+
+void ObstacleTracker::remove(unsigned int cell)
+{
+  Bin& bin = bins_[cell_bin_[cell]];
+  size_t pos = std::lower_bound(bin.cell.begin(), bin.cell.end(), cell) - bin.cell.begin();
+  bin.cell.erase(bin.cell.begin() + pos);
+  bin.x.erase(bin.x.begin() + pos);
+  bin.y.erase(bin.y.begin() + pos);
+  cell_bin_[cell] = -1;
+  num_tracked_--;
+}
+
+bool ObstacleTracker::findClosest(const ObstacleClassifier& classifier, double max_distance,
+                                  TrackedObstacle& closest) const
+{
+  closest.distance = max_distance;
+  closest.cell = -1;
+  closest.num_inside = 0;
+
+  // bins are ordered by border distance, the bin after the first hit is checked as well to be robust against rounding
+  long found_bin = -1;
+  for (size_t b = 0; b < bins_.size(); b++)
+  {
+    if (found_bin >= 0 && (long)b > found_bin + 1)
+      break;
+    const Bin& bin = bins_[b];
+    if (bin.cell.empty())
+      continue;
+
+    ClosestObstacle bin_closest;
+    bin_closest.distance = max_distance;
+    classifier.classify(&bin.x[0], &bin.y[0], bin.cell.size(), NULL, bin_closest);
+    closest.num_inside += bin_closest.num_inside;
+    if (bin_closest.index < 0)
+      continue;
+
+    const long cell = bin.cell[bin_closest.index];
+    if (bin_closest.distance < closest.distance || (bin_closest.distance == closest.distance && cell < closest.cell))
+    {
+      closest.distance = bin_closest.distance;
+      closest.x = bin.x[bin_closest.index];
+      closest.y = bin.y[bin_closest.index];
+      closest.cell = cell;
+    }
+    if (found_bin < 0)
+      found_bin = b;
+  }
+  return closest.cell >= 0;
+}
+
+bool ObstacleTracker::findClosestAny(double max_distance, TrackedObstacle& closest) const
+{
+  closest.distance = max_distance;
+  closest.cell = -1;
+  closest.num_inside = 0;
+
+  long found_bin = -1;
+  for (size_t b = 0; b < bins_.size(); b++)
+  {
+    if (found_bin >= 0 && (long)b > found_bin + 1)
+      break;
+    const Bin& bin = bins_[b];
+    for (size_t j = 0; j < bin.cell.size(); j++)
+    {
+      const double x = bin.x[j], y = bin.y[j];
+      if (x < frame_.front && x > frame_.rear && y > frame_.right && y < frame_.left)
+      {
+        closest.num_inside++;
+        continue;
+      }
+      const double dist = kernels::borderDistance(frame_, x, y, sqrt(x * x + y * y));
+      if (dist < closest.distance || (dist == closest.distance && (long)bin.cell[j] < closest.cell))
+      {
+        closest.distance = dist;
+        closest.x = x;
+        closest.y = y;
+        closest.cell = bin.cell[j];
+        if (found_bin < 0)
+          found_bin = b;
+      }
+    }
+  }
+  return closest.cell >= 0;
+}
+
+size_t ObstacleTracker::gatherSweepCells(const FootprintSweep& sweep) const
+{
+  size_t num_inside = 0;
+  sweep_cell_.clear();
+  sweep_x_.clear();
+  sweep_y_.clear();
+  for (size_t b = 0; b < bins_.size(); b++)
+  {
+    const Bin& bin = bins_[b];
+    for (size_t j = 0; j < bin.cell.size(); j++)
+    {
+      if (sweep.inside(bin.x[j], bin.y[j]))
+      {
+        num_inside++;
+        continue;
+      }
+      sweep_cell_.push_back(bin.cell[j]);
+      sweep_x_.push_back(bin.x[j]);
+      sweep_y_.push_back(bin.y[j]);
+    }
+  }
+  sweep_time_.assign(sweep_cell_.size() + 1, std::numeric_limits<double>::infinity());
+  sweep_x_.push_back(0.0);
+  sweep_y_.push_back(0.0);
+  return num_inside;
+}
+
+bool ObstacleTracker::findFirstContact(const FootprintSweep& sweep, double max_distance,
+                                       TrackedObstacle& closest) const
+{
+  closest.distance = max_distance;
+  closest.cell = -1;
+  closest.num_inside = 0;
+  if (!sweep.active())
+    return false;
+
+  closest.num_inside = gatherSweepCells(sweep);
+  const size_t n = sweep_cell_.size();
+
+  // steps are ordered in time, so the first contact happens in the first step that hits any cell
+  for (size_t k = 0; k < sweep.numSteps(); k++)
+  {
+    if (sweep.contactStep(k, &sweep_x_[0], &sweep_y_[0], n, &sweep_time_[0]) == 0)
+      continue;
+
+    // the inflated step reports contacts up to a step early, at distance 0 for cells close to the start pose,
+    // but no footprint point reaches a cell before it moved the clearance, and cells not hit yet are hit after
+    // the end of the step
+    const double step_end = sweep.stepEnd(k) * sweep.speedBound();
+    for (size_t j = 0; j < n; j++)
+    {
+      if (sweep_time_[j] == std::numeric_limits<double>::infinity())
+        continue;
+      const double dist = std::min(
+          std::max(sweep_time_[j] * sweep.speedBound(), sweep.clearance(sweep_x_[j], sweep_y_[j])), step_end);
+      if (dist < closest.distance || (dist == closest.distance && (long)sweep_cell_[j] < closest.cell))
+      {
+        closest.distance = dist;
+        closest.x = sweep_x_[j];
+        closest.y = sweep_y_[j];
+        closest.cell = sweep_cell_[j];
+      }
+    }
+    break;
+  }
+  return closest.cell >= 0;
+}
+
+size_t ObstacleTracker::markContacts(const FootprintSweep& sweep, std::vector<signed char>& grid) const
+{
+  if (!sweep.active())
+    return 0;
+
+  size_t num_inside = gatherSweepCells(sweep);
+  const size_t n = sweep_cell_.size();
+  for (size_t k = 0; k < sweep.numSteps(); k++)
+    sweep.contactStep(k, &sweep_x_[0], &sweep_y_[0], n, &sweep_time_[0]);
+  for (size_t j = 0; j < n; j++)
+  {
+    if (sweep_time_[j] < std::numeric_limits<double>::infinity())
+      grid[sweep_cell_[j]] = 100;
+  }
+  return num_inside;
+}
+
+size_t ObstacleTracker::markRelevant(const ObstacleClassifier& classifier, std::vector<signed char>& grid) const
+{
+  size_t num_inside = 0;
+  for (size_t b = 0; b < bins_.size(); b++)
+  {
+    const Bin& bin = bins_[b];
+    if (bin.cell.empty())
+      continue;
+
+    ClosestObstacle bin_closest;
+    bin_closest.distance = 0.0;
+    relevant_buffer_.resize(bin.cell.size());
+    classifier.classify(&bin.x[0], &bin.y[0], bin.cell.size(), &relevant_buffer_[0], bin_closest);
+    num_inside += bin_closest.num_inside;
+    for (size_t j = 0; j < bin.cell.size(); j++)
+    {
+      if (relevant_buffer_[j])
+        grid[bin.cell[j]] = relevant_buffer_[j];
+    }
+  }
+  return num_inside;
+}
+
+}
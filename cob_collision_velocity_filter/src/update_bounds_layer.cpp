@@ -0,0 +1,127 @@
+/****************************************************************
+ *
+ * Copyright (c) 2016
+ *
+ * Fraunhofer Institute for Manufacturing Engineering
+ * and Automation (IPA)
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Project name: care-o-bot
+ * ROS stack name: cob_navigation
+ * ROS package name: cob_collision_velocity_filter
+ *
+ * +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *  	 notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *  	 notice, this list of conditions and the following disclaimer in the
+ *  	 documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the Fraunhofer Institute for Manufacturing
+ *  	 Engineering and Automation (IPA) nor the names of its
+ *  	 contributors may be used to endorse or promote products derived from
+ *  	 this software without specific prior written permission.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License LGPL as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License LGPL for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License LGPL along with this program.
+ * If not, see <http://www.gnu.org/licenses/>.
+ *
+ ****************************************************************/
+#include <update_bounds_layer.h>
+
+#include <algorithm>
+
+#include <costmap_2d/layered_costmap.h>
+#include <pluginlib/class_list_macros.h>
+
+PLUGINLIB_EXPORT_CLASS(cob_collision_velocity_filter::UpdateBoundsLayer, costmap_2d::Layer)
+
+namespace cob_collision_velocity_filter
+{
+
+UpdateBoundsLayer::UpdateBoundsLayer()
+  : updated_(false), x0_(0), xn_(0), y0_(0), yn_(0), size_x_(0), size_y_(0), origin_x_(0.0), origin_y_(0.0)
+{
+}
+
+void UpdateBoundsLayer::onInitialize()
+{
+  current_ = true;
+  enabled_ = true;
+}
+
+void UpdateBoundsLayer::updateCosts(costmap_2d::Costmap2D& master_grid, int min_i, int min_j, int max_i, int max_j)
+{
+  const unsigned int size_x = master_grid.getSizeInCellsX(), size_y = master_grid.getSizeInCellsY();
+
+  boost::mutex::scoped_lock lock(mutex_);
+  if (size_x != size_x_ || size_y != size_y_ || master_grid.getOriginX() != origin_x_
+      || master_grid.getOriginY() != origin_y_)
+  {
+    // all cells moved, e.g. with a rolling window
+    size_x_ = size_x;
+    size_y_ = size_y;
+    origin_x_ = master_grid.getOriginX();
+    origin_y_ = master_grid.getOriginY();
+    addBounds(0, size_x, 0, size_y);
+  }
+  else if (min_i < max_i && min_j < max_j)
+  {
+    addBounds(std::max(min_i, 0), std::min((unsigned int)max_i, size_x), std::max(min_j, 0),
+              std::min((unsigned int)max_j, size_y));
+  }
+}
+
+void UpdateBoundsLayer::reset()
+{
+  // the whole costmap was cleared
+  costmap_2d::Costmap2D* master_grid = layered_costmap_->getCostmap();
+  boost::mutex::scoped_lock lock(mutex_);
+  addBounds(0, master_grid->getSizeInCellsX(), 0, master_grid->getSizeInCellsY());
+}
+
+bool UpdateBoundsLayer::consumeBounds(unsigned int& x0, unsigned int& xn, unsigned int& y0, unsigned int& yn)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if (!updated_)
+    return false;
+  x0 = x0_;
+  xn = xn_;
+  y0 = y0_;
+  yn = yn_;
+  updated_ = false;
+  return true;
+}
+
+void UpdateBoundsLayer::addBounds(unsigned int x0, unsigned int xn, unsigned int y0, unsigned int yn)
+{
+  if (!updated_)
+  {
+    x0_ = x0;
+    xn_ = xn;
+    y0_ = y0;
+    yn_ = yn;
+    updated_ = true;
+    return;
+  }
+  x0_ = std::min(x0_, x0);
+  xn_ = std::max(xn_, xn);
+  y0_ = std::min(y0_, y0);
+  yn_ = std::max(yn_, yn);
+}
+
+}
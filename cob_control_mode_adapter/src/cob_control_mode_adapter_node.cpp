@@ -33,11 +33,34 @@
 #include <std_msgs/Float64MultiArray.h>
 #include <controller_manager_msgs/LoadController.h>
 #include <controller_manager_msgs/SwitchController.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
 class CobControlModeAdapter
 {
 public:
+    enum ControlMode
+    {
+        NONE, VELOCITY, POSITION, TRAJECTORY
+    };
+
+    CobControlModeAdapter()
+    :   switch_pending_(false),
+        shutdown_(false)
+    {}
+
+    ~CobControlModeAdapter()
+    {
+        {
+            boost::mutex::scoped_lock lock(mutex_);
+            shutdown_ = true;
+        }
+        switch_cond_.notify_all();
+        switch_thread_.join();
+    }
+
     bool initialize()
     {
         bool success = false;
@@ -55,6 +78,13 @@ public:
         has_vel_controller_ = false;
 
         current_control_mode_ = NONE;
+        requested_control_mode_ = NONE;
+        switch_pending_ = false;
+        switch_count_ = 0;
+        switch_failures_ = 0;
+        latency_last_ = 0.0;
+        latency_sum_ = 0.0;
+        latency_max_ = 0.0;
 
         // wait for services from controller manager
         while (!ros::service::waitForService("controller_manager/load_controller", ros::Duration(5.0))) {;}
@@ -143,6 +173,7 @@ public:
                 success = loadController(pos_controller_names_[i]);
             }
             cmd_pos_sub_ = nh_.subscribe(joint_group_position_controller_name+"/command", 1, &CobControlModeAdapter::cmd_pos_cb, this);
+            cmd_pos_pub_ = nh_.advertise<std_msgs::Float64MultiArray>(joint_group_position_controller_name+"/command", 1);
         }
         if (has_vel_controller_)
         {
@@ -151,15 +182,26 @@ public:
                 success = loadController(vel_controller_names_[i]);
             }
             cmd_vel_sub_ = nh_.subscribe(joint_group_velocity_controller_name+"/command", 1, &CobControlModeAdapter::cmd_vel_cb, this);
+            cmd_vel_pub_ = nh_.advertise<std_msgs::Float64MultiArray>(joint_group_velocity_controller_name+"/command", 1);
         }
 
         // start trajectory controller by default
         if (has_traj_controller_)
         {
             success = switchController(traj_controller_names_, current_controller_names_);
+            if (success)
+            {
+                current_controller_names_ = traj_controller_names_;
+            }
             current_control_mode_ = TRAJECTORY;
         }
 
+        // switches are done asynchronously, so neither the command callbacks nor the timer block on controller_manager
+        switch_thread_ = boost::thread(&CobControlModeAdapter::switchThread, this);
+
+        updater_.setHardwareID(nh_.getNamespace());
+        updater_.add("Control mode switching", this, &CobControlModeAdapter::diagnoseSwitching);
+
         update_rate_ = 100;    // [hz]
         timer_ = nh_.createTimer(ros::Duration(1/update_rate_), &CobControlModeAdapter::update, this);
 
@@ -223,8 +265,6 @@ public:
                 }
 
                 ROS_INFO("Switched Controllers. From %s to %s", str_stop.c_str(), str_start.c_str());
-
-                current_controller_names_ = start_controllers;
                 return true;
             }
             else
@@ -240,89 +280,205 @@ public:
         return false;
     }
 
-    void cmd_pos_cb(const std_msgs::Float64MultiArray::ConstPtr& msg)
+    void cmd_pos_cb(const ros::MessageEvent<std_msgs::Float64MultiArray const>& event)
     {
+        if (event.getPublisherName() == ros::this_node::getName()) {return;}  // replayed command
+
         boost::mutex::scoped_lock lock(mutex_);
         last_pos_command_ = ros::Time::now();
+        if (current_control_mode_ != POSITION)
+        {
+            // the controller drops commands received before it is started, replay after the switch
+            buffered_pos_command_ = event.getMessage();
+        }
+        requestSwitch(getDesiredMode(last_pos_command_));
     }
 
-    void cmd_vel_cb(const std_msgs::Float64MultiArray::ConstPtr& msg)
+    void cmd_vel_cb(const ros::MessageEvent<std_msgs::Float64MultiArray const>& event)
     {
+        if (event.getPublisherName() == ros::this_node::getName()) {return;}  // replayed command
+
         boost::mutex::scoped_lock lock(mutex_);
         last_vel_command_ = ros::Time::now();
+        if (current_control_mode_ != VELOCITY)
+        {
+            // the controller drops commands received before it is started, replay after the switch
+            buffered_vel_command_ = event.getMessage();
+        }
+        requestSwitch(getDesiredMode(last_vel_command_));
     }
 
     void update(const ros::TimerEvent& event)
     {
         if (!nh_.ok()) {return;}
 
-        boost::mutex::scoped_lock lock(mutex_);
-
-        ros::Duration period_vel = event.current_real - last_vel_command_;
-        ros::Duration period_pos = event.current_real - last_pos_command_;
+        updater_.update();
 
-        lock.unlock();
+        boost::mutex::scoped_lock lock(mutex_);
 
-        if (has_vel_controller_ && (period_vel.toSec() < max_command_silence_))
+        ControlMode mode = getDesiredMode(event.current_real);
+        if (mode == NONE)
         {
-            if (current_control_mode_ != VELOCITY)
-            {
-                bool success = switchController(vel_controller_names_, current_controller_names_);
-                if (!success)
-                {
-                    ROS_ERROR("Unable to switch to velocity_controllers. Not executing command...");
-                }
-                else
-                {
-                    ROS_INFO("Successfully switched to velocity_controllers");
-                    current_control_mode_ = VELOCITY;
-                }
-            }
+            ROS_ERROR_STREAM(nh_.getNamespace() << " does not support 'joint_trajectory_controller' and no other controller was started yet");
+            return;
         }
-        else if (has_pos_controller_ && (period_pos.toSec() < max_command_silence_))
+        if (mode == TRAJECTORY && current_control_mode_ != TRAJECTORY && !switch_pending_)
         {
-            if (current_control_mode_ != POSITION)
+            if (current_control_mode_ == POSITION)
             {
-                bool success = switchController(pos_controller_names_, current_controller_names_);
-                if (!success)
-                {
-                    ROS_ERROR("Unable to switch to position_controllers. Not executing command...");
-                }
-                else
-                {
-                    ROS_INFO("Successfully switched to position_controllers");
-                    current_control_mode_ = POSITION;
-                }
+                ROS_INFO("Have not heard a pos command for %f seconds, switched back to trajectory_controller", (event.current_real - last_pos_command_).toSec());
             }
+            else
+            {
+                ROS_INFO("Have not heard a vel command for %f seconds, switched back to trajectory_controller", (event.current_real - last_vel_command_).toSec());
+            }
+        }
+        requestSwitch(mode);
+    }
+
+    /// velocity commands have priority over position commands, trajectory control is the fallback (mutex_ locked)
+    ControlMode getDesiredMode(const ros::Time& now) const
+    {
+        if (has_vel_controller_ && ((now - last_vel_command_).toSec() < max_command_silence_))
+        {
+            return VELOCITY;
+        }
+        else if (has_pos_controller_ && ((now - last_pos_command_).toSec() < max_command_silence_))
+        {
+            return POSITION;
         }
         else if (has_traj_controller_)
         {
-            if (current_control_mode_ != TRAJECTORY)
+            return TRAJECTORY;
+        }
+        return NONE;
+    }
+
+    /// hands the switch over to switchThread, at most one switch is pending (mutex_ locked)
+    void requestSwitch(ControlMode mode)
+    {
+        if (mode == NONE || mode == current_control_mode_ || switch_pending_) {return;}
+
+        requested_control_mode_ = mode;
+        switch_request_time_ = ros::WallTime::now();
+        switch_pending_ = true;
+        switch_cond_.notify_one();
+    }
+
+    void switchThread()
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+        while (!shutdown_)
+        {
+            if (!switch_pending_)
             {
-                if (current_control_mode_ == POSITION)
-                {
-                    ROS_INFO("Have not heard a pos command for %f seconds, switched back to trajectory_controller", period_pos.toSec());
-                }
-                else
-                {
-                    ROS_INFO("Have not heard a vel command for %f seconds, switched back to trajectory_controller", period_vel.toSec());
-                }
-                bool success = switchController(traj_controller_names_, current_controller_names_);
+                switch_cond_.timed_wait(lock, boost::posix_time::milliseconds(100));
+                continue;
+            }
+
+            ControlMode mode = requested_control_mode_;
+            std::vector< std::string > start_controllers = getControllerNames(mode);
+            std::vector< std::string > stop_controllers = current_controller_names_;
+
+            lock.unlock();
+            bool success = switchController(start_controllers, stop_controllers);
+            double latency = (ros::WallTime::now() - switch_request_time_).toSec();
+            lock.lock();
+
+            std_msgs::Float64MultiArray::ConstPtr replay;
+            ros::Publisher* replay_pub = NULL;
+            if (success)
+            {
+                current_control_mode_ = mode;
+                current_controller_names_ = start_controllers;
 
-                if (success)
+                switch_count_++;
+                latency_last_ = latency;
+                latency_sum_ += latency;
+                latency_max_ = std::max(latency_max_, latency);
+                ROS_INFO("Successfully switched to %s_controllers within %f s", getModeName(mode).c_str(), latency);
+
+                // replay the triggering command unless it is outdated already
+                ros::Time now = ros::Time::now();
+                if (mode == VELOCITY && buffered_vel_command_ && (now - last_vel_command_).toSec() < max_command_silence_)
                 {
-                    current_control_mode_ = TRAJECTORY;
+                    replay = buffered_vel_command_;
+                    replay_pub = &cmd_vel_pub_;
                 }
-                else
+                else if (mode == POSITION && buffered_pos_command_ && (now - last_pos_command_).toSec() < max_command_silence_)
                 {
-                    ROS_ERROR("Unable to switch to trajectory_controller. Not executing command...");
+                    replay = buffered_pos_command_;
+                    replay_pub = &cmd_pos_pub_;
                 }
             }
+            else
+            {
+                switch_failures_++;
+                ROS_ERROR("Unable to switch to %s_controllers. Not executing command...", getModeName(mode).c_str());
+            }
+
+            buffered_vel_command_.reset();
+            buffered_pos_command_.reset();
+            switch_pending_ = false;
+
+            if (replay)
+            {
+                lock.unlock();
+                replay_pub->publish(replay);
+                lock.lock();
+            }
+        }
+    }
+
+    std::vector< std::string > getControllerNames(ControlMode mode) const
+    {
+        switch (mode)
+        {
+            case VELOCITY:
+                return vel_controller_names_;
+            case POSITION:
+                return pos_controller_names_;
+            case TRAJECTORY:
+                return traj_controller_names_;
+            default:
+                return std::vector< std::string >();
+        }
+    }
+
+    std::string getModeName(ControlMode mode) const
+    {
+        switch (mode)
+        {
+            case VELOCITY:
+                return "velocity";
+            case POSITION:
+                return "position";
+            case TRAJECTORY:
+                return "trajectory";
+            default:
+                return "none";
+        }
+    }
+
+    void diagnoseSwitching(diagnostic_updater::DiagnosticStatusWrapper& stat)
+    {
+        boost::mutex::scoped_lock lock(mutex_);
+
+        if (switch_failures_ > 0)
+        {
+            stat.summary(diagnostic_msgs::DiagnosticStatus::WARN, "Controller switches failed");
         }
         else
         {
-            ROS_ERROR_STREAM(nh_.getNamespace() << " does not support 'joint_trajectory_controller' and no other controller was started yet");
+            stat.summary(diagnostic_msgs::DiagnosticStatus::OK, "");
         }
+        stat.add("control mode", getModeName(current_control_mode_));
+        stat.add("switch pending", switch_pending_);
+        stat.add("switches", switch_count_);
+        stat.add("failed switches", switch_failures_);
+        stat.add("last switch latency [s]", latency_last_);
+        stat.add("mean switch latency [s]", (switch_count_ > 0) ? latency_sum_ / switch_count_ : 0.0);
+        stat.add("max switch latency [s]", latency_max_);
     }
 
 private:
@@ -333,10 +489,8 @@ private:
 
     std::vector< std::string > joint_names_;
 
-    enum
-    {
-        NONE, VELOCITY, POSITION, TRAJECTORY
-    } current_control_mode_;
+    ControlMode current_control_mode_;
+    ControlMode requested_control_mode_;
 
     std::vector< std::string > current_controller_names_;
     std::vector< std::string > traj_controller_names_;
@@ -349,6 +503,10 @@ private:
 
     ros::Subscriber cmd_pos_sub_;
     ros::Subscriber cmd_vel_sub_;
+    ros::Publisher cmd_pos_pub_;
+    ros::Publisher cmd_vel_pub_;
+    std_msgs::Float64MultiArray::ConstPtr buffered_pos_command_;
+    std_msgs::Float64MultiArray::ConstPtr buffered_vel_command_;
 
     ros::ServiceClient load_client_;
     ros::ServiceClient switch_client_;
@@ -357,6 +515,19 @@ private:
     ros::Time last_pos_command_;
     ros::Time last_vel_command_;
     boost::mutex mutex_;
+
+    boost::thread switch_thread_;
+    boost::condition_variable switch_cond_;
+    bool switch_pending_;
+    bool shutdown_;
+    ros::WallTime switch_request_time_;
+
+    diagnostic_updater::Updater updater_;
+    unsigned int switch_count_;
+    unsigned int switch_failures_;
+    double latency_last_;
+    double latency_sum_;
+    double latency_max_;
 };
 
 
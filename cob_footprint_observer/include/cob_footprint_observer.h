@@ -49,8 +49,8 @@
  * @file  cob_footprint_observer.h
  * @brief  observes the footprint of care-o-bot
  *
- * Generates rectangular footprint of care-o-bot depending on setup
- * of tray and arm.
+ * Generates the footprint of care-o-bot as convex hull of the initial
+ * footprint and the frames of tray and arm.
  *
  ****************************************************************/
 #ifndef COB_FOOTPRINT_OBSERVER_H
@@ -59,6 +59,11 @@
 //##################
 //#### includes ####
 
+// standard includes
+#include <map>
+#include <string>
+#include <vector>
+
 // ROS includes
 #include <ros/ros.h>
 #include <XmlRpc.h>
@@ -67,9 +72,14 @@
 #include <geometry_msgs/Point.h>
 #include <geometry_msgs/PolygonStamped.h>
 #include <geometry_msgs/Vector3.h>
+#include <sensor_msgs/JointState.h>
 
 #include <tf/transform_listener.h>
 
+#include <kdl/frames.hpp>
+#include <kdl/segment.hpp>
+#include <kdl/tree.hpp>
+
 #include <boost/tokenizer.hpp>
 #include <boost/foreach.hpp>
 #include <boost/algorithm/string.hpp>
@@ -97,6 +107,12 @@ class FootprintObserver
     ///
     void checkFootprint();
 
+    ///
+    /// @brief  callback for joint states, marks the footprint for recomputation if a relevant joint moved
+    /// @param  msg - joint states of the robot
+    ///
+    void jointStatesCB(const sensor_msgs::JointState::ConstPtr &msg);
+
     ///
     /// @brief  callback for GetFootprint service
     /// @param  req - request message to service
@@ -108,6 +124,7 @@ class FootprintObserver
     // public members
     ros::NodeHandle nh_;
     ros::Publisher topic_pub_footprint_;
+    ros::Subscriber topic_sub_joint_states_;
     ros::ServiceServer srv_get_footprint_;
 
   private:
@@ -118,6 +135,29 @@ class FootprintObserver
     ///
     std::vector<geometry_msgs::Point> loadRobotFootprint(ros::NodeHandle node);
 
+    ///
+    /// @brief  prepares the forward kinematics of all frames to check which are part of the robot description
+    /// @param  tree - kinematic tree of the robot
+    ///
+    void initForwardKinematics(const KDL::Tree &tree);
+
+    ///
+    /// @brief  adds a frame to the forward kinematics
+    /// @param  tree - kinematic tree of the robot
+    /// @param  frame - name of the frame
+    /// @param  index - index of the frame in fk_segments_ (-1 for the root of the tree)
+    /// @param  joints - the joints of the chain from the root to the frame are appended
+    /// @return frame is part of the tree
+    ///
+    bool addFkFrame(const KDL::Tree &tree, const std::string &frame, int &index, std::vector<unsigned int> &joints);
+
+    ///
+    /// @brief  computes the convex hull of points in the xy-plane
+    /// @param  points - points to enclose
+    /// @return vertices of the hull in counterclockwise order
+    ///
+    std::vector<geometry_msgs::Point> computeConvexHull(std::vector<geometry_msgs::Point> points);
+
     ///
     /// @brief  publishes the adjusted footprint as geometry_msgs::StampedPolygon message
     ///
@@ -132,13 +172,40 @@ class FootprintObserver
 
     // private members
     std::vector<geometry_msgs::Point> robot_footprint_;
+    std::vector<geometry_msgs::Point> robot_footprint_initial_;
     double epsilon_;
-    double footprint_front_initial_, footprint_rear_initial_, footprint_left_initial_, footprint_right_initial_;
-    double footprint_front_, footprint_rear_, footprint_left_, footprint_right_;
+    double joint_epsilon_;
     tf::TransformListener tf_listener_;
-    std::string frames_to_check_;
     std::string robot_base_frame_;
 
+    // frames to check, looked up via tf unless they can be computed from the joint states
+    struct CheckedFrame
+    {
+      std::string name;
+      bool in_tree;                      // part of the robot description
+      bool fk_ready;                     // all joints received
+      int fk_index;                      // index in fk_segments_, -1: root of the tree
+      std::vector<unsigned int> joints;  // joints of the chains to the frame and to the base frame
+    };
+    std::vector<CheckedFrame> frames_;
+
+    // segments of the robot description leading to the checked frames, parents precede their children
+    struct FkSegment
+    {
+      KDL::Segment segment;
+      int parent;  // -1: root of the tree
+      int joint;   // index in joint_positions_, -1: fixed joint
+    };
+    std::vector<FkSegment> fk_segments_;
+    std::vector<KDL::Frame> fk_poses_;
+    int fk_base_;
+
+    std::map<std::string, unsigned int> joint_index_;
+    std::vector<double> joint_positions_;
+    std::vector<bool> joint_received_;
+    bool joints_arrived_;
+    bool joints_changed_;
+
     pthread_mutex_t m_mutex;
 
     ros::Time last_tf_missing_;
@@ -49,14 +49,38 @@
  * @file  cob_footprint_observer.cpp
  * @brief  observes the footprint of care-o-bot
  *
- * Generates rectangular footprint of care-o-bot depending on setup of
- * arm and tray
+ * Generates the footprint of care-o-bot as convex hull of the initial
+ * footprint and the positions of the checked frames of arm and tray
  *
  ****************************************************************/
 #include <cob_footprint_observer.h>
+#include <kdl_parser/kdl_parser.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+  // lexicographic order of points in the xy-plane
+  struct PointLess
+  {
+    bool operator()(const geometry_msgs::Point &a, const geometry_msgs::Point &b) const
+    {
+      return a.x < b.x || (a.x == b.x && a.y < b.y);
+    }
+  };
+
+  // z-component of (a - o) x (b - o), positive for a counterclockwise turn
+  double cross(const geometry_msgs::Point &o, const geometry_msgs::Point &a, const geometry_msgs::Point &b)
+  {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+  }
+}
 
 // Constructor
 FootprintObserver::FootprintObserver() :
+  fk_base_(-1),
+  joints_arrived_(false),
+  joints_changed_(false),
   times_warned_(0)
 {
   nh_ = ros::NodeHandle("~");
@@ -79,21 +103,48 @@ FootprintObserver::FootprintObserver() :
 
   // load the robot footprint from the parameter server if its available in the local costmap namespace
   robot_footprint_ = loadRobotFootprint(footprint_source_nh_);
-  if(robot_footprint_.size() > 4)
-    ROS_WARN("You have set more than 4 points as robot_footprint, cob_footprint_observer can deal only with rectangular footprints so far!");
+  robot_footprint_initial_ = robot_footprint_;
 
   // get parameter sepcifying minimal changes of footprint that are accepted. (smaller changes are neglected)
   if(!nh_.hasParam("epsilon"))
     ROS_WARN("No epsilon value specified. Changes in footprint smaller than epsilon are neglected. Using default [0.01m]!");
   nh_.param("epsilon", epsilon_, 0.01);
 
+  // get parameter specifying minimal joint motion that triggers a recomputation of the footprint
+  nh_.param("joint_epsilon", joint_epsilon_, 0.001);
+
   // get the frames for which to check the footprint
+  std::string frames_to_check;
   if(!nh_.hasParam("frames_to_check")) ROS_WARN("No frames to check for footprint observer. Only using initial footprint!");
-  nh_.param("frames_to_check", frames_to_check_, std::string(""));
+  nh_.param("frames_to_check", frames_to_check, std::string(""));
 
   if(!nh_.hasParam("robot_base_frame")) ROS_WARN("No parameter robot_base_frame on parameter server. Using default [/base_link].");
   nh_.param("robot_base_frame", robot_base_frame_, std::string("/base_link"));
 
+  // frames are parsed once, all of them are looked up via tf until the robot description is known
+  std::stringstream ss(frames_to_check);
+  std::string frame;
+  while(ss >> frame) {
+    CheckedFrame checked_frame;
+    checked_frame.name = frame;
+    checked_frame.in_tree = false;
+    checked_frame.fk_ready = false;
+    checked_frame.fk_index = -1;
+    frames_.push_back(checked_frame);
+  }
+
+  // frames which are part of the robot description are computed from the joint states
+  if(!frames_.empty()) {
+    KDL::Tree tree;
+    if(!kdl_parser::treeFromParam("/robot_description", tree))
+      ROS_WARN("Failed to construct kdl tree from robot_description. Looking up all frames via tf!");
+    else
+      initForwardKinematics(tree);
+  }
+
+  if(!joint_index_.empty())
+    topic_sub_joint_states_ = nh_.subscribe("/joint_states", 1, &FootprintObserver::jointStatesCB, this);
+
   last_tf_missing_ = ros::Time::now();
 }
 
@@ -101,6 +152,101 @@ FootprintObserver::FootprintObserver() :
 FootprintObserver::~FootprintObserver()
 {}
 
+// sets up the forward kinematics of the checked frames which are part of the robot description
+void FootprintObserver::initForwardKinematics(const KDL::Tree &tree){
+  std::vector<unsigned int> base_joints;
+  if(!addFkFrame(tree, robot_base_frame_, fk_base_, base_joints)) {
+    ROS_WARN("Robot base frame %s is not part of robot_description. Looking up all frames via tf!", robot_base_frame_.c_str());
+    return;
+  }
+
+  unsigned int fk_frames = 0;
+  for(unsigned int i=0; i<frames_.size(); ++i) {
+    CheckedFrame &frame = frames_[i];
+    frame.joints = base_joints;
+    frame.in_tree = addFkFrame(tree, frame.name, frame.fk_index, frame.joints);
+    if(frame.in_tree)
+      ++fk_frames;
+  }
+
+  fk_poses_.resize(fk_segments_.size());
+  joint_positions_.assign(joint_index_.size(), 0.0);
+  joint_received_.assign(joint_index_.size(), false);
+  joints_arrived_ = true;
+  joints_changed_ = true;
+
+  ROS_DEBUG("Footprint Observer: %u frames computed from %u joints, %u frames looked up via tf",
+            fk_frames, (unsigned int)joint_index_.size(), (unsigned int)frames_.size() - fk_frames);
+}
+
+// adds the chain from the root of the tree to frame, segments shared with other frames are only added once
+bool FootprintObserver::addFkFrame(const KDL::Tree &tree, const std::string &frame, int &index, std::vector<unsigned int> &joints){
+  std::string segment_name = frame;
+  if(!segment_name.empty() && segment_name[0] == '/')
+    segment_name.erase(0, 1);
+
+  KDL::Chain chain;
+  if(!tree.getChain(tree.getRootSegment()->first, segment_name, chain))
+    return false;
+
+  index = -1;
+  for(unsigned int i=0; i<chain.getNrOfSegments(); ++i) {
+    const KDL::Segment &segment = chain.getSegment(i);
+
+    // chains share their segments near the root
+    int existing = -1;
+    for(unsigned int j=0; j<fk_segments_.size(); ++j) {
+      if(fk_segments_[j].segment.getName() == segment.getName()) {
+        existing = j;
+        break;
+      }
+    }
+
+    if(existing < 0) {
+      FkSegment fk_segment;
+      fk_segment.segment = segment;
+      fk_segment.parent = index;
+      fk_segment.joint = -1;
+      if(segment.getJoint().getType() != KDL::Joint::None) {
+        const std::string &joint_name = segment.getJoint().getName();
+        if(joint_index_.find(joint_name) == joint_index_.end()) {
+          unsigned int joint = joint_index_.size();
+          joint_index_[joint_name] = joint;
+        }
+        fk_segment.joint = joint_index_[joint_name];
+      }
+      fk_segments_.push_back(fk_segment);
+      existing = fk_segments_.size() - 1;
+    }
+
+    index = existing;
+    if(fk_segments_[index].joint >= 0)
+      joints.push_back(fk_segments_[index].joint);
+  }
+  return true;
+}
+
+// joint states callback
+void FootprintObserver::jointStatesCB(const sensor_msgs::JointState::ConstPtr &msg){
+  for(unsigned int i=0; i<msg->name.size() && i<msg->position.size(); ++i) {
+    std::map<std::string, unsigned int>::const_iterator it = joint_index_.find(msg->name[i]);
+    if(it == joint_index_.end())
+      continue;
+
+    unsigned int joint = it->second;
+    if(!joint_received_[joint]) {
+      joint_received_[joint] = true;
+      joints_arrived_ = true;
+    }
+    else if(fabs(msg->position[i] - joint_positions_[joint]) <= joint_epsilon_)
+      continue;
+
+    // small motions accumulate until they exceed joint_epsilon_
+    joint_positions_[joint] = msg->position[i];
+    joints_changed_ = true;
+  }
+}
+
 // GetFootprint Service callback
 bool FootprintObserver::getFootprintCB(cob_footprint_observer::GetFootprint::Request &req, cob_footprint_observer::GetFootprint::Response &resp)
 {
@@ -256,99 +402,127 @@ std::vector<geometry_msgs::Point> FootprintObserver::loadRobotFootprint(ros::Nod
     }
   }
 
-  footprint_right_ = 0.0f; footprint_left_ = 0.0f; footprint_front_ = 0.0f; footprint_rear_ = 0.0f;
-  //extract rectangular borders for simplifying:
+  double footprint_right = 0.0f, footprint_left = 0.0f, footprint_front = 0.0f, footprint_rear = 0.0f;
+  //extract rectangular borders to check the dimension:
   for(unsigned int i=0; i<footprint.size(); i++) {
-    if(footprint[i].x > footprint_front_) footprint_front_ = footprint[i].x;
-    if(footprint[i].x < footprint_rear_) footprint_rear_ = footprint[i].x;
-    if(footprint[i].y > footprint_left_) footprint_left_ = footprint[i].y;
-    if(footprint[i].y < footprint_right_) footprint_right_ = footprint[i].y;
+    if(footprint[i].x > footprint_front) footprint_front = footprint[i].x;
+    if(footprint[i].x < footprint_rear) footprint_rear = footprint[i].x;
+    if(footprint[i].y > footprint_left) footprint_left = footprint[i].y;
+    if(footprint[i].y < footprint_right) footprint_right = footprint[i].y;
   }
-  ROS_DEBUG("Extracted rectangular footprint for cob_footprint_observer: Front: %f, Rear %f, Left: %f, Right %f",
-            footprint_front_, footprint_rear_, footprint_left_, footprint_right_);
+  ROS_DEBUG("Extracted rectangular borders of footprint for cob_footprint_observer: Front: %f, Rear %f, Left: %f, Right %f",
+            footprint_front, footprint_rear, footprint_left, footprint_right);
 
-  if ( fabs(footprint_front_ - footprint_rear_) == 0.0 || fabs(footprint_right_ - footprint_left_) == 0.0){
+  if ( fabs(footprint_front - footprint_rear) == 0.0 || fabs(footprint_right - footprint_left) == 0.0){
     ROS_WARN("Footprint has no physical dimension!");
   }
 
-  // save initial footprint
-  footprint_front_initial_ = footprint_front_;
-  footprint_rear_initial_ = footprint_rear_;
-  footprint_left_initial_ = footprint_left_;
-  footprint_right_initial_ = footprint_right_;
-
   return footprint;
 }
 
 // checks if footprint has to be adjusted and does so if necessary
 void FootprintObserver::checkFootprint(){
-  // check each frame
-  std::string frame;
-  std::stringstream ss;
-  ss << frames_to_check_;
+  // a frame of the robot description is looked up via tf until all joints of its chain have been received
+  if(joints_arrived_) {
+    for(unsigned int i=0; i<frames_.size(); ++i) {
+      CheckedFrame &frame = frames_[i];
+      frame.fk_ready = frame.in_tree;
+      for(unsigned int j=0; j<frame.joints.size() && frame.fk_ready; ++j)
+        frame.fk_ready = joint_received_[frame.joints[j]];
+    }
+    joints_arrived_ = false;
+  }
 
-  double x_rear, x_front, y_left, y_right;
-  x_front = footprint_front_initial_;
-  x_rear = footprint_rear_initial_;
-  y_left = footprint_left_initial_;
-  y_right = footprint_right_initial_;
+  bool use_fk = false, use_tf = false;
+  for(unsigned int i=0; i<frames_.size(); ++i) {
+    if(frames_[i].fk_ready)
+      use_fk = true;
+    else
+      use_tf = true;
+  }
+
+  // frames of the robot description only move with their joints, frames from tf have to be looked up each time
+  bool compute_fk = use_fk && joints_changed_;
+  if(!compute_fk && !use_tf)
+    return;
+
+  std::vector<geometry_msgs::Point> points = robot_footprint_initial_;
+  geometry_msgs::Point point;
+  point.z = 0;
+
+  if(compute_fk) {
+    // poses of all segments relative to the root of the tree in one pass
+    for(unsigned int i=0; i<fk_segments_.size(); ++i) {
+      const FkSegment &fk_segment = fk_segments_[i];
+      double q = (fk_segment.joint >= 0) ? joint_positions_[fk_segment.joint] : 0.0;
+      if(fk_segment.parent >= 0)
+        fk_poses_[i] = fk_poses_[fk_segment.parent] * fk_segment.segment.pose(q);
+      else
+        fk_poses_[i] = fk_segment.segment.pose(q);
+    }
+    joints_changed_ = false;
+  }
+  KDL::Frame base_inverse = (use_fk && fk_base_ >= 0) ? fk_poses_[fk_base_].Inverse() : KDL::Frame::Identity();
 
   bool missing_frame_exists = false;
-  while(ss >> frame){
+  for(unsigned int i=0; i<frames_.size(); ++i){
+    const CheckedFrame &frame = frames_[i];
+    if(frame.fk_ready) {
+      KDL::Vector frame_position = (frame.fk_index >= 0) ? base_inverse * fk_poses_[frame.fk_index].p : base_inverse.p;
+      point.x = frame_position.x();
+      point.y = frame_position.y();
+      points.push_back(point);
+    }
     // get transform between robot base frame and frame
-    if(tf_listener_.canTransform(robot_base_frame_, frame, ros::Time(0))) {
+    else if(tf_listener_.canTransform(robot_base_frame_, frame.name, ros::Time(0))) {
       tf::StampedTransform transform;
-      tf_listener_.lookupTransform(robot_base_frame_, frame, ros::Time(0), transform);
+      tf_listener_.lookupTransform(robot_base_frame_, frame.name, ros::Time(0), transform);
 
       tf::Vector3 frame_position = transform.getOrigin();
-
-      // check if frame position is outside of current footprint
-      if(frame_position.x() > x_front) x_front = frame_position.x();
-      if(frame_position.x() < x_rear) x_rear = frame_position.x();
-      if(frame_position.y() > y_left) y_left = frame_position.y();
-      if(frame_position.y() < y_right) y_right = frame_position.y();
+      point.x = frame_position.x();
+      point.y = frame_position.y();
+      points.push_back(point);
     } else if ( (ros::Time::now() - last_tf_missing_).toSec() > 10.0
                 && times_warned_ < 3 ) {
       ++times_warned_;
       missing_frame_exists = true;
       ROS_WARN("Footprint Observer: Transformation for %s not available! Frame %s not considered in adjusted footprint!",
-               frame.c_str(), frame.c_str());
+               frame.name.c_str(), frame.name.c_str());
     }
   }
   if (missing_frame_exists)
     last_tf_missing_ = ros::Time::now();
 
-  // check if footprint has changed
-  if ( fabs( footprint_front_ - x_front ) > epsilon_
-       || fabs( footprint_rear_ - x_rear ) > epsilon_
-       || fabs( footprint_left_ - y_left ) > epsilon_
-       || fabs( footprint_right_ - y_right ) > epsilon_ )
-  {
-    pthread_mutex_lock(&m_mutex);
-    // adjust footprint
-    footprint_front_ = x_front;
-    footprint_rear_ = x_rear;
-    footprint_left_ = y_left;
-    footprint_right_ = y_right;
-    pthread_mutex_unlock(&m_mutex);
+  // frames outside of the initial footprint enlarge it
+  std::vector<geometry_msgs::Point> hull = computeConvexHull(points);
+
+  // the hull starts at the point with the smallest x, which may jump between vertices with almost the same x,
+  // so start at the vertex closest to the start of the published footprint before comparing vertex by vertex
+  if(!hull.empty() && !robot_footprint_.empty()) {
+    unsigned int start = 0;
+    double start_dist = std::numeric_limits<double>::infinity();
+    for(unsigned int i=0; i<hull.size(); ++i) {
+      double dist = hypot(hull[i].x - robot_footprint_[0].x, hull[i].y - robot_footprint_[0].y);
+      if(dist < start_dist) {
+        start_dist = dist;
+        start = i;
+      }
+    }
+    std::rotate(hull.begin(), hull.begin() + start, hull.end());
+  }
 
-    // create new footprint vector
-    geometry_msgs::Point point;
-    std::vector<geometry_msgs::Point> points;
-
-    point.x = footprint_front_;
-    point.y = footprint_left_;
-    point.z = 0;
-    points.push_back(point);
-    point.y = footprint_right_;
-    points.push_back(point);
-    point.x = footprint_rear_;
-    points.push_back(point);
-    point.y = footprint_left_;
-    points.push_back(point);
+  // check if footprint has changed
+  bool changed = (hull.size() != robot_footprint_.size());
+  for(unsigned int i=0; i<hull.size() && !changed; ++i) {
+    if ( fabs( hull[i].x - robot_footprint_[i].x ) > epsilon_
+         || fabs( hull[i].y - robot_footprint_[i].y ) > epsilon_ )
+      changed = true;
+  }
 
+  if(changed)
+  {
     pthread_mutex_lock(&m_mutex);
-    robot_footprint_ = points;
+    robot_footprint_ = hull;
     pthread_mutex_unlock(&m_mutex);
 
     // publish the adjusted footprint
@@ -357,6 +531,33 @@ void FootprintObserver::checkFootprint(){
 
 }
 
+// computes the convex hull (monotone chain)
+std::vector<geometry_msgs::Point> FootprintObserver::computeConvexHull(std::vector<geometry_msgs::Point> points){
+  std::sort(points.begin(), points.end(), PointLess());
+
+  if(points.size() < 3)
+    return points;
+
+  std::vector<geometry_msgs::Point> hull(2 * points.size());
+  unsigned int k = 0;
+
+  // lower hull
+  for(unsigned int i=0; i<points.size(); ++i) {
+    while(k >= 2 && cross(hull[k-2], hull[k-1], points[i]) <= 0.0) --k;
+    hull[k++] = points[i];
+  }
+
+  // upper hull
+  for(int i=points.size()-2, t=k+1; i>=0; --i) {
+    while(k >= (unsigned int)t && cross(hull[k-2], hull[k-1], points[i]) <= 0.0) --k;
+    hull[k++] = points[i];
+  }
+
+  // last point equals the first one
+  hull.resize(k - 1);
+  return hull;
+}
+
 // publishes the adjusted footprint
 void FootprintObserver::publishFootprint(){
 
@@ -39,6 +39,7 @@
 #include <std_msgs/Float64MultiArray.h>
 #include <sensor_msgs/JointState.h>
 #include <geometry_msgs/Twist.h>
+#include <geometry_msgs/TwistStamped.h>
 #include <std_srvs/Trigger.h>
 #include <cob_srvs/SetString.h>
 
@@ -52,14 +53,17 @@
 #include <kdl_parser/kdl_parser.hpp>
 #include <kdl/chainiksolvervel_pinv.hpp>
 #include <kdl/chainfksolvervel_recursive.hpp>
+#include <kdl_conversions/kdl_msg.h>
 #include <kdl/frames.hpp>
 #include <kdl/jntarray.hpp>
 #include <kdl/jntarrayvel.hpp>
 
 #include <control_toolbox/pid.h>
+#include <cob_frame_tracker/se3_tracking_controller.h>
 #include <dynamic_reconfigure/server.h>
 #include <dynamic_reconfigure/Reconfigure.h>
 #include <boost/thread/mutex.hpp>
+#include <map>
 
 
 typedef actionlib::SimpleActionServer<cob_frame_tracker::FrameTrackingAction> SAS_FrameTrackingAction_t;
@@ -77,6 +81,7 @@ public:
     CobFrameTracker()
     {
         ht_.hold = false;
+        tip_transform_valid_ = false;
     }
 
     ~CobFrameTracker()
@@ -90,16 +95,19 @@ public:
     void run(const ros::TimerEvent& event);
 
     void jointstateCallback(const sensor_msgs::JointState::ConstPtr& msg);
+    void targetTwistCallback(const geometry_msgs::TwistStamped::ConstPtr& msg);
 
     bool startTrackingCallback(cob_srvs::SetString::Request& request, cob_srvs::SetString::Response& response);
     bool startLookatCallback(cob_srvs::SetString::Request& request, cob_srvs::SetString::Response& response);
     bool stopCallback(std_srvs::Trigger::Request& request, std_srvs::Trigger::Response& response);
 
-    bool getTransform(const std::string& from, const std::string& to, tf::StampedTransform& stamped_tf);
+    bool getCachedTransform(const std::string& from, const std::string& to, tf::StampedTransform& stamped_tf);
+    bool getTrackingTransform(tf::StampedTransform& stamped_tf);
 
     void publishZeroTwist();
     void publishTwist(ros::Duration period, bool do_publish = true);
     void publishHoldTwist(const ros::Duration& period);
+    KDL::Twist getFeedForwardTwist(const tf::StampedTransform& target_tf, const KDL::Frame& error);
 
     /// Action interface
     void goalCB();
@@ -139,15 +147,36 @@ private:
     control_toolbox::Pid pid_controller_rot_y_;
     control_toolbox::Pid pid_controller_rot_z_;
 
+    /// SE3 tracking mode
+    int tracking_mode_;
+    bool use_feed_forward_;
+    SE3TrackingController se3_controller_;
+    ros::Time se3_last_update_;
+    std::string se3_tracking_frame_;
+    std::string se3_target_frame_;
+    tf::StampedTransform last_target_tf_;  // for finite differences, invalid if stamp is zero
+    KDL::Twist ff_twist_;                  // body twist of the target in target coordinates
+    geometry_msgs::TwistStamped::ConstPtr target_twist_msg_;
+    ros::Duration target_twist_timeout_;
+
     /// KDL Conversion
     KDL::Chain chain_;
     KDL::JntArray last_q_;
     KDL::JntArray last_q_dot_;
     boost::shared_ptr<KDL::ChainFkSolverVel_recursive> jntToCartSolver_vel_;
 
+    /// pose of chain_tip_link in chain_base_link, computed from the latest joint state
+    tf::StampedTransform tip_transform_;
+    bool tip_transform_valid_;
+
     tf::TransformListener tf_listener_;
 
+    /// last successful lookups, used if the latest lookup fails and not older than tf_cache_timeout_
+    std::map<std::pair<std::string, std::string>, tf::StampedTransform> tf_cache_;
+    ros::Duration tf_cache_timeout_;
+
     ros::Subscriber jointstate_sub_;
+    ros::Subscriber target_twist_sub_;
     ros::Publisher twist_pub_;
 
     ros::ServiceServer start_tracking_server_;
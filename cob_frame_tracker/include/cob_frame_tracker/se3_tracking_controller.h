@@ -0,0 +1,133 @@
+/*!
+ *****************************************************************
+ * \file
+ *
+ * \note
+ *   Copyright (c) 2016 \n
+ *   Fraunhofer Institute for Manufacturing Engineering
+ *   and Automation (IPA) \n\n
+ *
+ *****************************************************************
+ *
+ * \note
+ *   Project name: care-o-bot
+ * \note
+ *   ROS stack name: cob_control
+ * \note
+ *   ROS package name: cob_frame_tracker
+ *
+ * \brief
+ *   PI controller on the SE(3) log-map error with target twist feed-forward
+ *
+ ****************************************************************/
+
+#ifndef COB_FRAME_TRACKER_SE3_TRACKING_CONTROLLER_H
+#define COB_FRAME_TRACKER_SE3_TRACKING_CONTROLLER_H
+
+#include <cmath>
+#include <kdl/frames.hpp>
+
+/// log map of a rigid body transform: body twist (v, w) with exp(twist) = frame
+inline KDL::Twist logSE3(const KDL::Frame& frame)
+{
+    KDL::Vector w = frame.M.GetRot();  // axis * angle
+    double theta = w.Norm();
+
+    // v = V^-1 * p, V^-1 = I - 1/2 [w]x + c * [w]x^2
+    double c;
+    if (theta < 1e-6)
+    {
+        c = 1.0 / 12.0;
+    }
+    else
+    {
+        c = (1.0 - theta * sin(theta) / (2.0 * (1.0 - cos(theta)))) / (theta * theta);
+    }
+    KDL::Vector wp = w * frame.p;
+    KDL::Vector v = frame.p - 0.5 * wp + c * (w * wp);
+    return KDL::Twist(v, w);
+}
+
+/// saturates the norm of a vector, returns true if it was limited
+inline bool limitNorm(KDL::Vector& vec, double limit)
+{
+    double norm = vec.Norm();
+    if (limit > 0.0 && norm > limit)
+    {
+        vec = vec * (limit / norm);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * PI control of the tracking error as body twist in the tracking frame.
+ * The gains are shared by all translational and all rotational axes, the integral is clamped (norm) and
+ * frozen while the output saturates at the velocity limits (anti-windup).
+ */
+class SE3TrackingController
+{
+public:
+    struct Gains
+    {
+        double p_lin, i_lin, i_clamp_lin;
+        double p_rot, i_rot, i_clamp_rot;
+    };
+
+    SE3TrackingController() : max_vel_lin_(0.0), max_vel_rot_(0.0)
+    {
+        Gains gains = { 1.0, 0.0, 0.0, 1.0, 0.0, 0.0 };
+        gains_ = gains;
+        reset();
+    }
+
+    void setGains(const Gains& gains) { gains_ = gains; }
+    void setLimits(double max_vel_lin, double max_vel_rot)
+    {
+        max_vel_lin_ = max_vel_lin;
+        max_vel_rot_ = max_vel_rot;
+    }
+
+    void reset()
+    {
+        integral_ = KDL::Twist::Zero();
+    }
+
+    /**
+     * error: pose of the target in the tracking frame
+     * feed_forward: twist of the target, as body twist of the tracking frame
+     */
+    KDL::Twist computeCommand(const KDL::Frame& error, const KDL::Twist& feed_forward, double dt)
+    {
+        KDL::Twist log_error = logSE3(error);
+
+        KDL::Twist cmd;
+        cmd.vel = feed_forward.vel + gains_.p_lin * log_error.vel + gains_.i_lin * integral_.vel;
+        cmd.rot = feed_forward.rot + gains_.p_rot * log_error.rot + gains_.i_rot * integral_.rot;
+
+        bool saturated_lin = limitNorm(cmd.vel, max_vel_lin_);
+        bool saturated_rot = limitNorm(cmd.rot, max_vel_rot_);
+
+        if (dt > 0.0)
+        {
+            if (!saturated_lin)
+            {
+                integral_.vel = integral_.vel + dt * log_error.vel;
+                limitNorm(integral_.vel, gains_.i_clamp_lin);
+            }
+            if (!saturated_rot)
+            {
+                integral_.rot = integral_.rot + dt * log_error.rot;
+                limitNorm(integral_.rot, gains_.i_clamp_rot);
+            }
+        }
+        return cmd;
+    }
+
+private:
+    Gains gains_;
+    double max_vel_lin_, max_vel_rot_;
+    KDL::Twist integral_;
+};
+
+#endif  // COB_FRAME_TRACKER_SE3_TRACKING_CONTROLLER_H
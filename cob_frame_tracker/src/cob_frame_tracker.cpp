@@ -98,6 +98,7 @@ bool CobFrameTracker::initialize()
     dof_ = chain_.getNrOfJoints();
     last_q_ = KDL::JntArray(dof_);
     last_q_dot_ = KDL::JntArray(dof_);
+    jntToCartSolver_vel_.reset(new KDL::ChainFkSolverVel_recursive(chain_));
 
     if (nh_tracker.hasParam("movable_trans"))
     {    nh_tracker.getParam("movable_trans", movable_trans_);    }
@@ -133,6 +134,14 @@ bool CobFrameTracker::initialize()
     pid_controller_rot_z_.init(ros::NodeHandle(nh_tracker, "pid_rot_z"));
     pid_controller_rot_z_.reset();
 
+    // SE3 tracking mode, gains and mode are set by dynamic_reconfigure
+    tracking_mode_ = cob_frame_tracker::FrameTracker_PID;
+    use_feed_forward_ = true;
+    se3_controller_.setLimits(max_vel_lin_, max_vel_rot_);
+    double target_twist_timeout;
+    nh_tracker.param("target_twist_timeout", target_twist_timeout, 0.5);
+    target_twist_timeout_ = ros::Duration(target_twist_timeout);
+
     tracking_ = false;
     tracking_goal_ = false;
     lookat_ = false;
@@ -140,6 +149,10 @@ bool CobFrameTracker::initialize()
     target_frame_ = chain_tip_link_;
     lookat_focus_frame_ = "lookat_focus_frame";
 
+    double tf_cache_timeout;
+    nh_tracker.param("tf_cache_timeout", tf_cache_timeout, 0.5);
+    tf_cache_timeout_ = ros::Duration(tf_cache_timeout);
+
     // ABORTION CRITERIA:
     enable_abortion_checking_ = true;
     cart_min_dist_threshold_lin_ = 0.01;
@@ -164,6 +177,7 @@ bool CobFrameTracker::initialize()
     reconfigure_client_ = nh_twist.serviceClient<dynamic_reconfigure::Reconfigure>("set_parameters");
 
     jointstate_sub_ = nh_.subscribe("joint_states", 1, &CobFrameTracker::jointstateCallback, this);
+    target_twist_sub_ = nh_tracker.subscribe("target_twist", 1, &CobFrameTracker::targetTwistCallback, this);
     twist_pub_ = nh_twist.advertise<geometry_msgs::TwistStamped> ("command_twist_stamped", 1);
 
     start_tracking_server_ = nh_tracker.advertiseService("start_tracking", &CobFrameTracker::startTrackingCallback, this);
@@ -221,22 +235,41 @@ void CobFrameTracker::run(const ros::TimerEvent& event)
     }
 }
 
-bool CobFrameTracker::getTransform(const std::string& from, const std::string& to, tf::StampedTransform& stamped_tf)
+/// non-blocking lookup of the latest transform, falls back to the last successful lookup within tf_cache_timeout_
+bool CobFrameTracker::getCachedTransform(const std::string& from, const std::string& to, tf::StampedTransform& stamped_tf)
 {
-    bool transform = false;
-
+    std::pair<std::string, std::string> key(from, to);
     try
     {
-        tf_listener_.waitForTransform(from, to, ros::Time(0), ros::Duration(0.2));
         tf_listener_.lookupTransform(from, to, ros::Time(0), stamped_tf);
-        transform = true;
+        tf_cache_[key] = stamped_tf;
+        return true;
     }
     catch (tf::TransformException& ex)
     {
-        ROS_ERROR("CobFrameTracker::getTransform: \n%s", ex.what());
+        std::map<std::pair<std::string, std::string>, tf::StampedTransform>::const_iterator it = tf_cache_.find(key);
+        if (it != tf_cache_.end() && ros::Time::now() - it->second.stamp_ <= tf_cache_timeout_)
+        {
+            stamped_tf = it->second;
+            return true;
+        }
+        ROS_ERROR_THROTTLE(1, "CobFrameTracker::getCachedTransform: \n%s", ex.what());
     }
+    return false;
+}
 
-    return transform;
+/// pose of the tracking frame in chain_base_link, from forward kinematics if the chain tip is tracked
+bool CobFrameTracker::getTrackingTransform(tf::StampedTransform& stamped_tf)
+{
+    if (tracking_frame_ == chain_tip_link_)
+    {
+        if (tip_transform_valid_)
+        {
+            stamped_tf = tip_transform_;
+        }
+        return tip_transform_valid_;
+    }
+    return getCachedTransform(chain_base_link_, tracking_frame_, stamped_tf);
 }
 
 void CobFrameTracker::publishZeroTwist()
@@ -249,8 +282,9 @@ void CobFrameTracker::publishZeroTwist()
 
 void CobFrameTracker::publishTwist(ros::Duration period, bool do_publish)
 {
-    tf::StampedTransform transform_tf;
-    bool success = this->getTransform(tracking_frame_, target_frame_, transform_tf);
+    // tracking -> target = (base -> tracking)^-1 * (base -> target)
+    tf::StampedTransform tracking_tf, target_tf;
+    bool success = this->getTrackingTransform(tracking_tf) && this->getCachedTransform(chain_base_link_, target_frame_, target_tf);
 
     geometry_msgs::TwistStamped twist_msg;
     twist_msg.header.frame_id = tracking_frame_;
@@ -258,25 +292,65 @@ void CobFrameTracker::publishTwist(ros::Duration period, bool do_publish)
 
     if (!success)
     {
-        ROS_WARN("publishTwist: failed to getTransform");
+        ROS_WARN("publishTwist: failed to getCachedTransform");
         return;
     }
+    tf::Transform transform_tf = tracking_tf.inverseTimes(target_tf);
 
-    if (movable_trans_)
+    if (tracking_mode_ == cob_frame_tracker::FrameTracker_SE3)
     {
-        twist_msg.twist.linear.x = pid_controller_trans_x_.computeCommand(transform_tf.getOrigin().x(), period);
-        twist_msg.twist.linear.y = pid_controller_trans_y_.computeCommand(transform_tf.getOrigin().y(), period);
-        twist_msg.twist.linear.z = pid_controller_trans_z_.computeCommand(transform_tf.getOrigin().z(), period);
-    }
+        ros::Time now = ros::Time::now();
+        if (se3_tracking_frame_ != tracking_frame_ || se3_target_frame_ != target_frame_ ||
+            se3_last_update_.isZero() || (now - se3_last_update_) > ros::Duration(5.0 / update_rate_))
+        {
+            // new tracking task: neither the integral nor the target motion history apply anymore
+            se3_controller_.reset();
+            se3_tracking_frame_ = tracking_frame_;
+            se3_target_frame_ = target_frame_;
+            last_target_tf_.stamp_ = ros::Time(0);
+            ff_twist_ = KDL::Twist::Zero();
+        }
+        se3_last_update_ = now;
 
-    if (movable_rot_)
+        geometry_msgs::Pose error_msg;
+        KDL::Frame error;
+        tf::poseTFToMsg(transform_tf, error_msg);
+        tf::poseMsgToKDL(error_msg, error);
+
+        KDL::Twist feed_forward = KDL::Twist::Zero();
+        if (use_feed_forward_)
+        {
+            feed_forward = getFeedForwardTwist(target_tf, error);
+        }
+
+        KDL::Twist cmd = se3_controller_.computeCommand(error, feed_forward, period.toSec());
+        if (movable_trans_)
+        {
+            tf::vectorKDLToMsg(cmd.vel, twist_msg.twist.linear);
+        }
+        if (movable_rot_)
+        {
+            tf::vectorKDLToMsg(cmd.rot, twist_msg.twist.angular);
+        }
+    }
+    else
     {
-        /// ToDo: Consider angular error as RPY or Quaternion?
-        /// ToDo: What to do about sign conversion (pi->-pi) in angular rotation?
+        if (movable_trans_)
+        {
+            twist_msg.twist.linear.x = pid_controller_trans_x_.computeCommand(transform_tf.getOrigin().x(), period);
+            twist_msg.twist.linear.y = pid_controller_trans_y_.computeCommand(transform_tf.getOrigin().y(), period);
+            twist_msg.twist.linear.z = pid_controller_trans_z_.computeCommand(transform_tf.getOrigin().z(), period);
+        }
 
-        twist_msg.twist.angular.x = pid_controller_rot_x_.computeCommand(transform_tf.getRotation().x(), period);
-        twist_msg.twist.angular.y = pid_controller_rot_y_.computeCommand(transform_tf.getRotation().y(), period);
-        twist_msg.twist.angular.z = pid_controller_rot_z_.computeCommand(transform_tf.getRotation().z(), period);
+        if (movable_rot_)
+        {
+            /// ToDo: Consider angular error as RPY or Quaternion?
+            /// ToDo: What to do about sign conversion (pi->-pi) in angular rotation?
+
+            twist_msg.twist.angular.x = pid_controller_rot_x_.computeCommand(transform_tf.getRotation().x(), period);
+            twist_msg.twist.angular.y = pid_controller_rot_y_.computeCommand(transform_tf.getRotation().y(), period);
+            twist_msg.twist.angular.z = pid_controller_rot_z_.computeCommand(transform_tf.getRotation().z(), period);
+        }
     }
 
     /// debug only
@@ -323,10 +397,59 @@ void CobFrameTracker::publishTwist(ros::Duration period, bool do_publish)
     }
 }
 
+/** returns the twist of the target as twist of the tracking frame (coordinates and reference point)
+ * error is the pose of the target in the tracking frame.
+ * A recent twist received on target_twist is used, else the finite difference of the target pose (updated on new tf data only).
+ */
+KDL::Twist CobFrameTracker::getFeedForwardTwist(const tf::StampedTransform& target_tf, const KDL::Frame& error)
+{
+    ros::Time now = ros::Time::now();
+    if (target_twist_msg_ && (now - target_twist_msg_->header.stamp) < target_twist_timeout_)
+    {
+        // velocity of the target origin and angular velocity, rotate into target coordinates
+        tf::StampedTransform frame_tf;
+        if (this->getCachedTransform(target_twist_msg_->header.frame_id, target_frame_, frame_tf))
+        {
+            geometry_msgs::Quaternion q_msg;
+            KDL::Rotation rot;
+            KDL::Twist twist;
+            tf::quaternionTFToMsg(frame_tf.getRotation(), q_msg);
+            tf::quaternionMsgToKDL(q_msg, rot);
+            tf::twistMsgToKDL(target_twist_msg_->twist, twist);
+            return error * (rot.Inverse() * twist);
+        }
+    }
+
+    if (target_tf.stamp_ != last_target_tf_.stamp_)
+    {
+        if (!last_target_tf_.stamp_.isZero() && target_tf.stamp_ > last_target_tf_.stamp_)
+        {
+            // body twist of the target: log(T_prev^-1 * T_now) / dt
+            geometry_msgs::Pose delta_msg;
+            KDL::Frame delta;
+            tf::poseTFToMsg(last_target_tf_.inverseTimes(target_tf), delta_msg);
+            tf::poseMsgToKDL(delta_msg, delta);
+            ff_twist_ = logSE3(delta) / (target_tf.stamp_ - last_target_tf_.stamp_).toSec();
+        }
+        last_target_tf_ = target_tf;
+    }
+    else if ((now - last_target_tf_.stamp_) > target_twist_timeout_)
+    {
+        // static target, no new tf data
+        ff_twist_ = KDL::Twist::Zero();
+    }
+    return error * ff_twist_;
+}
+
+void CobFrameTracker::targetTwistCallback(const geometry_msgs::TwistStamped::ConstPtr& msg)
+{
+    target_twist_msg_ = msg;
+}
+
 void CobFrameTracker::publishHoldTwist(const ros::Duration& period)
 {
     tf::StampedTransform transform_tf;
-    bool success = this->getTransform(chain_base_link_, tracking_frame_, transform_tf);
+    bool success = this->getTrackingTransform(transform_tf);
 
     geometry_msgs::TwistStamped twist_msg;
     twist_msg.header.frame_id = tracking_frame_;
@@ -702,12 +825,20 @@ void CobFrameTracker::jointstateCallback(const sensor_msgs::JointState::ConstPtr
         ///---------------------------------------------------------------------
         KDL::FrameVel FrameVel;
         KDL::JntArrayVel jntArrayVel = KDL::JntArrayVel(last_q_, last_q_dot_);
-        jntToCartSolver_vel_.reset(new KDL::ChainFkSolverVel_recursive(chain_));
         int ret = jntToCartSolver_vel_->JntToCart(jntArrayVel, FrameVel, -1);
         if (ret >= 0)
         {
             KDL::Twist twist = FrameVel.GetTwist();
             current_twist_ = twist;
+
+            // pose of the chain tip at joint state time, replaces the TF lookup in the control loop
+            geometry_msgs::Pose pose;
+            tf::poseKDLToMsg(FrameVel.GetFrame(), pose);
+            tf::poseMsgToTF(pose, tip_transform_);
+            tip_transform_.stamp_ = msg->header.stamp;
+            tip_transform_.frame_id_ = chain_base_link_;
+            tip_transform_.child_frame_id_ = chain_tip_link_;
+            tip_transform_valid_ = true;
         }
         else
         {
@@ -726,6 +857,17 @@ void CobFrameTracker::reconfigureCallback(cob_frame_tracker::FrameTrackerConfig&
     twist_dead_threshold_rot_ = config.twist_dead_threshold_rot;
     twist_deviation_threshold_lin_ = config.twist_deviation_threshold_lin;
     twist_deviation_threshold_rot_ = config.twist_deviation_threshold_rot;
+
+    tracking_mode_ = config.tracking_mode;
+    use_feed_forward_ = config.use_feed_forward;
+    SE3TrackingController::Gains gains;
+    gains.p_lin = config.p_gain_lin;
+    gains.i_lin = config.i_gain_lin;
+    gains.i_clamp_lin = config.i_clamp_lin;
+    gains.p_rot = config.p_gain_rot;
+    gains.i_rot = config.i_gain_rot;
+    gains.i_clamp_rot = config.i_clamp_rot;
+    se3_controller_.setGains(gains);
 }
 
 /** checks whether the twist is infinitesimally small **/
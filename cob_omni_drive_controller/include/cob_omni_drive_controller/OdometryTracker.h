@@ -41,15 +41,74 @@
  ****************************************************************/
 
 #include <nav_msgs/Odometry.h>
+#include <tf/transform_datatypes.h>
 
 #ifndef COB_ODOMETRY_TRACKER_H
 #define COB_ODOMETRY_TRACKER_H
 
 class OdometryTracker{
+public:
+    enum Integration {
+        MIDPOINT,       // midpoint rule for translation, Euler for rotation
+        EXPONENTIAL     // exact SE(2) exponential map of the (averaged) twist
+    };
+private:
     nav_msgs::Odometry odom_;
     double theta_rob_rad_;
+    Integration integration_;
+
+    /** Odometry noise model, variances of the twist grow with the speed:
+        *  var(vel_x) = var(vel_y) = trans_trans * |v|^2 + trans_rot * w^2
+        *  var(vel_theta) = rot_trans * |v|^2 + rot_rot * w^2
+        */
+    double noise_trans_trans_, noise_trans_rot_, noise_rot_trans_, noise_rot_rot_;
+    bool propagate_;
+    double pose_cov_[3][3]; // x, y, theta
+
+    void writePoseCovariance(){
+        static const int idx[3] = { 0, 1, 5 }; // x, y, yaw in 6x6 row-major
+        for(int r = 0; r < 3; ++r)
+            for(int c = 0; c < 3; ++c)
+                odom_.pose.covariance[idx[r]*6+idx[c]] = pose_cov_[r][c];
+    }
+    void propagateCovariance(double dt, double vel_x, double vel_y, double vel_theta, double sinc, double cosc, double sin_theta, double cos_theta, double dx, double dy){
+        const double v2 = vel_x*vel_x + vel_y*vel_y;
+        const double w2 = vel_theta*vel_theta;
+        const double q[3] = { noise_trans_trans_ * v2 + noise_trans_rot_ * w2,
+                              noise_trans_trans_ * v2 + noise_trans_rot_ * w2,
+                              noise_rot_trans_ * v2 + noise_rot_rot_ * w2 };
+
+        // P = F * P * F^T, F = [1 0 -dy; 0 1 dx; 0 0 1]
+        double fp[3][3];
+        for(int c = 0; c < 3; ++c){
+            fp[0][c] = pose_cov_[0][c] - dy * pose_cov_[2][c];
+            fp[1][c] = pose_cov_[1][c] + dx * pose_cov_[2][c];
+            fp[2][c] = pose_cov_[2][c];
+        }
+        for(int r = 0; r < 3; ++r){
+            pose_cov_[r][0] = fp[r][0] - dy * fp[r][2];
+            pose_cov_[r][1] = fp[r][1] + dx * fp[r][2];
+            pose_cov_[r][2] = fp[r][2];
+        }
+
+        // P += G * Q * G^T, columns of G: derivatives of the pose increment w.r.t. vel_x, vel_y, vel_theta
+        const double bx[3] = { sinc * dt, -cosc * dt, integration_ == EXPONENTIAL ? -vel_y * dt * dt / 2.0 : 0.0 };
+        const double by[3] = { cosc * dt, sinc * dt, integration_ == EXPONENTIAL ? vel_x * dt * dt / 2.0 : 0.0 };
+        for(int k = 0; k < 3; ++k){
+            const double g[3] = { cos_theta * bx[k] - sin_theta * by[k], sin_theta * bx[k] + cos_theta * by[k], k == 2 ? dt : 0.0 };
+            for(int r = 0; r < 3; ++r)
+                for(int c = 0; c < 3; ++c)
+                    pose_cov_[r][c] += q[k] * g[r] * g[c];
+        }
+        writePoseCovariance();
+
+        odom_.twist.covariance[0] = q[0];
+        odom_.twist.covariance[7] = q[1];
+        odom_.twist.covariance[35] = q[2];
+    }
 public:
-    OdometryTracker(const std::string &from = "odom", const std::string &to = "base_footprint" , double cov_pose = 0.1, double cov_twist = 0.1) {
+    OdometryTracker(const std::string &from = "odom", const std::string &to = "base_footprint" , double cov_pose = 0.1, double cov_twist = 0.1)
+    : integration_(MIDPOINT), noise_trans_trans_(0), noise_trans_rot_(0), noise_rot_trans_(0), noise_rot_rot_(0), propagate_(false) {
         odom_.header.frame_id = from;
         odom_.child_frame_id = to;
         for(int i = 0; i < 6; i++){
@@ -62,6 +121,23 @@ public:
         // odom_.twist.twist.angular.y = 0.0;
         init(ros::Time::now());
     }
+    void setIntegration(Integration integration){
+        integration_ = integration;
+    }
+    // enables covariance propagation for x, y and yaw if any factor is positive, the other entries keep cov_pose/cov_twist
+    void setNoiseModel(double trans_trans, double trans_rot, double rot_trans, double rot_rot){
+        noise_trans_trans_ = trans_trans;
+        noise_trans_rot_ = trans_rot;
+        noise_rot_trans_ = rot_trans;
+        noise_rot_rot_ = rot_rot;
+        propagate_ = trans_trans > 0 || trans_rot > 0 || rot_trans > 0 || rot_rot > 0;
+        if(propagate_){
+            for(int r = 0; r < 3; ++r)
+                for(int c = 0; c < 3; ++c)
+                    pose_cov_[r][c] = 0;
+            writePoseCovariance();
+        }
+    }
     void init(const ros::Time &now){
         theta_rob_rad_ = 0;
 
@@ -75,10 +151,19 @@ public:
         odom_.pose.pose.position.y = 0;
         odom_.pose.pose.orientation = tf::createQuaternionMsgFromYaw(theta_rob_rad_);
 
+        if(propagate_){
+            for(int r = 0; r < 3; ++r)
+                for(int c = 0; c < 3; ++c)
+                    pose_cov_[r][c] = 0;
+            writePoseCovariance();
+        }
     }
     const nav_msgs::Odometry &getOdometry(){
         return odom_;
     }
+    double getTheta() const {
+        return theta_rob_rad_;
+    }
     void track(const ros::Time &now, double dt, double vel_x, double vel_y, double vel_theta){
         // calculation from ROS odom publisher tutorial http://www.ros.org/wiki/navigation/Tutorials/RobotSetup/Odom, using now midpoint integration
 
@@ -90,12 +175,35 @@ public:
 
             double sin_theta = sin(theta_rob_rad_);
             double cos_theta = cos(theta_rob_rad_);
-            theta_rob_rad_ += vel_theta * dt;
 
-            odom_.pose.pose.position.x += (vel_x_mid * cos_theta - vel_y_mid * sin_theta) * dt;
-            odom_.pose.pose.position.y += (vel_x_mid * sin_theta + vel_y_mid * cos_theta) * dt;
+            // pose increment in robot frame: [sinc -cosc; cosc sinc] * v_mid * dt
+            double sinc = 1.0, cosc = 0.0;
+            double vel_theta_mid = vel_theta;
+            if(integration_ == EXPONENTIAL){
+                vel_theta_mid = (vel_theta+odom_.twist.twist.angular.z)/2.0;
+                const double phi = vel_theta_mid * dt;
+                if(fabs(phi) < 1e-4){
+                    // series expansion of sin(phi)/phi and (1-cos(phi))/phi
+                    sinc = 1.0 - phi*phi/6.0;
+                    cosc = phi/2.0 - phi*phi*phi/24.0;
+                }else{
+                    sinc = sin(phi)/phi;
+                    cosc = (1.0 - cos(phi))/phi;
+                }
+            }
+            const double dx_rob = (sinc * vel_x_mid - cosc * vel_y_mid) * dt;
+            const double dy_rob = (cosc * vel_x_mid + sinc * vel_y_mid) * dt;
+            const double dx = dx_rob * cos_theta - dy_rob * sin_theta;
+            const double dy = dx_rob * sin_theta + dy_rob * cos_theta;
+
+            theta_rob_rad_ += vel_theta_mid * dt;
+
+            odom_.pose.pose.position.x += dx;
+            odom_.pose.pose.position.y += dy;
             odom_.pose.pose.orientation = tf::createQuaternionMsgFromYaw(theta_rob_rad_);
 
+            if(propagate_) propagateCovariance(dt, vel_x_mid, vel_y_mid, vel_theta_mid, sinc, cosc, sin_theta, cos_theta, dx, dy);
+
             odom_.twist.twist.linear.x = vel_x;
             odom_.twist.twist.linear.y = vel_y;
             odom_.twist.twist.angular.z = vel_theta;
@@ -110,13 +110,17 @@ struct WheelData {
     WheelState state_;
 
     /** Exact Position of the Wheels' itself
-        *  in cartesian (X/Y) and polar (Dist/Ang) coordinates
+        *  in cartesian (X/Y) coordinates
         *  relative to robot coordinate System
         */
     double m_dExWheelXPosMM;
     double m_dExWheelYPosMM;
-    double m_dExWheelDistMM;
-    double m_dExWheelAngRad;
+
+    /** sin/cos of the current steering angle,
+        *  evaluated once per cycle in updateState
+        */
+    double m_dSinSteer;
+    double m_dCosSteer;
 
     double m_dVelWheelMMS;
 
@@ -133,6 +137,85 @@ struct WheelData {
     }
 };
 
+/** Direct kinematics data of all wheels as contiguous arrays (one entry per wheel)
+    *  and the parameters of the virtual linking axes between neighbouring wheels.
+    *  Link i connects wheel i and wheel (i+1)%n, it is only recomputed if the steering angle
+    *  of one of its wheels has changed by more than LINK_EPSILON_RAD since the last evaluation.
+    */
+class WheelKinematics {
+public:
+    static const double LINK_EPSILON_RAD;
+
+    void resize(size_t n);
+    size_t size() const { return steer_.size(); }
+
+    // copy kinematic state of a single wheel
+    void set(size_t i, const WheelData &wheel);
+
+    // refresh outdated link parameters
+    void updateLinks();
+
+    void calcDirect(PlatformState &state) const;
+
+    double getSteerRad(size_t i) const { return steer_[i]; }
+    double getPosXMM(size_t i) const { return ex_x_[i]; }
+    double getPosYMM(size_t i) const { return ex_y_[i]; }
+    double getVelXMMS(size_t i) const { return vel_[i] * cos_[i]; }
+    double getVelYMMS(size_t i) const { return vel_[i] * sin_[i]; }
+
+private:
+    std::vector<double> ex_x_, ex_y_, vel_, sin_, cos_, steer_;
+
+    /** link axis (dX, dY) scaled by 1/dist^2,
+        *  together with the steering angles it was computed for
+        */
+    std::vector<double> link_x_, link_y_, link_steer1_, link_steer2_;
+};
+
+/** Alternative to the pair-wise direct kinematics:
+    *  solves the overdetermined rigid body equations of all wheels
+    *    vel_x - rot * y_i = v_i * cos(phi_i)
+    *    vel_y + rot * x_i = v_i * sin(phi_i)
+    *  with weighted least squares.
+    *  The pseudoinverse for unit weights is cached as long as no steering angle changes by more than WheelKinematics::LINK_EPSILON_RAD.
+    *  Wheels with a residual above the slip threshold get the weight (threshold/residual)^2, this is iterated up to max_iterations times.
+    */
+class LeastSquaresOdometry {
+public:
+    LeastSquaresOdometry(double slip_threshold_mms = 50.0, int max_iterations = 3);
+
+    void configure(double slip_threshold_mms, int max_iterations);
+
+    // returns false if the geometry is degenerated, state is not changed in that case
+    bool estimate(const WheelKinematics &kinematics, PlatformState &state);
+
+    // RMS of the residual velocities of all wheels in mm/s
+    double getResidualMMS() const { return residual_rms_; }
+
+    const std::vector<double>& getWheelResiduals() const { return residuals_; }
+    const std::vector<double>& getWheelWeights() const { return weights_; }
+
+private:
+    double slip_threshold_mms_;
+    int max_iterations_;
+
+    std::vector<double> steer_; // steering configuration of the cached pseudoinverse
+    bool valid_;
+
+    /** rows of the 3x2N pseudoinverse (vel_x, vel_y, rot),
+        *  split into the columns for the x and y equations of each wheel
+        */
+    std::vector<double> pinv_x_vx_, pinv_x_vy_, pinv_x_rot_;
+    std::vector<double> pinv_y_vx_, pinv_y_vy_, pinv_y_rot_;
+
+    std::vector<double> residuals_, weights_;
+    double residual_rms_;
+
+    void updatePseudoInverse(const WheelKinematics &kinematics);
+    bool solveWeighted(const WheelKinematics &kinematics, PlatformState &state) const;
+    double updateResiduals(const WheelKinematics &kinematics, const PlatformState &state);
+};
+
 class UndercarriageGeomBase
 {
 public:
@@ -145,41 +228,39 @@ public:
     virtual ~UndercarriageGeomBase() {}
 
 protected:
-    template<typename V> static void updateWheelStates(V& wheels, const std::vector<WheelState> &states)
+    template<typename V> void updateWheelStates(V& wheels, const std::vector<WheelState> &states)
     {
         if(wheels.size() != states.size()) throw std::length_error("number of states does not match number of wheels");
 
         for(size_t i = 0; i < wheels.size(); ++i){
             wheels[i]->updateState(states[i]);
         }
+        syncKinematics(wheels);
     }
 
-    template<typename V> static void calcDirect(PlatformState &state, const V& wheels)
+    template<typename V> void syncKinematics(const V& wheels)
     {
-        double dtempRotRobRADPS = 0;    // Robot-Rotation-Rate in rad/s (in Robot-Coordinateframe)
-        double dtempVelXRobMMS = 0;     // Robot-Velocity in x-Direction (longitudinal) in mm/s (in Robot-Coordinateframe)
-        double dtempVelYRobMMS = 0;     // Robot-Velocity in y-Direction (lateral) in mm/s (in Robot-Coordinateframe)
-
-        // calculate rotational rate of robot and current "virtual" axis between all wheels
-        for(int i = 0; i < wheels.size() ; i++)
-        {
-            const WheelData &wheel = *wheels[i];
-            const WheelData &other_wheel = *wheels[(i+1) % wheels.size()];
-
-            dtempRotRobRADPS += WheelData::mergeRotRobRadS(wheel, other_wheel);
-            dtempVelXRobMMS += wheel.getVelX();
-            dtempVelYRobMMS += wheel.getVelY();
+        kinematics_.resize(wheels.size());
+        for(size_t i = 0; i < wheels.size(); ++i){
+            kinematics_.set(i, *wheels[i]);
         }
+        kinematics_.updateLinks();
+    }
 
-        // assign rotational velocities for output
-        state.dRotRobRadS = dtempRotRobRADPS/wheels.size();
-
-        // assign linear velocity of robot for output
-        state.dVelLongMMS = dtempVelXRobMMS/wheels.size();
-        state.dVelLatMMS = dtempVelYRobMMS/wheels.size();
+    void calcDirectKinematics(PlatformState &state) const
+    {
+        kinematics_.calcDirect(state);
+    }
 
+public:
+    // Get result of direct kinematics, estimated with least squares over all wheels
+    bool calcDirectLeastSquares(PlatformState &state, LeastSquaresOdometry &estimator) const
+    {
+        return estimator.estimate(kinematics_, state);
     }
 
+private:
+    WheelKinematics kinematics_;
 };
 
 class UndercarriageGeom : public UndercarriageGeomBase {
@@ -210,11 +291,12 @@ public:
         for(typename std::vector<T2>::const_iterator it = params.begin(); it != params.end(); ++it){
             wheels_.push_back(boost::make_shared<T>(*it));
         }
+        syncKinematics(wheels_);
     }
 
     // Get result of direct kinematics
     virtual void calcDirect(PlatformState &state) const {
-        UndercarriageGeomBase::calcDirect(state, wheels_);
+        calcDirectKinematics(state);
     }
 
     // Set actual values of wheels (steer/drive velocity/position) (Istwerte)
@@ -0,0 +1,118 @@
+#ifndef H_STUCK_DETECTOR_IMPL
+#define H_STUCK_DETECTOR_IMPL
+
+#include <cob_omni_drive_controller/UndercarriageCtrlGeom.h>
+
+#include <vector>
+#include <cmath>
+
+namespace cob_omni_drive_controller
+{
+
+// rolling mean over a fixed-size ring buffer, the sum is recomputed on every wrap-around to avoid drift
+class RollingMean {
+    std::vector<double> ring_;
+    size_t next_;
+    size_t count_;
+    double sum_;
+public:
+    RollingMean() : next_(0), count_(0), sum_(0) {}
+    void resize(size_t n){
+        ring_.resize(n);
+        reset();
+    }
+    void reset(){
+        next_ = count_ = 0;
+        sum_ = 0;
+    }
+    void push(double value){
+        if(ring_.empty()) return;
+        if(count_ == ring_.size()) sum_ -= ring_[next_];
+        else ++count_;
+        ring_[next_] = value;
+        sum_ += value;
+        if(++next_ == ring_.size()){
+            next_ = 0;
+            sum_ = 0;
+            for(size_t i = 0; i < count_; ++i) sum_ += ring_[i];
+        }
+    }
+    bool full() const { return count_ == ring_.size() && count_ > 0; }
+    double mean() const { return count_ ? sum_ / count_ : 0.0; }
+};
+
+/** Compares commanded and measured wheel motion each cycle.
+    * For every wheel the rolling means of the absolute
+    *  - drive velocity error (command of the previous cycle vs. measurement)
+    *  - steer velocity error (command of the previous cycle vs. measurement)
+    *  - steering angle error of the controller
+    *  - residual against the rigid body motion of the platform (least squares estimate)
+    * are tracked, a wheel is stuck if any mean exceeds its threshold over a full window.
+    * A threshold of 0 disables the criterion.
+    */
+class StuckDetector {
+public:
+    enum Channel { DRIVE_ERROR, STEER_ERROR, STEER_ANGLE_ERROR, SLIP_RESIDUAL, NUM_CHANNELS };
+
+    StuckDetector() : window_(0) {
+        for(int c = 0; c < NUM_CHANNELS; ++c) thresholds_[c] = 0;
+    }
+
+    void configure(size_t num_wheels, size_t window, const double (&thresholds)[NUM_CHANNELS]){
+        window_ = window;
+        for(int c = 0; c < NUM_CHANNELS; ++c){
+            thresholds_[c] = thresholds[c];
+            means_[c].resize(num_wheels);
+            for(size_t i = 0; i < num_wheels; ++i) means_[c][i].resize(window);
+        }
+        stuck_.assign(num_wheels, false);
+        slip_estimator_.configure(thresholds[SLIP_RESIDUAL] * 1000.0, 3);
+    }
+    bool enabled() const { return window_ > 0; }
+
+    void reset(){
+        for(int c = 0; c < NUM_CHANNELS; ++c)
+            for(size_t i = 0; i < means_[c].size(); ++i) means_[c][i].reset();
+        stuck_.assign(stuck_.size(), false);
+    }
+
+    // returns true if any wheel is stuck
+    bool update(const UndercarriageGeomBase &geom, const std::vector<WheelCommand> &commands, const std::vector<WheelState> &states){
+        if(!enabled()) return false;
+
+        bool slip_valid = false;
+        if(thresholds_[SLIP_RESIDUAL] > 0){
+            PlatformState state;
+            slip_valid = geom.calcDirectLeastSquares(state, slip_estimator_);
+        }
+
+        bool any = false;
+        for(size_t i = 0; i < states.size(); ++i){
+            means_[DRIVE_ERROR][i].push(fabs(commands[i].dVelGearDriveRadS - states[i].dVelGearDriveRadS));
+            means_[STEER_ERROR][i].push(fabs(commands[i].dVelGearSteerRadS - states[i].dVelGearSteerRadS));
+            means_[STEER_ANGLE_ERROR][i].push(fabs(commands[i].dAngGearSteerRadDelta));
+            means_[SLIP_RESIDUAL][i].push(slip_valid ? slip_estimator_.getWheelResiduals()[i] / 1000.0 : 0.0);
+
+            stuck_[i] = false;
+            for(int c = 0; c < NUM_CHANNELS; ++c){
+                if(thresholds_[c] > 0 && means_[c][i].full() && means_[c][i].mean() >= thresholds_[c]) stuck_[i] = true;
+            }
+            any = any || stuck_[i];
+        }
+        return any;
+    }
+
+    double getMean(Channel channel, size_t wheel) const { return means_[channel][wheel].mean(); }
+    bool isStuck(size_t wheel) const { return stuck_[wheel]; }
+
+private:
+    size_t window_;
+    double thresholds_[NUM_CHANNELS];
+    std::vector<RollingMean> means_[NUM_CHANNELS];
+    std::vector<bool> stuck_;
+    LeastSquaresOdometry slip_estimator_;
+};
+
+}
+
+#endif
@@ -56,6 +56,8 @@
 #include <math.h>
 #include <angles/angles.h>
 #include <stdexcept>
+#include <limits>
+#include <algorithm>
 #include <boost/shared_ptr.hpp>
 
 
@@ -89,15 +91,12 @@ double getWeightedDelta(double current_position, double old_target, double new_t
 void WheelData::updateState(const WheelState &state){
     state_ = state;
 
-    // calculate current geometry of robot (exact wheel position, taking into account steering offset of wheels)
-    m_dExWheelXPosMM = geom_.dWheelXPosMM + geom_.dDistSteerAxisToDriveWheelMM * sin(state_.dAngGearSteerRad);
-    m_dExWheelYPosMM = geom_.dWheelYPosMM - geom_.dDistSteerAxisToDriveWheelMM * cos(state_.dAngGearSteerRad);
-
-    // calculate distance from platform center to wheel center
-    m_dExWheelDistMM = sqrt( (m_dExWheelXPosMM * m_dExWheelXPosMM) + (m_dExWheelYPosMM * m_dExWheelYPosMM) );
+    m_dSinSteer = sin(state_.dAngGearSteerRad);
+    m_dCosSteer = cos(state_.dAngGearSteerRad);
 
-    // calculate direction of rotational vector
-    m_dExWheelAngRad = MathSup::atan4quad( m_dExWheelYPosMM, m_dExWheelXPosMM);
+    // calculate current geometry of robot (exact wheel position, taking into account steering offset of wheels)
+    m_dExWheelXPosMM = geom_.dWheelXPosMM + geom_.dDistSteerAxisToDriveWheelMM * m_dSinSteer;
+    m_dExWheelYPosMM = geom_.dWheelYPosMM - geom_.dDistSteerAxisToDriveWheelMM * m_dCosSteer;
 
     m_dVelWheelMMS = geom_.dRadiusWheelMM * (state_.dVelGearDriveRadS - dFactorVel* state_.dVelGearSteerRadS);
 }
@@ -118,19 +117,235 @@ double WheelData::mergeRotRobRadS(const WheelData &wheel1, const WheelData &whee
 }
 
 double WheelData::getVelX() const {
-    return m_dVelWheelMMS*cos(state_.dAngGearSteerRad);
+    return m_dVelWheelMMS*m_dCosSteer;
 }
 double WheelData::getVelY() const {
-    return m_dVelWheelMMS*sin(state_.dAngGearSteerRad);
+    return m_dVelWheelMMS*m_dSinSteer;
+}
+
+const double WheelKinematics::LINK_EPSILON_RAD = 1e-6;
+
+void WheelKinematics::resize(size_t n){
+    if(n == steer_.size()) return;
+
+    ex_x_.resize(n); ex_y_.resize(n); vel_.resize(n);
+    sin_.resize(n); cos_.resize(n); steer_.resize(n);
+
+    link_x_.resize(n); link_y_.resize(n);
+    // NaN marks all links as outdated
+    link_steer1_.assign(n, std::numeric_limits<double>::quiet_NaN());
+    link_steer2_.assign(n, std::numeric_limits<double>::quiet_NaN());
+}
+
+void WheelKinematics::set(size_t i, const WheelData &wheel){
+    ex_x_[i] = wheel.m_dExWheelXPosMM;
+    ex_y_[i] = wheel.m_dExWheelYPosMM;
+    vel_[i] = wheel.m_dVelWheelMMS;
+    sin_[i] = wheel.m_dSinSteer;
+    cos_[i] = wheel.m_dCosSteer;
+    steer_[i] = wheel.state_.dAngGearSteerRad;
+}
+
+void WheelKinematics::updateLinks(){
+    const size_t n = steer_.size();
+    for(size_t i = 0; i < n; ++i){
+        const size_t j = (i+1) % n;
+
+        // comparisons with NaN are false, so uninitialized links get refreshed as well
+        if(fabs(steer_[i] - link_steer1_[i]) <= LINK_EPSILON_RAD && fabs(steer_[j] - link_steer2_[i]) <= LINK_EPSILON_RAD) continue;
+
+        // virtual linking axis of the two considered wheels
+        double dtempDiffXMM = ex_x_[j] - ex_x_[i];
+        double dtempDiffYMM = ex_y_[j] - ex_y_[i];
+        double dtempRelDistSqr = dtempDiffXMM*dtempDiffXMM + dtempDiffYMM*dtempDiffYMM;
+
+        // sin(phi - phi_link)/dist = (sin(phi)*dX - cos(phi)*dY)/dist^2
+        link_x_[i] = dtempDiffXMM / dtempRelDistSqr;
+        link_y_[i] = dtempDiffYMM / dtempRelDistSqr;
+        link_steer1_[i] = steer_[i];
+        link_steer2_[i] = steer_[j];
+    }
+}
+
+void WheelKinematics::calcDirect(PlatformState &state) const{
+    const size_t n = steer_.size();
+
+    double dtempRotRobRADPS = 0;    // Robot-Rotation-Rate in rad/s (in Robot-Coordinateframe)
+    double dtempVelXRobMMS = 0;     // Robot-Velocity in x-Direction (longitudinal) in mm/s (in Robot-Coordinateframe)
+    double dtempVelYRobMMS = 0;     // Robot-Velocity in y-Direction (lateral) in mm/s (in Robot-Coordinateframe)
+
+    // calculate rotational rate of robot and current "virtual" axis between all wheels
+    for(size_t i = 0; i < n; ++i){
+        const size_t j = (i+1) % n;
+        dtempRotRobRADPS += vel_[j] * (sin_[j] * link_x_[i] - cos_[j] * link_y_[i])
+                          - vel_[i] * (sin_[i] * link_x_[i] - cos_[i] * link_y_[i]);
+    }
+
+    // linear velocities, independent loop over contiguous arrays
+    for(size_t i = 0; i < n; ++i){
+        dtempVelXRobMMS += vel_[i] * cos_[i];
+        dtempVelYRobMMS += vel_[i] * sin_[i];
+    }
+
+    // assign rotational velocities for output
+    state.dRotRobRadS = dtempRotRobRADPS/n;
+
+    // assign linear velocity of robot for output
+    state.dVelLongMMS = dtempVelXRobMMS/n;
+    state.dVelLatMMS = dtempVelYRobMMS/n;
+}
+
+// inverse of the normal matrix A^T*W*A of the rigid body equations, returns false if singular
+static bool invertNormalMatrix(double dW, double dSumX, double dSumY, double dSumR2, double inv[3][3]){
+    // N = [ W 0 -Sy ; 0 W Sx ; -Sy Sx Sr ], det(N) = W * (W*Sr - Sx^2 - Sy^2)
+    const double dSpread = dW * dSumR2 - dSumX*dSumX - dSumY*dSumY;
+    const double det = dW * dSpread;
+    if(!(dW > 0) || !(dSpread > 1e-9 * dW * dSumR2)) return false;
+
+    inv[0][0] = (dW*dSumR2 - dSumX*dSumX) / det;
+    inv[0][1] = inv[1][0] = -dSumX*dSumY / det;
+    inv[0][2] = inv[2][0] = dW*dSumY / det;
+    inv[1][1] = (dW*dSumR2 - dSumY*dSumY) / det;
+    inv[1][2] = inv[2][1] = -dW*dSumX / det;
+    inv[2][2] = dW*dW / det;
+    return true;
+}
+
+LeastSquaresOdometry::LeastSquaresOdometry(double slip_threshold_mms, int max_iterations)
+: valid_(false), residual_rms_(0) {
+    configure(slip_threshold_mms, max_iterations);
 }
+
+void LeastSquaresOdometry::configure(double slip_threshold_mms, int max_iterations){
+    slip_threshold_mms_ = slip_threshold_mms;
+    max_iterations_ = max_iterations;
+}
+
+void LeastSquaresOdometry::updatePseudoInverse(const WheelKinematics &kinematics){
+    const size_t n = kinematics.size();
+
+    if(valid_ && steer_.size() == n){
+        bool changed = false;
+        for(size_t i = 0; i < n && !changed; ++i){
+            changed = !(fabs(kinematics.getSteerRad(i) - steer_[i]) <= WheelKinematics::LINK_EPSILON_RAD);
+        }
+        if(!changed) return;
+    }
+
+    steer_.resize(n);
+    pinv_x_vx_.resize(n); pinv_x_vy_.resize(n); pinv_x_rot_.resize(n);
+    pinv_y_vx_.resize(n); pinv_y_vy_.resize(n); pinv_y_rot_.resize(n);
+
+    double dSumX = 0, dSumY = 0, dSumR2 = 0;
+    for(size_t i = 0; i < n; ++i){
+        const double x = kinematics.getPosXMM(i), y = kinematics.getPosYMM(i);
+        dSumX += x;
+        dSumY += y;
+        dSumR2 += x*x + y*y;
+        steer_[i] = kinematics.getSteerRad(i);
+    }
+
+    double inv[3][3];
+    valid_ = invertNormalMatrix(n, dSumX, dSumY, dSumR2, inv);
+    if(!valid_) return;
+
+    // pinv = N^-1 * A^T, with A_x = [1 0 -y] and A_y = [0 1 x]
+    for(size_t i = 0; i < n; ++i){
+        const double x = kinematics.getPosXMM(i), y = kinematics.getPosYMM(i);
+        pinv_x_vx_[i] = inv[0][0] - inv[0][2] * y;
+        pinv_x_vy_[i] = inv[1][0] - inv[1][2] * y;
+        pinv_x_rot_[i] = inv[2][0] - inv[2][2] * y;
+        pinv_y_vx_[i] = inv[0][1] + inv[0][2] * x;
+        pinv_y_vy_[i] = inv[1][1] + inv[1][2] * x;
+        pinv_y_rot_[i] = inv[2][1] + inv[2][2] * x;
+    }
+}
+
+bool LeastSquaresOdometry::solveWeighted(const WheelKinematics &kinematics, PlatformState &state) const{
+    double dW = 0, dSumX = 0, dSumY = 0, dSumR2 = 0;
+    double g0 = 0, g1 = 0, g2 = 0;
+    for(size_t i = 0; i < kinematics.size(); ++i){
+        const double w = weights_[i];
+        const double x = kinematics.getPosXMM(i), y = kinematics.getPosYMM(i);
+        const double bx = kinematics.getVelXMMS(i), by = kinematics.getVelYMMS(i);
+        dW += w;
+        dSumX += w * x;
+        dSumY += w * y;
+        dSumR2 += w * (x*x + y*y);
+        g0 += w * bx;
+        g1 += w * by;
+        g2 += w * (x * by - y * bx);
+    }
+
+    double inv[3][3];
+    if(!invertNormalMatrix(dW, dSumX, dSumY, dSumR2, inv)) return false;
+
+    state.dVelLongMMS = inv[0][0] * g0 + inv[0][1] * g1 + inv[0][2] * g2;
+    state.dVelLatMMS = inv[1][0] * g0 + inv[1][1] * g1 + inv[1][2] * g2;
+    state.dRotRobRadS = inv[2][0] * g0 + inv[2][1] * g1 + inv[2][2] * g2;
+    return true;
+}
+
+double LeastSquaresOdometry::updateResiduals(const WheelKinematics &kinematics, const PlatformState &state){
+    double dMaxResidual = 0, dSumSqr = 0;
+    for(size_t i = 0; i < kinematics.size(); ++i){
+        const double ex = kinematics.getVelXMMS(i) - (state.dVelLongMMS - state.dRotRobRadS * kinematics.getPosYMM(i));
+        const double ey = kinematics.getVelYMMS(i) - (state.dVelLatMMS + state.dRotRobRadS * kinematics.getPosXMM(i));
+        const double r2 = ex*ex + ey*ey;
+        residuals_[i] = sqrt(r2);
+        dSumSqr += r2;
+        dMaxResidual = std::max(dMaxResidual, residuals_[i]);
+    }
+    residual_rms_ = sqrt(dSumSqr / kinematics.size());
+    return dMaxResidual;
+}
+
+bool LeastSquaresOdometry::estimate(const WheelKinematics &kinematics, PlatformState &state){
+    const size_t n = kinematics.size();
+    updatePseudoInverse(kinematics);
+    if(!valid_) return false;
+
+    residuals_.resize(n);
+    weights_.assign(n, 1.0);
+
+    // unit weights: apply cached pseudoinverse
+    PlatformState estimate;
+    double vx = 0, vy = 0, rot = 0;
+    for(size_t i = 0; i < n; ++i){
+        const double bx = kinematics.getVelXMMS(i), by = kinematics.getVelYMMS(i);
+        vx += pinv_x_vx_[i] * bx + pinv_y_vx_[i] * by;
+        vy += pinv_x_vy_[i] * bx + pinv_y_vy_[i] * by;
+        rot += pinv_x_rot_[i] * bx + pinv_y_rot_[i] * by;
+    }
+    estimate.dVelLongMMS = vx;
+    estimate.dVelLatMMS = vy;
+    estimate.dRotRobRadS = rot;
+
+    double dMaxResidual = updateResiduals(kinematics, estimate);
+
+    // iteratively reweighted least squares, only if a wheel does not fit the rigid body motion
+    for(int it = 0; it < max_iterations_ && dMaxResidual > slip_threshold_mms_; ++it){
+        for(size_t i = 0; i < n; ++i){
+            const double q = slip_threshold_mms_ / residuals_[i];
+            weights_[i] = q < 1.0 ? q*q : 1.0;
+        }
+        if(!solveWeighted(kinematics, estimate)) break;
+        dMaxResidual = updateResiduals(kinematics, estimate);
+    }
+
+    state = estimate;
+    return true;
+}
+
 UndercarriageGeom::UndercarriageGeom(const std::vector<WheelParams> &params){
     for(std::vector<WheelParams>::const_iterator it = params.begin(); it != params.end(); ++it){
         wheels_.push_back(boost::make_shared<WheelData>(it->geom));
     }
+    syncKinematics(wheels_);
 }
 
 void UndercarriageGeom::calcDirect(PlatformState &state) const{
-    UndercarriageGeomBase::calcDirect(state, wheels_);
+    calcDirectKinematics(state);
 }
 
 void UndercarriageGeom::updateWheelStates(const std::vector<WheelState> &states){
@@ -151,8 +366,9 @@ void CtrlData::setTarget(const PlatformState &plt_state){
     double dtempAxVelXRobMMS = plt_state.dVelLongMMS;
     double dtempAxVelYRobMMS = plt_state.dVelLatMMS;
     // Rotational Portion
-    dtempAxVelXRobMMS += plt_state.dRotRobRadS * m_dExWheelDistMM * -sin(m_dExWheelAngRad);
-    dtempAxVelYRobMMS += plt_state.dRotRobRadS * m_dExWheelDistMM * cos(m_dExWheelAngRad);
+    // (dist * -sin(ang), dist * cos(ang)) of the exact wheel position equals (-y, x)
+    dtempAxVelXRobMMS += plt_state.dRotRobRadS * -m_dExWheelYPosMM;
+    dtempAxVelYRobMMS += plt_state.dRotRobRadS * m_dExWheelXPosMM;
 
     // calculate resulting steering angle
     // Wheel has to move in direction of resulting velocity vector of steering axis
@@ -10,15 +10,90 @@
 #include <geometry_msgs/Twist.h>
 
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/bind.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <realtime_tools/realtime_publisher.h>
 #include <cob_omni_drive_controller/WheelCommands.h>
+#include <cob_omni_drive_controller/WheelHealth.h>
+#include <cob_base_velocity_smoother/velocity_smoothing.h>
+#include <std_srvs/Trigger.h>
+
+#include "StuckDetector.h"
 
 namespace cob_omni_drive_controller
 {
 
+// calls the halt service from a dedicated thread, so a slow or missing driver neither blocks the realtime loop
+// nor a callback queue; requests that arrive during a call are merged into one
+class HaltRequester
+{
+    struct State {
+        boost::mutex mutex;
+        boost::condition_variable cond;
+        bool pending, shutdown;
+        int wheel;
+        ros::ServiceClient client;
+    };
+    boost::shared_ptr<State> state_;
+
+    static void run(boost::shared_ptr<State> state){
+        boost::mutex::scoped_lock lock(state->mutex);
+        while(!state->shutdown){
+            if(!state->pending){
+                // the realtime loop only sets the flag, so poll instead of being notified
+                state->cond.timed_wait(lock, boost::posix_time::milliseconds(20));
+                continue;
+            }
+            state->pending = false;
+            int wheel = state->wheel;
+            lock.unlock();
+
+            ROS_ERROR_STREAM("Wheel " << wheel << " is stuck, halting..");
+            std_srvs::Trigger srv;
+            if(!state->client.call(srv) || !srv.response.success){
+                ROS_ERROR_STREAM("Halt failed: " << srv.response.message);
+            }
+            lock.lock();
+        }
+    }
+public:
+    ~HaltRequester() { stop(); }
+
+    void start(const ros::ServiceClient& client){
+        stop();
+        state_.reset(new State());
+        state_->pending = false;
+        state_->shutdown = false;
+        state_->client = client;
+        boost::thread(boost::bind(&HaltRequester::run, state_)).detach();
+    }
+
+    // does not wait for the thread to finish, a pending call keeps the state alive until it returns
+    void stop(){
+        if(!state_) return;
+        {
+            boost::mutex::scoped_lock lock(state_->mutex);
+            state_->shutdown = true;
+        }
+        state_->cond.notify_one();
+        state_.reset();
+    }
+
+    // never blocks, returns false if the request has to be retried
+    bool tryRequest(int wheel){
+        boost::mutex::scoped_try_lock lock(state_->mutex);
+        if(!lock) return false;
+        state_->pending = true;
+        state_->wheel = wheel;
+        return true;
+    }
+};
+
 template<typename T> class WheelControllerBase: public T
 {
 public:
@@ -40,6 +115,8 @@ public:
             return false;
         }
         timeout_.fromSec(timeout);
+
+        if(!setupSmoothing(controller_nh)) return false;
         
         pub_divider_ =  controller_nh.param("pub_divider",0);
 
@@ -53,12 +130,24 @@ public:
         commands_pub_->msg_.steer_target_position.resize(this->wheel_states_.size());
         commands_pub_->msg_.steer_target_error.resize(this->wheel_states_.size());
 
+        if(!setupStuckDetection(root_nh, controller_nh)) return false;
+
         return true;
   }
     virtual void starting(const ros::Time& time){
         this->geom_->reset();
         target_.updated = false;
         cycles_ = 0;
+
+        smoothing_target_ = PlatformState();
+        smoothed_ = cob_base_velocity_smoother::Velocity2D();
+        accel_smoother_.reset(smoothed_);
+        jerk_smoother_.reset(smoothed_);
+
+        stuck_detector_.reset();
+        wheel_commands_.assign(wheel_commands_.size(), WheelCommand());
+        halt_latched_ = false;
+        health_cycles_ = 0;
     }
     void updateCtrl(const ros::Time& time, const ros::Duration& period){
         {
@@ -75,11 +164,17 @@ public:
                 lock.unlock();
 
                 if(target.updated){
-                   this->geom_->setTarget(target.state);
+                    if(smoothing_ != SMOOTHING_NONE) smoothing_target_ = target.state;
+                    else this->geom_->setTarget(target.state);
                 }
             }
         }
 
+        if(smoothing_ != SMOOTHING_NONE) updateSmoothing(time, period);
+
+        // compares the commands of the last cycle with the current measurement
+        if(stuck_detector_.enabled()) updateStuckDetection(time);
+
         this->geom_->calcControlStep(wheel_commands_, period.toSec(), false);
 
         if(cycles_ < pub_divider_ && (++cycles_) == pub_divider_){
@@ -120,6 +215,145 @@ protected:
     ros::Duration timeout_;
     double max_vel_trans_, max_vel_rot_;
 
+    // optional acceleration/jerk limiting of the target at controller rate
+    enum { SMOOTHING_NONE, SMOOTHING_ACCELERATION, SMOOTHING_JERK } smoothing_;
+    cob_base_velocity_smoother::AccelLimitSmoother accel_smoother_;
+    cob_base_velocity_smoother::JerkLimitSmoother jerk_smoother_;
+    PlatformState smoothing_target_;
+    cob_base_velocity_smoother::Velocity2D smoothed_;
+
+    bool setupSmoothing(ros::NodeHandle& controller_nh){
+        double max_acc_trans, max_acc_rot, max_dec_trans, max_dec_rot, max_jerk_trans, max_jerk_rot;
+        controller_nh.param("max_trans_acceleration", max_acc_trans, 0.0);
+        controller_nh.param("max_rot_acceleration", max_acc_rot, 0.0);
+        controller_nh.param("max_trans_deceleration", max_dec_trans, max_acc_trans);
+        controller_nh.param("max_rot_deceleration", max_dec_rot, max_acc_rot);
+        controller_nh.param("max_trans_jerk", max_jerk_trans, 0.0);
+        controller_nh.param("max_rot_jerk", max_jerk_rot, 0.0);
+
+        if(max_acc_trans < 0 || max_acc_rot < 0 || max_dec_trans < 0 || max_dec_rot < 0 || max_jerk_trans < 0 || max_jerk_rot < 0){
+            ROS_ERROR_STREAM("acceleration, deceleration and jerk limits must be non-negative.");
+            return false;
+        }
+
+        smoothing_ = SMOOTHING_NONE;
+        if(max_acc_trans == 0 && max_acc_rot == 0) return true;  // commands are passed through
+
+        if(max_acc_trans == 0 || max_acc_rot == 0 || max_dec_trans == 0 || max_dec_rot == 0){
+            ROS_ERROR_STREAM("Smoothing needs translational and rotational acceleration and deceleration limits.");
+            return false;
+        }
+        if((max_jerk_trans == 0) != (max_jerk_rot == 0)){
+            ROS_ERROR_STREAM("max_trans_jerk and max_rot_jerk must be set both or none.");
+            return false;
+        }
+
+        cob_base_velocity_smoother::Velocity2D accel(max_acc_trans, max_acc_trans, max_acc_rot);
+        cob_base_velocity_smoother::Velocity2D decel(max_dec_trans, max_dec_trans, max_dec_rot);
+        accel_smoother_.setLimits(accel, decel);
+        jerk_smoother_.setLimits(accel, decel);
+        jerk_smoother_.setJerkLimits(cob_base_velocity_smoother::Velocity2D(max_jerk_trans, max_jerk_trans, max_jerk_rot));
+
+        smoothing_ = (max_jerk_trans > 0) ? SMOOTHING_JERK : SMOOTHING_ACCELERATION;
+        return true;
+    }
+
+    void updateSmoothing(const ros::Time& time, const ros::Duration& period){
+        cob_base_velocity_smoother::Velocity2D target(smoothing_target_.getVelX(), smoothing_target_.getVelY(), smoothing_target_.dRotRobRadS);
+        cob_base_velocity_smoother::Velocity2D smoothed;
+        if(smoothing_ == SMOOTHING_JERK){
+            jerk_smoother_.setPeriod(period.toSec());
+            smoothed = jerk_smoother_.update(time.toSec(), target);
+        }else{
+            accel_smoother_.setPeriod(period.toSec());
+            smoothed = accel_smoother_.update(time.toSec(), target);
+        }
+
+        // setTarget keeps the steering angles for zero velocity, so only call it on changes
+        if(smoothed != smoothed_){
+            smoothed_ = smoothed;
+            PlatformState state;
+            state.setVelX(smoothed.x);
+            state.setVelY(smoothed.y);
+            state.dRotRobRadS = smoothed.theta;
+            this->geom_->setTarget(state);
+        }
+    }
+
+    // in-controller stuck detection, halt is requested from a non-realtime thread
+    StuckDetector stuck_detector_;
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<cob_omni_drive_controller::WheelHealth> > health_pub_;
+    uint32_t health_cycles_;
+    uint32_t health_pub_divider_;
+    bool halt_latched_;     // realtime thread only, cleared once all wheels are healthy again
+    HaltRequester halt_requester_;
+
+    bool setupStuckDetection(ros::NodeHandle &root_nh, ros::NodeHandle& controller_nh){
+        ros::NodeHandle nh(controller_nh, "stuck_detection");
+        int window = nh.param("window", 0);
+        double thresholds[StuckDetector::NUM_CHANNELS];
+        nh.param("drive_threshold", thresholds[StuckDetector::DRIVE_ERROR], 0.0);
+        nh.param("steer_threshold", thresholds[StuckDetector::STEER_ERROR], 0.0);
+        nh.param("steer_angle_threshold", thresholds[StuckDetector::STEER_ANGLE_ERROR], 0.0);
+        nh.param("slip_threshold", thresholds[StuckDetector::SLIP_RESIDUAL], 0.0);
+
+        halt_latched_ = false;
+        health_cycles_ = 0;
+        halt_requester_.stop();
+
+        if(window < 0){
+            ROS_ERROR_STREAM("stuck_detection/window must be non-negative.");
+            return false;
+        }
+        for(int c = 0; c < StuckDetector::NUM_CHANNELS; ++c){
+            if(thresholds[c] < 0){
+                ROS_ERROR_STREAM("stuck_detection thresholds must be non-negative.");
+                return false;
+            }
+        }
+        stuck_detector_.configure(this->wheel_states_.size(), window, thresholds);
+        if(!stuck_detector_.enabled()) return true;
+
+        health_pub_divider_ = nh.param("pub_divider", 10);
+        health_pub_.reset(new realtime_tools::RealtimePublisher<cob_omni_drive_controller::WheelHealth>(controller_nh, "wheel_health", 1));
+        health_pub_->msg_.drive_error.resize(this->wheel_states_.size());
+        health_pub_->msg_.steer_error.resize(this->wheel_states_.size());
+        health_pub_->msg_.steer_target_error.resize(this->wheel_states_.size());
+        health_pub_->msg_.slip_residual.resize(this->wheel_states_.size());
+        health_pub_->msg_.stuck.resize(this->wheel_states_.size());
+
+        halt_requester_.start(root_nh.serviceClient<std_srvs::Trigger>(nh.param("halt_service", std::string("driver/halt"))));
+        return true;
+    }
+
+    void updateStuckDetection(const ros::Time& time){
+        bool stuck = stuck_detector_.update(*this->geom_, wheel_commands_, this->wheel_states_);
+
+        if(stuck && !halt_latched_){
+            int wheel = 0;
+            while(!stuck_detector_.isStuck(wheel)) ++wheel;
+            halt_latched_ = halt_requester_.tryRequest(wheel); // otherwise retry next cycle
+        }else if(!stuck){
+            halt_latched_ = false;
+        }
+
+        if(health_cycles_ < health_pub_divider_ && (++health_cycles_) == health_pub_divider_){
+            if(health_pub_->trylock()){
+                ++(health_pub_->msg_.header.seq);
+                health_pub_->msg_.header.stamp = time;
+                for (unsigned i=0; i<this->wheel_states_.size(); i++){
+                    health_pub_->msg_.drive_error[i] = stuck_detector_.getMean(StuckDetector::DRIVE_ERROR, i);
+                    health_pub_->msg_.steer_error[i] = stuck_detector_.getMean(StuckDetector::STEER_ERROR, i);
+                    health_pub_->msg_.steer_target_error[i] = stuck_detector_.getMean(StuckDetector::STEER_ANGLE_ERROR, i);
+                    health_pub_->msg_.slip_residual[i] = stuck_detector_.getMean(StuckDetector::SLIP_RESIDUAL, i);
+                    health_pub_->msg_.stuck[i] = stuck_detector_.isStuck(i);
+                }
+                health_pub_->unlockAndPublish();
+            }
+            health_cycles_ = 0;
+        }
+    }
+
     void topicCallbackTwistCmd(const geometry_msgs::Twist::ConstPtr& msg){
         if(this->isRunning()){
             boost::mutex::scoped_lock lock(mutex_);
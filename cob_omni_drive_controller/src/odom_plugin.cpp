@@ -3,12 +3,14 @@
 
 #include <pluginlib/class_list_macros.h>
 
-#include <tf/transform_broadcaster.h>
+#include <realtime_tools/realtime_publisher.h>
+#include <tf/tfMessage.h>
 
 #include <cob_omni_drive_controller/UndercarriageCtrlGeom.h>
 #include <cob_omni_drive_controller/OdometryTracker.h>
 
 #include <std_srvs/Trigger.h>
+#include <std_msgs/Float64.h>
 
 #include "GeomController.h"
 
@@ -25,13 +27,21 @@ public:
 
         if(!GeomController::init(hw, controller_nh)) return false;
 
-        double publish_rate;
-        if (!controller_nh.getParam("publish_rate", publish_rate)){
-            ROS_ERROR("Parameter 'publish_rate' not set");
-            return false;
-        }
-        if(publish_rate <= 0){
-            ROS_ERROR_STREAM("publish_rate must be positive.");
+        // publish every pub_divider-th cycle, or with publish_rate based on the controller time
+        pub_divider_ = controller_nh.param("pub_divider", 0);
+        double publish_rate = 0;
+        if(pub_divider_ == 0){
+            if (!controller_nh.getParam("publish_rate", publish_rate)){
+                ROS_ERROR("Neither parameter 'publish_rate' nor 'pub_divider' set");
+                return false;
+            }
+            if(publish_rate <= 0){
+                ROS_ERROR_STREAM("publish_rate must be positive.");
+                return false;
+            }
+            publish_period_ = ros::Duration(1/publish_rate);
+        }else if(pub_divider_ < 0){
+            ROS_ERROR_STREAM("pub_divider must be positive.");
             return false;
         }
 
@@ -41,20 +51,44 @@ public:
         const double cov_twist = controller_nh.param("cov_twist", 0.1);
 
         odom_tracker_.reset(new OdometryTracker(frame_id, child_frame_id, cov_pose, cov_twist));
-        odom_ = odom_tracker_->getOdometry();
 
-        topic_pub_odometry_ = controller_nh.advertise<nav_msgs::Odometry>("odometry", 1);
+        const std::string integration = controller_nh.param("integration", std::string("midpoint"));
+        if(integration == "exponential"){
+            odom_tracker_->setIntegration(OdometryTracker::EXPONENTIAL);
+        }else if(integration != "midpoint"){
+            ROS_ERROR_STREAM("Unknown integration '" << integration << "', use 'midpoint' or 'exponential'.");
+            return false;
+        }
+        odom_tracker_->setNoiseModel(controller_nh.param("noise_model/trans_trans", 0.0), controller_nh.param("noise_model/trans_rot", 0.0),
+                                     controller_nh.param("noise_model/rot_trans", 0.0), controller_nh.param("noise_model/rot_rot", 0.0));
+
+        odom_pub_.reset(new realtime_tools::RealtimePublisher<nav_msgs::Odometry>(controller_nh, "odometry", 1));
+
+        const std::string estimator = controller_nh.param("odometry_estimator", std::string("average"));
+        if(estimator == "least_squares"){
+            const double slip_threshold = controller_nh.param("slip_threshold", 0.05);
+            const int reweight_iterations = controller_nh.param("reweight_iterations", 3);
+            if(slip_threshold <= 0 || reweight_iterations < 0){
+                ROS_ERROR("slip_threshold must be positive and reweight_iterations must not be negative.");
+                return false;
+            }
+            lsq_estimator_.reset(new LeastSquaresOdometry(slip_threshold * 1000.0, reweight_iterations));
+            residual_pub_.reset(new realtime_tools::RealtimePublisher<std_msgs::Float64>(controller_nh, "odometry_residual", 1));
+        }else if(estimator != "average"){
+            ROS_ERROR_STREAM("Unknown odometry_estimator '" << estimator << "', use 'average' or 'least_squares'.");
+            return false;
+        }
 
         bool broadcast_tf = true;
         controller_nh.getParam("broadcast_tf", broadcast_tf);
 
         if(broadcast_tf){
-            odom_tf_.header.frame_id = frame_id;
-            odom_tf_.child_frame_id = child_frame_id;
-            tf_broadcast_odometry_.reset(new tf::TransformBroadcaster);
+            tf_pub_.reset(new realtime_tools::RealtimePublisher<tf::tfMessage>(root_nh, "/tf", 100));
+            tf_pub_->msg_.transforms.resize(1);
+            tf_pub_->msg_.transforms[0].header.frame_id = frame_id;
+            tf_pub_->msg_.transforms[0].child_frame_id = child_frame_id;
         }
 
-        publish_timer_ = controller_nh.createTimer(ros::Duration(1/publish_rate), &OdometryController::publish, this);
         service_reset_ = controller_nh.advertiseService("reset_odometry", &OdometryController::srv_reset, this);
 
         return true;
@@ -62,6 +96,8 @@ public:
     virtual void starting(const ros::Time& time){
         if(time != stop_time_) odom_tracker_->init(time); // do not init odometry on restart
         reset_ = false;
+        cycles_ = 0;
+        last_publish_ = time;
     }
 
     virtual bool srv_reset(std_srvs::Trigger::Request &req, std_srvs::Trigger::Response &res)
@@ -84,56 +120,80 @@ public:
 
         updateState();
 
-        geom_->calcDirect(platform_state_);
+        if(!lsq_estimator_ || !geom_->calcDirectLeastSquares(platform_state_, *lsq_estimator_)){
+            geom_->calcDirect(platform_state_);
+        }
 
         odom_tracker_->track(time, period.toSec(), platform_state_.getVelX(), platform_state_.getVelY(), platform_state_.dRotRobRadS);
 
-        boost::mutex::scoped_try_lock lock(mutex_);
-        if(lock){
-            if(reset_){
+        {
+            boost::mutex::scoped_try_lock lock(mutex_);
+            if(lock && reset_){
                 odom_tracker_->init(time);
                 reset_ = false;
             }
-            odom_ =  odom_tracker_->getOdometry();
         }
 
+        publish(time);
     }
     virtual void stopping(const ros::Time& time) { stop_time_ = time; }
 
 private:
     PlatformState platform_state_;
 
-    ros::Publisher topic_pub_odometry_;                 // calculated (measured) velocity, rotation and pose (odometry-based) for the robot
     ros::ServiceServer service_reset_;                  // service to reset odometry to zero
 
-    boost::scoped_ptr<tf::TransformBroadcaster> tf_broadcast_odometry_;    // according transformation for the tf broadcaster
+    // calculated (measured) velocity, rotation and pose (odometry-based) for the robot
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<nav_msgs::Odometry> > odom_pub_;
+    // according transformation for tf
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<tf::tfMessage> > tf_pub_;
+    // RMS of the wheel velocity residuals of the least squares estimate in m/s
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<std_msgs::Float64> > residual_pub_;
+
     boost::scoped_ptr<OdometryTracker> odom_tracker_;
-    ros::Timer publish_timer_;
-    nav_msgs::Odometry odom_;
+    boost::scoped_ptr<LeastSquaresOdometry> lsq_estimator_;
     bool reset_;
     boost::mutex mutex_;
-    geometry_msgs::TransformStamped odom_tf_;
     ros::Time stop_time_;
 
+    int pub_divider_;
+    int cycles_;
+    ros::Duration publish_period_;
+    ros::Time last_publish_;
 
-    void publish(const ros::TimerEvent&){
-        if(!isRunning()) return;
+    void publish(const ros::Time &time){
+        if(pub_divider_ > 0){
+            if(++cycles_ < pub_divider_) return;
+            cycles_ = 0;
+        }else{
+            if(time - last_publish_ < publish_period_) return;
+            last_publish_ += publish_period_;
+            if(time - last_publish_ >= publish_period_) last_publish_ = time; // do not try to catch up after overruns
+        }
 
-        boost::mutex::scoped_lock lock(mutex_);
+        const nav_msgs::Odometry &odom = odom_tracker_->getOdometry();
 
-        topic_pub_odometry_.publish(odom_);
+        // the publisher threads pick up the copies, a busy publisher just skips this cycle
+        if(odom_pub_->trylock()){
+            odom_pub_->msg_ = odom;
+            odom_pub_->unlockAndPublish();
+        }
 
-        if(tf_broadcast_odometry_){
+        if(tf_pub_ && tf_pub_->trylock()){
             // compose and publish transform for tf package
-            // compose header
-            odom_tf_.header.stamp = odom_.header.stamp;
-            // compose data container
-            odom_tf_.transform.translation.x = odom_.pose.pose.position.x;
-            odom_tf_.transform.translation.y = odom_.pose.pose.position.y;
-            odom_tf_.transform.rotation = odom_.pose.pose.orientation;
+            geometry_msgs::TransformStamped &odom_tf = tf_pub_->msg_.transforms[0];
+            odom_tf.header.stamp = odom.header.stamp;
+            odom_tf.transform.translation.x = odom.pose.pose.position.x;
+            odom_tf.transform.translation.y = odom.pose.pose.position.y;
+            odom_tf.transform.rotation = odom.pose.pose.orientation;
 
             // publish the transform (for debugging, conflicts with robot-pose-ekf)
-            tf_broadcast_odometry_->sendTransform(odom_tf_);
+            tf_pub_->unlockAndPublish();
+        }
+
+        if(residual_pub_ && residual_pub_->trylock()){
+            residual_pub_->msg_.data = lsq_estimator_->getResidualMMS() / 1000.0;
+            residual_pub_->unlockAndPublish();
         }
     }
 };
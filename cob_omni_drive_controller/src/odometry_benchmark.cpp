@@ -0,0 +1,194 @@
+//
+// Replay benchmark of the OdometryTracker integration modes.
+// A twist stream with ground truth poses is integrated at controller rate with the midpoint and the
+// exponential map integration, the drift against ground truth and the CPU time per update are reported.
+// For the synthetic stream the propagated covariance is checked against Monte Carlo runs with noisy twists.
+//
+// usage: cob_omni_drive_odometry_benchmark [log.csv|-] [rate]
+//   log.csv: lines "time,vel_x,vel_y,vel_theta,x,y,theta" (time in s, twist in robot frame, ground truth pose),
+//            a synthetic stream with fast rotations is used if omitted or "-"
+//   rate:    rate of the synthetic stream in Hz (default 100)
+//
+#include <ros/time.h>
+#include <cob_omni_drive_controller/OdometryTracker.h>
+
+#include <angles/angles.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct Sample {
+    double stamp;
+    double vel_x, vel_y, vel_theta;
+    double x, y, theta;
+};
+
+bool loadLog(const char *file, std::vector<Sample> &samples){
+    std::ifstream in(file);
+    if(!in) return false;
+
+    std::string line;
+    while(std::getline(in, line)){
+        if(line.empty() || line[0] == '%' || line[0] == '#') continue;
+        std::vector<double> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while(std::getline(ss, field, ',')) fields.push_back(std::atof(field.c_str()));
+        if(fields.size() < 7) continue;
+
+        Sample s = { fields[0], fields[1], fields[2], fields[3], fields[4], fields[5], fields[6] };
+        samples.push_back(s);
+    }
+    return samples.size() > 1;
+}
+
+void twistAt(double t, double &vel_x, double &vel_y, double &vel_theta){
+    // driving while turning fast, with direction changes
+    vel_x = 0.8 * sin(0.3 * t);
+    vel_y = 0.4 * sin(0.2 * t);
+    vel_theta = 2.0 * sin(0.5 * t);
+}
+
+// ground truth by fine integration of the continuous twist
+void syntheticLog(double rate, std::vector<Sample> &samples){
+    const int substeps = 100;
+    const double dt = 1.0 / rate / substeps;
+    double x = 0, y = 0, theta = 0;
+    for(int k = 0; k <= 60 * rate; ++k){
+        Sample s;
+        s.stamp = k / rate;
+        twistAt(s.stamp, s.vel_x, s.vel_y, s.vel_theta);
+        s.x = x; s.y = y; s.theta = theta;
+        samples.push_back(s);
+
+        for(int i = 0; i < substeps; ++i){
+            double vx, vy, w;
+            // RK4 for the kinematic model
+            double t = s.stamp + i * dt;
+            double k1[3], k2[3], k3[3], k4[3];
+            twistAt(t, vx, vy, w);
+            k1[0] = vx*cos(theta) - vy*sin(theta); k1[1] = vx*sin(theta) + vy*cos(theta); k1[2] = w;
+            twistAt(t + dt/2, vx, vy, w);
+            double th = theta + k1[2]*dt/2;
+            k2[0] = vx*cos(th) - vy*sin(th); k2[1] = vx*sin(th) + vy*cos(th); k2[2] = w;
+            th = theta + k2[2]*dt/2;
+            k3[0] = vx*cos(th) - vy*sin(th); k3[1] = vx*sin(th) + vy*cos(th); k3[2] = w;
+            twistAt(t + dt, vx, vy, w);
+            th = theta + k3[2]*dt;
+            k4[0] = vx*cos(th) - vy*sin(th); k4[1] = vx*sin(th) + vy*cos(th); k4[2] = w;
+            x += dt/6 * (k1[0] + 2*k2[0] + 2*k3[0] + k4[0]);
+            y += dt/6 * (k1[1] + 2*k2[1] + 2*k3[1] + k4[1]);
+            theta += dt/6 * (k1[2] + 2*k2[2] + 2*k3[2] + k4[2]);
+        }
+    }
+}
+
+// pose of the ground truth relative to its first sample
+void relativeTruth(const std::vector<Sample> &samples, size_t k, double &x, double &y, double &theta){
+    const Sample &s0 = samples.front(), &s = samples[k];
+    double dx = s.x - s0.x, dy = s.y - s0.y;
+    x = cos(s0.theta) * dx + sin(s0.theta) * dy;
+    y = -sin(s0.theta) * dx + cos(s0.theta) * dy;
+    theta = s.theta - s0.theta;
+}
+
+void replay(const char *name, const std::vector<Sample> &samples, OdometryTracker::Integration integration){
+    OdometryTracker tracker;
+    tracker.setIntegration(integration);
+    tracker.init(ros::Time(samples.front().stamp));
+
+    double max_pos = 0, max_theta = 0, cpu = 0;
+    double pos = 0, ang = 0;
+    for(size_t k = 1; k < samples.size(); ++k){
+        const Sample &s = samples[k];
+        ros::WallTime t0 = ros::WallTime::now();
+        tracker.track(ros::Time(s.stamp), s.stamp - samples[k-1].stamp, s.vel_x, s.vel_y, s.vel_theta);
+        cpu += (ros::WallTime::now() - t0).toNSec();
+
+        double x, y, theta;
+        relativeTruth(samples, k, x, y, theta);
+        const nav_msgs::Odometry &odom = tracker.getOdometry();
+        pos = hypot(odom.pose.pose.position.x - x, odom.pose.pose.position.y - y);
+        ang = fabs(angles::normalize_angle(tracker.getTheta() - theta));
+        max_pos = std::max(max_pos, pos);
+        max_theta = std::max(max_theta, ang);
+    }
+    printf("%-12s final drift %8.5f m %8.5f rad  max drift %8.5f m %8.5f rad  cpu %6.1f ns/update\n",
+           name, pos, ang, max_pos, max_theta, cpu / (samples.size() - 1));
+}
+
+double gaussian(){
+    // Box-Muller
+    double u1 = (rand() + 1.0) / (RAND_MAX + 2.0), u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+// compares the propagated covariance of the final pose with Monte Carlo runs on noisy twists
+void consistency(const std::vector<Sample> &samples){
+    const double trans_trans = 0.01, trans_rot = 0.001, rot_trans = 0.01, rot_rot = 0.01;
+    const int runs = 200;
+
+    double mean[3] = { 0, 0, 0 }, sqr[3] = { 0, 0, 0 };
+    double predicted[3] = { 0, 0, 0 };
+    for(int r = 0; r < runs; ++r){
+        OdometryTracker tracker;
+        tracker.setIntegration(OdometryTracker::EXPONENTIAL);
+        tracker.setNoiseModel(trans_trans, trans_rot, rot_trans, rot_rot);
+        tracker.init(ros::Time(samples.front().stamp));
+
+        double prev_x = 0, prev_y = 0, prev_w = 0;
+        for(size_t k = 1; k < samples.size(); ++k){
+            const Sample &s = samples[k];
+            // the tracker averages consecutive twists, perturb the averaged twist with the model variances
+            const double vx = (s.vel_x + samples[k-1].vel_x) / 2, vy = (s.vel_y + samples[k-1].vel_y) / 2, w = (s.vel_theta + samples[k-1].vel_theta) / 2;
+            const double v2 = vx*vx + vy*vy, w2 = w*w;
+            const double st = sqrt(trans_trans * v2 + trans_rot * w2), sr = sqrt(rot_trans * v2 + rot_rot * w2);
+            const double nx = 2 * (vx + st * gaussian()) - prev_x;
+            const double ny = 2 * (vy + st * gaussian()) - prev_y;
+            const double nw = 2 * (w + sr * gaussian()) - prev_w;
+            tracker.track(ros::Time(s.stamp), s.stamp - samples[k-1].stamp, nx, ny, nw);
+            prev_x = nx; prev_y = ny; prev_w = nw;
+        }
+        const nav_msgs::Odometry &odom = tracker.getOdometry();
+        double v[3] = { odom.pose.pose.position.x, odom.pose.pose.position.y, tracker.getTheta() };
+        for(int i = 0; i < 3; ++i){
+            mean[i] += v[i] / runs;
+            sqr[i] += v[i] * v[i] / runs;
+        }
+        predicted[0] = odom.pose.covariance[0];
+        predicted[1] = odom.pose.covariance[7];
+        predicted[2] = odom.pose.covariance[35];
+    }
+    printf("covariance   var(x) %.5f predicted %.5f  var(y) %.5f predicted %.5f  var(theta) %.5f predicted %.5f  (%d runs)\n",
+           sqr[0] - mean[0]*mean[0], predicted[0], sqr[1] - mean[1]*mean[1], predicted[1], sqr[2] - mean[2]*mean[2], predicted[2], runs);
+}
+
+int main(int argc, char **argv){
+    ros::Time::init();
+
+    std::vector<Sample> samples;
+    bool synthetic = argc < 2 || std::string(argv[1]) == "-";
+    if(!synthetic){
+        if(!loadLog(argv[1], samples)){
+            fprintf(stderr, "could not read log from %s\n", argv[1]);
+            return 1;
+        }
+    }else{
+        syntheticLog(argc > 2 ? atof(argv[2]) : 100.0, samples);
+    }
+
+    printf("%zu samples over %.1f s\n", samples.size(), samples.back().stamp - samples.front().stamp);
+
+    replay("midpoint", samples, OdometryTracker::MIDPOINT);
+    replay("exponential", samples, OdometryTracker::EXPONENTIAL);
+
+    if(synthetic) consistency(samples);
+
+    return 0;
+}
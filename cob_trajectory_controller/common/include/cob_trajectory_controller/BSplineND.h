@@ -20,18 +20,18 @@
 //-----------------------------------------------
 
 #include <vector>
+#include <algorithm>
 #include <cmath>
-#include <assert.h>
 
 #define BSPLINE_TINY 1e-20
 
 
 /**
  * Implements a BSpline curve as a template class.
- * a PointND type needs the following operators:
- * operator=, copy constructor, p1 += p2, p1 * scalar
- * there needs to be a function Distance(p1,p2)
- * there needs to be a member function p1.zero()
+ * a PointND type needs to be a random access container of doubles with size(), resize() and operator[]
+ * (e.g. std::vector<double>). All points need to have the same dimension.
+ * The control points are stored in one contiguous array, points are evaluated with de Boor's algorithm
+ * on the active knot span only.
  */
 template <class PointND>
 class BSplineND
@@ -55,18 +55,25 @@ public:
 
 private:
     //----------------------- Parameters
-    double m_iGrad;
+    int m_iGrad;        // order of the spline (degree + 1)
 
     //----------------------- Variables
-    std::vector<PointND> m_CtrlPointVec;
+    std::vector<double> m_CtrlPoints;   // m_iNumCtrlPoints * m_iDim
+    unsigned int m_iNumCtrlPoints;
+    unsigned int m_iDim;
+    int m_iOrder;       // m_iGrad, reduced if there are not enough control points
 
     std::vector<double> m_KnotVec;
 
     double m_dLength;
 
-    //----------------------- Member functions
-    double evalBasis(double t, unsigned int i, int n);
+    std::vector<double> m_Work;         // de Boor triangle, m_iOrder * m_iDim
 
+    //----------------------- Member functions
+    unsigned int findSpan(double u, unsigned int hint) const;
+    void evalSpan(double u, unsigned int span, PointND& point);
+    double distance(unsigned int i, unsigned int j) const;
+    bool sample(unsigned int iNumOfPoints, std::vector<PointND>& ipoVec);
 };
 
 
@@ -80,6 +87,9 @@ template <class PointND>
 inline BSplineND<PointND>::BSplineND()
 {
     m_iGrad = 3;
+    m_iOrder = 0;
+    m_iNumCtrlPoints = 0;
+    m_iDim = 0;
     m_dLength = 0;
 }
 
@@ -93,55 +103,53 @@ BSplineND<PointND>::~BSplineND()
 template <class PointND>
 void BSplineND<PointND>::setCtrlPoints(const std::vector<PointND>& ctrlPointVec )
 {
-    int iNumCtrlPoint;
-    int i;
-    double d;
+    m_iNumCtrlPoints = ctrlPointVec.size();
+    m_iDim = ctrlPointVec.empty() ? 0 : ctrlPointVec.front().size();
+    m_iOrder = std::min(m_iGrad, (int)m_iNumCtrlPoints);
+    m_dLength = 0;
 
-    m_CtrlPointVec = ctrlPointVec;
-    iNumCtrlPoint = m_CtrlPointVec.size();
+    m_CtrlPoints.resize(m_iNumCtrlPoints * m_iDim);
+    for(unsigned int i = 0; i < m_iNumCtrlPoints; i++)
+    {
+        for(unsigned int k = 0; k < m_iDim; k++)
+        {
+            m_CtrlPoints[i * m_iDim + k] = ctrlPointVec[i][k];
+        }
+    }
+    m_Work.resize(m_iOrder * m_iDim);
 
-    if (iNumCtrlPoint < m_iGrad)
+    if (m_iNumCtrlPoints == 0)
     {
+        m_KnotVec.clear();
         return;
     }
 
-    m_KnotVec.resize( iNumCtrlPoint + m_iGrad );
-
-    // Calculate knots
-    for(i = 0; i< m_iGrad; i++)
+    // clamped knot vector, the internal knots follow the distances of the control points
+    m_KnotVec.assign(m_iNumCtrlPoints + m_iOrder, 0.0);
+    double d = 0.0;
+    if (m_iOrder < 3)
     {
-        m_KnotVec[i] = 0;
+        // straight line or single point
+        d = (m_iNumCtrlPoints > 1) ? distance(0, 1) : 0.0;
     }
-
-    int iNumInternalKnots = iNumCtrlPoint - m_iGrad;
-    for(i=0; i<iNumInternalKnots; i++)
+    else
     {
-        double Distance1 = 0.0;
-        for(unsigned int k = 0; k < m_CtrlPointVec[i+1].size(); k++)
+        int iNumInternalKnots = m_iNumCtrlPoints - m_iOrder;
+        for(int i = 0; i < iNumInternalKnots; i++)
         {
-            Distance1 += (m_CtrlPointVec[i+1].at(k) - m_CtrlPointVec[i+2].at(k)) * (m_CtrlPointVec[i+1].at(k) - m_CtrlPointVec[i+2].at(k));
+            m_KnotVec[i + m_iOrder] = m_KnotVec[i + m_iOrder - 1] + distance(i + 1, i + 2);
         }
-        d= m_KnotVec[i+m_iGrad-1] + sqrt(Distance1);
-        // OLD WITH JOINTD d= m_KnotVec[i+m_iGrad-1] + Distance( m_CtrlPointVec[i+1], m_CtrlPointVec[i+2] );
-        m_KnotVec[i+m_iGrad] = d;
+        d = m_KnotVec[m_iNumCtrlPoints - 1] + distance(iNumInternalKnots + 1, iNumInternalKnots + 2);
     }
-    double Distance2 = 0.0;
-    for(unsigned int k = 0; k <  m_CtrlPointVec[iNumInternalKnots+1].size(); k++)
-    {
-        Distance2 += ( m_CtrlPointVec[iNumInternalKnots+1].at(k) - m_CtrlPointVec[iNumInternalKnots+2].at(k)) * ( m_CtrlPointVec[iNumInternalKnots+1].at(k) - m_CtrlPointVec[iNumInternalKnots+2].at(k));
-    }
-    d = m_KnotVec[iNumCtrlPoint-1] + sqrt(Distance2);
-    // OLD WITH JOINTD d = m_KnotVec[iNumCtrlPoint-1] + Distance( m_CtrlPointVec[iNumInternalKnots+1], m_CtrlPointVec[iNumInternalKnots+2] );
 
-    for(i = 0; i< m_iGrad; i++)
+    for(int i = 0; i < m_iOrder; i++)
     {
-        m_KnotVec[i+iNumCtrlPoint] = d;
+        m_KnotVec[i + m_iNumCtrlPoints] = d;
     }
 
     // This is not the arc-length but the maximum of the spline parameter.
-    // eval(m_dLength, Point) should return the last point of the spline
+    // eval(m_dLength, Point) returns the last point of the spline
     m_dLength = d;
-
 }
 
 
@@ -149,16 +157,11 @@ void BSplineND<PointND>::setCtrlPoints(const std::vector<PointND>& ctrlPointVec
 template <class PointND>
 void BSplineND<PointND>::eval(double dPos, PointND& point)
 {
-    double dFak;
-
-    for(unsigned int i = 0; i<point.size(); i++)
-        point.at(i) = 0.0;
-    for(unsigned int i = 0; i < m_CtrlPointVec.size(); i++)
+    if (m_iNumCtrlPoints == 0)
     {
-        dFak = evalBasis(dPos, i, m_iGrad);
-        for(unsigned int j = 0; j<point.size(); j++)
-            point.at(j) += m_CtrlPointVec[i][j] * dFak;  // !!!! TODO this might be wrong due to change from JointD to std::vector
+        return;
     }
+    evalSpan(dPos, findSpan(dPos, m_iOrder - 1), point);
 }
 
 
@@ -166,189 +169,115 @@ void BSplineND<PointND>::eval(double dPos, PointND& point)
 template <class PointND>
 bool BSplineND<PointND>::ipoWithConstSampleDist(double dIpoDist, std::vector<PointND >& ipoVec)
 {
-    PointND buf = m_CtrlPointVec.front();
-    int iNumOfPoints;
-    double dPos;
-    //int iStart, iNextStart;
+    // equidistant in the spline parameter, the distance is at most dIpoDist and the last sample is the end point
+    unsigned int iNumOfIntervals = std::max(1.0, ceil(m_dLength / dIpoDist - 1e-9));
+    return sample(iNumOfIntervals + 1, ipoVec);
+}
 
-    if (m_CtrlPointVec.size() < m_iGrad)
+//-----------------------------------------------
+template <class PointND>
+bool BSplineND<PointND>::ipoWithNumSamples(int iNumOfPoints, std::vector<PointND >& ipoVec)
+{
+    return sample(std::max(iNumOfPoints, 2), ipoVec);
+}
+
+//-----------------------------------------------
+template <class PointND>
+bool BSplineND<PointND>::sample(unsigned int iNumOfPoints, std::vector<PointND >& ipoVec)
+{
+    if (m_iNumCtrlPoints == 0)
     {
-        ipoVec = m_CtrlPointVec;
+        ipoVec.clear();
         return false;
     }
 
-    // Felix: Dies ist falsch? m_KnotVec.back() enthält nicht die tatsächliche
-    // Bogenlänge entlang des Splines. Folge: Ergebnisvektor ist am Ende abge-
-    // schnitten.
-    iNumOfPoints = m_KnotVec.back() / dIpoDist + 2;
     ipoVec.resize(iNumOfPoints);
-
-    // Calculate x- and y-coordinates
-    dPos = 0;
-    for(int i=0; i < iNumOfPoints -1 ; i++)
+    unsigned int span = m_iOrder - 1;
+    for(unsigned int i = 0; i < iNumOfPoints; i++)
     {
-        eval(dPos, buf);
-        ipoVec[i] = buf;
-        dPos += dIpoDist;
+        double dPos = m_dLength * i / (iNumOfPoints - 1);
+        span = findSpan(dPos, span);
+        ipoVec[i].resize(m_iDim);
+        evalSpan(dPos, span, ipoVec[i]);
     }
 
-    ipoVec.back() = m_CtrlPointVec.back();
-
+    // exactly the last control point
+    for(unsigned int k = 0; k < m_iDim; k++)
+    {
+        ipoVec.back()[k] = m_CtrlPoints[(m_iNumCtrlPoints - 1) * m_iDim + k];
+    }
     return true;
 }
 
-/*
-//-----------------------------------------------
-//Florian
-bool BSplineND<PointND>::ipoWithConstSampleDist(double dIpoDist, OmniPath& ipoVec)
+
+/// index l of the knot span m_KnotVec[l] <= u < m_KnotVec[l+1] with order-1 <= l < number of control points,
+/// the search starts at hint (increasing u while sampling)
+template <class PointND>
+unsigned int BSplineND<PointND>::findSpan(double u, unsigned int hint) const
 {
-    Neo::Vector2D buf;
-    int iNumOfPoints;
-    int iNumOfCtrlPoints;
-    double dPos, viewang;
-    double dx, dy, da;
-    int i;
-    bool bRet = true;
-    int iStart, iNextStart;
-
-    iNumOfCtrlPoints = m_OmniCtrlPointVec.getSize();
-
-    if ( iNumOfCtrlPoints < m_iGrad )
+    unsigned int lo = m_iOrder - 1;
+    unsigned int hi = m_iNumCtrlPoints - 1;
+    if (u >= m_KnotVec[hi + 1])
     {
-        bRet = false;
-
-        iNumOfPoints = m_OmniCtrlPointVec.getSize();
-        ipoVec.clearVec();
-        for(i=0; i<iNumOfPoints; i++)
-        {
-            ipoVec.addFrame(m_OmniCtrlPointVec.m_VecPathPnt[i].Frm,m_OmniCtrlPointVec.m_VecPathPnt[i].ViewAng);
-        }
-
-        if ( iNumOfCtrlPoints < 2 )
-        {
-            return bRet;
-        }
+        return hi;
     }
-    else
+    if (u <= m_KnotVec[lo])
     {
-        iNumOfPoints = m_KnotVec.back() / dIpoDist + 2;
-        ipoVec.m_VecPathPnt.resize(iNumOfPoints);
-
-        // Calculate x- and y-coordinates
-        dPos = 0;
-        iStart = 0;
-        for(i=0; i < iNumOfPoints -1 ; i++)
-        {
-//            eval(dPos, buf);
-            eval(dPos, buf, iStart, iNextStart, viewang);
-            iStart = iNextStart;
-
-            ipoVec.m_VecPathPnt[i].Frm.x() = buf.x();
-            ipoVec.m_VecPathPnt[i].Frm.y() = buf.y();
-            ipoVec.m_VecPathPnt[i].ViewAng=viewang;
-            dPos += dIpoDist;
-        }
-
-        ipoVec.m_VecPathPnt.back().Frm.x() = m_OmniCtrlPointVec.m_VecPathPnt.back().Frm.x();
-        ipoVec.m_VecPathPnt.back().Frm.y() = m_OmniCtrlPointVec.m_VecPathPnt.back().Frm.y();
-        ipoVec.m_VecPathPnt.back().ViewAng = m_OmniCtrlPointVec.m_VecPathPnt.back().ViewAng;
+        return lo;
     }
 
-    // Calculate angle
-    for(i=0; i < iNumOfPoints-1; i++)
+    unsigned int l = std::min(std::max(hint, lo), hi);
+    if (m_KnotVec[l] <= u)
     {
-        dx = ipoVec.m_VecPathPnt[i+1].Frm.x() - ipoVec.m_VecPathPnt[i].Frm.x();
-        dy = ipoVec.m_VecPathPnt[i+1].Frm.y() - ipoVec.m_VecPathPnt[i].Frm.y();
-        da = atan2(dy, dx);
-        MathSup::normalizePi(da);
-        ipoVec.m_VecPathPnt[i].Frm.a() = da;
+        while (l < hi && m_KnotVec[l + 1] <= u)
+        {
+            l++;
+        }
+        return l;
     }
-    ipoVec.m_VecPathPnt.back().Frm.a() = da;
-
-    return bRet;
+    std::vector<double>::const_iterator it = std::upper_bound(m_KnotVec.begin() + lo, m_KnotVec.begin() + hi + 1, u);
+    return (it - m_KnotVec.begin()) - 1;
 }
-*/
 
-//-----------------------------------------------
+/// de Boor's algorithm on the order control points of the span
 template <class PointND>
-bool BSplineND<PointND>::ipoWithNumSamples(int iNumOfPoints, std::vector<PointND >& ipoVec)
+void BSplineND<PointND>::evalSpan(double u, unsigned int span, PointND& point)
 {
-    PointND buf;
-    double dPos, dInc;
+    const int p = m_iOrder - 1;   // degree
+    const unsigned int first = span - p;
+
+    std::copy(m_CtrlPoints.begin() + first * m_iDim, m_CtrlPoints.begin() + (first + m_iOrder) * m_iDim, m_Work.begin());
 
-    if (m_CtrlPointVec.size() < m_iGrad)
+    for(int r = 1; r <= p; r++)
     {
-        ipoVec = m_CtrlPointVec;
-        return false;
+        for(int j = p; j >= r; j--)
+        {
+            double dLeft = m_KnotVec[first + j];
+            double dDen = m_KnotVec[first + j + m_iOrder - r] - dLeft;
+            double dAlpha = (fabs(dDen) > BSPLINE_TINY) ? (u - dLeft) / dDen : 0.0;
+            for(unsigned int k = 0; k < m_iDim; k++)
+            {
+                m_Work[j * m_iDim + k] = (1.0 - dAlpha) * m_Work[(j - 1) * m_iDim + k] + dAlpha * m_Work[j * m_iDim + k];
+            }
+        }
     }
 
-    dInc = m_KnotVec.back() / (double)(iNumOfPoints-1);
-    ipoVec.resize(iNumOfPoints);
-
-    // Calculate x- and y-coordinates
-    dPos = 0;
-    for(int i=0; i < iNumOfPoints -1 ; i++)
+    for(unsigned int k = 0; k < m_iDim; k++)
     {
-        eval(dPos, buf);
-
-        ipoVec[i] = buf;
-        dPos += dInc;
+        point[k] = m_Work[p * m_iDim + k];
     }
-
-    ipoVec.back() = m_CtrlPointVec.back();
-    return true;
 }
 
-
 template <class PointND>
-double BSplineND<PointND>::evalBasis(double u, unsigned int i, int n)
+double BSplineND<PointND>::distance(unsigned int i, unsigned int j) const
 {
-    assert(i >= 0);
-    assert(i < m_KnotVec.size() - 1 );
-
-    if (n==1)
+    double dSum = 0.0;
+    for(unsigned int k = 0; k < m_iDim; k++)
     {
-        if ( (m_KnotVec[i]<=u) && ( u<m_KnotVec[i+1]) )
-        {
-            return 1.0;
-        }
-        else
-        {
-            return 0.0;
-        }
-    }
-    else
-    {
-        double N;
-        double dNum1, dNum2;
-        double dDen1, dDen2;
-
-        dDen1 = u - m_KnotVec[i];
-        dNum1 = m_KnotVec[i+n-1] - m_KnotVec[i];
-
-        dDen2 = m_KnotVec[i+n] - u;
-        dNum2 = m_KnotVec[i+n] - m_KnotVec[i+1];
-
-        if ( (fabs(dNum1) > BSPLINE_TINY)&&(fabs(dNum2) > BSPLINE_TINY) )
-        {
-            N = dDen1 / dNum1 * evalBasis(u, i , n-1);
-            N += dDen2 / dNum2 * evalBasis(u, i+1 , n-1);
-        }
-        else if ( (fabs(dNum1) < BSPLINE_TINY)&&(fabs(dNum2) > BSPLINE_TINY) )
-        {
-            N = dDen2 / dNum2 * evalBasis(u, i+1 , n-1);
-        }
-        else if ((fabs(dNum1) > BSPLINE_TINY)&&(fabs(dNum2) < BSPLINE_TINY))
-        {
-            N = dDen1 / dNum1 * evalBasis(u, i , n-1);
-        }
-        else
-        {
-            N = 0;
-        }
-
-        return N;
+        double d = m_CtrlPoints[i * m_iDim + k] - m_CtrlPoints[j * m_iDim + k];
+        dSum += d * d;
     }
+    return sqrt(dSum);
 }
 
 
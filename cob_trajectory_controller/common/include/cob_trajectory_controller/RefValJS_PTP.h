@@ -23,6 +23,9 @@ class RefValJS_PTP : public RefVal_JS
 		virtual std::vector<double> dr_ds(double s) const;
 		virtual double ds_dt(double t) const;
 
+		virtual void evaluate(double t, std::vector<double>& r, RefValHint& hint) const;
+		virtual void evaluate(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint) const;
+
 		double getTotalTime() const { std::cout << m_T1 << "\n"; return m_T1 + m_T2 + m_T3; }
 
 	protected:
@@ -25,6 +25,12 @@ class RefValJS_PTP_Trajectory : public RefVal_JS
 		   	a path planner!
 		*/
 		RefValJS_PTP_Trajectory(const trajectory_msgs::JointTrajectory& trajectory, double v_rad_s, double a_rad_s2, bool smooth=false);
+		/* time optimal parameterization:
+			the path is traversed as fast as possible while every joint i respects |dq_i/dt| <= v_max[i] and
+			|d2q_i/dt2| <= a_max[i] (numerical integration of the maximum path acceleration/deceleration along
+			the path, computed once in the constructor)
+		*/
+		RefValJS_PTP_Trajectory(const trajectory_msgs::JointTrajectory& trajectory, const std::vector<double>& v_max, const std::vector<double>& a_max, bool smooth=false);
 		//RefValJS_PTP_Trajectory(const std::vector<Jointd>& trajectory, Jointd start, Jointd startvel, double v_rad_s, double a_rad_s2, bool smooth=false);
 
 		std::vector<double> r(double s) const;
@@ -33,11 +39,28 @@ class RefValJS_PTP_Trajectory : public RefVal_JS
 		std::vector<double> dr_ds(double s) const;
 		double ds_dt(double t) const;
 
-		double getTotalTime() const { return m_T1 + m_T2 + m_T3; }
+		void evaluate(double t, std::vector<double>& r, RefValHint& hint) const;
+		void evaluate(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint) const;
+		void evaluateBatch(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint,
+			unsigned int count, const double* t_at, std::vector<double>* const* r_at, RefValHint* hint_at) const;
+
+		double getTotalTime() const { return m_time_optimal ? m_topp_t.back() : m_T1 + m_T2 + m_T3; }
 
 		std::vector<double> getLengthParts() const { return m_length_parts; }
 
 	protected:
+		void r(double s, std::vector<double>& soll, unsigned int& hint) const;
+		double s(double t, unsigned int& hint) const;
+		void dr_ds(double s, std::vector<double>& result, unsigned int& hint) const;
+		double ds_dt(double t, unsigned int& hint) const;
+		double dr_ds_point(unsigned int i, unsigned int k) const;
+		static unsigned int findInterval(const std::vector<double>& v, double x, unsigned int& hint);
+
+		void buildPath(bool smooth);
+		void calculateTimeOptimal(const std::vector<double>& v_max, const std::vector<double>& a_max);
+		bool limitNextVelocity(const std::vector<double>& dq_begin, const std::vector<double>& dq_end,
+			const std::vector<double>& ddq, double ds, double sd_sqr, const std::vector<double>& a_max, double& lo, double& hi) const;
+
 		double norm(const std::vector<double>& j);
 		double norm_max(const std::vector<double>& j);
 		double norm_sqr(const std::vector<double>& j);
@@ -69,6 +92,13 @@ class RefValJS_PTP_Trajectory : public RefVal_JS
 		double m_sv2;	// "Geschw." des Wegparameters s in Phase 2
 		double m_sa3;	// "Verzög." des Wegparameters s in Phase 3
 
+		// time optimal parameterization: s, ds/dt and time at the grid points, d2s/dt2 between them
+		bool m_time_optimal;
+		vecd m_topp_s;
+		vecd m_topp_sd;
+		vecd m_topp_sdd;
+		vecd m_topp_t;
+
 		static const double weigths[];
 };
 
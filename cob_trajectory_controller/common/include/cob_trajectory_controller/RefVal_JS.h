@@ -14,6 +14,16 @@
 #include <vector>
 
 
+/* Search start for the lookups of the allocation free evaluation.
+   Keep one hint per lookup which moves slowly in time, it is updated by every call.
+*/
+struct RefValHint
+{
+	RefValHint() : time_index(0), path_index(0) {}
+	unsigned int time_index;
+	unsigned int path_index;
+};
+
 class RefVal_JS
 {
 	public:
@@ -34,6 +44,23 @@ class RefVal_JS
 
 		virtual std::vector<double> getLast() const { return r_t( getTotalTime() ); }
 
+		/* allocation free evaluation: r and dr have to be sized to the number of joints by the caller */
+		virtual void evaluate(double t, std::vector<double>& r, RefValHint& /*hint*/) const { r = r_t(t); }
+		virtual void evaluate(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& /*hint*/) const
+		{
+			r = r_t(t);
+			dr = dr_dt(t);
+		}
+
+		/* all lookups of a control cycle in one call: r and dr at t, plus the positions *r_at[i] at the times t_at[i] */
+		virtual void evaluateBatch(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint,
+			unsigned int count, const double* t_at, std::vector<double>* const* r_at, RefValHint* hint_at) const
+		{
+			evaluate(t, r, dr, hint);
+			for (unsigned int i = 0; i < count; i++)
+				evaluate(t_at[i], *r_at[i], hint_at[i]);
+		}
+
 		virtual double getTotalTime() const=0;
 };
 
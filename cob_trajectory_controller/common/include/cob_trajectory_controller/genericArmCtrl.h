@@ -24,12 +24,15 @@ class genericArmCtrl
 		std::vector<double> GetPTPacc() const;
 		void SetPTPvel(double vel);
 		void SetPTPacc(double acc);
+		void SetPTPvel(const std::vector<double>& vel);
+		void SetPTPacc(const std::vector<double>& acc);
 
 		double overlap_time;
+		bool time_optimal;	// time optimal parameterization of trajectories with the per joint limits
 
 		// void stop(); --> TODO: better reset
 
-		bool step(std::vector<double> current_pos, std::vector<double> & desired_vel);
+		bool step(const std::vector<double>& current_pos, std::vector<double> & desired_vel);
 
 		bool moveThetas(std::vector<double> conf_goal, std::vector<double> conf_current);
 		bool moveTrajectory(trajectory_msgs::JointTrajectory pfad, std::vector<double> conf_current);
@@ -46,6 +49,12 @@ class genericArmCtrl
 		std::vector<double> last_q1;
 		std::vector<double> last_q2;
 		std::vector<double> last_q3;
+		std::vector<double> m_qsoll;
+		std::vector<double> m_vsoll;
+		RefValHint m_hint;			// search hints for the reference lookups in step()
+		RefValHint m_hint_last[4];
+		std::vector<double>* m_last_q[4];	// last_q .. last_q3
+		double m_t_last[4];
 		std::vector<double> m_acc_js;
 		bool isMoving;
 
@@ -57,6 +66,9 @@ class genericArmCtrl
 		double m_CurrentError;
 		double m_TargetError;
 		double m_ExtraTime;	// Zusätzliche Zeit, um evtl. verbleibende Regelfehler auszuregeln
+
+	private:
+		void resetHints();
 };
 
 
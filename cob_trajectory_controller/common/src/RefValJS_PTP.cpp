@@ -138,4 +138,17 @@ std::vector<double> RefValJS_PTP::dr_ds(double s) const
 	return result;
 }
 
+void RefValJS_PTP::evaluate(double t, std::vector<double>& r, RefValHint& /*hint*/) const
+{
+	double s_t = s(t);
+	for(unsigned int i = 0; i < m_start.size(); i++)
+		r[i] = (s_t < 1.0) ? m_start[i] + m_direction[i] * s_t : m_ziel[i];
+}
 
+void RefValJS_PTP::evaluate(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint) const
+{
+	evaluate(t, r, hint);
+	double ds = ( s(t) < 1.0 ) ? ds_dt(t) : 0.0;
+	for(unsigned int i = 0; i < m_start.size(); i++)
+		dr[i] = m_direction[i] * ds;
+}
@@ -16,6 +16,52 @@ inline double sqr(double x)
 RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTrajectory& trajectory, double v_rad_s, double a_rad_s2, bool smooth)
 {
 	m_trajectory = trajectory;
+	m_time_optimal = false;
+	buildPath(smooth);
+
+	m_v_rad_s = v_rad_s;
+	m_a_rad_s2 = a_rad_s2;
+
+	/* Parameter für Beschl.begrenzte Fahrt: */
+	double a = fabs(m_a_rad_s2);
+	double v = fabs(m_v_rad_s);
+
+	if (m_length > v*v/a)
+	{
+		// Phase mit konst. Geschw. wird erreicht:
+		m_T1 = m_T3 = v / a;
+		m_T2 = (m_length - v*v/a) / v;
+
+		// Wegparameter s immer positiv, deswegen keine weitere Fallunterscheidung nötig:
+		m_sv2 = 1.0 / (m_T1 + m_T2);
+		m_sa1 = m_sv2 / m_T1;
+		m_sa3 = -m_sa1;
+	}
+	else {
+		// Phase konst. Geschw. wird nicht erreicht:
+		m_T2 = 0.0;
+		m_T1 = m_T3 = sqrt(m_length / a);
+
+		m_sv2 = 1.0 / m_T1;
+		m_sa1 = m_sv2 / m_T1;
+		m_sa3 = -m_sa1;
+
+	}
+	// Bewegung vollständig charakterisiert.
+
+}
+
+RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTrajectory& trajectory, const std::vector<double>& v_max, const std::vector<double>& a_max, bool smooth)
+{
+	m_trajectory = trajectory;
+	m_time_optimal = true;
+	m_T1 = m_T2 = m_T3 = 0.0;
+	buildPath(smooth);
+	calculateTimeOptimal(v_max, a_max);
+}
+
+void RefValJS_PTP_Trajectory::buildPath(bool smooth)
+{
 	m_length = 0;
 	//m_stepSize = 0.4;
 	m_stepSize = 0.0175; // 0.0175 rad = 1°
@@ -48,7 +94,6 @@ RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTra
 			}
 			double dist = sqrt(len);
 			int num_segs = ceil(dist/between_stepsize);
-			zwischenPunkte.resize(num_segs);
 			for (int j=0; j < num_segs; j++)
 			{
 				std::vector<double> betw_joint;
@@ -57,16 +102,16 @@ RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTra
 				{
 					betw_joint.at(d) = m_trajectory.points[i].positions.at(d) + direction.at(d) * ( (double)j / (double)num_segs );
 				}
-				zwischenPunkte.at(j) = betw_joint;
+				zwischenPunkte.push_back(betw_joint);
 			}
 		}
 		zwischenPunkte.push_back( m_trajectory.points.back().positions );
 	} else
 	{
-		zwischenPunkte.resize(trajectory.points.size());
-		for(unsigned int i = 0; i < trajectory.points.size(); i++)
+		zwischenPunkte.resize(m_trajectory.points.size());
+		for(unsigned int i = 0; i < m_trajectory.points.size(); i++)
 		{
-			zwischenPunkte.at(i) = trajectory.points.at(i).positions;
+			zwischenPunkte.at(i) = m_trajectory.points.at(i).positions;
 		}
 	}
 	ROS_INFO("Calculated %lu zwischenPunkte", zwischenPunkte.size());
@@ -75,13 +120,27 @@ RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTra
 
 	// Note: unlike the name of the function suggests, the distance between any two neigbouring points
 	// is not always the same!
-	if ( m_TrajectorySpline.ipoWithConstSampleDist(m_stepSize, m_SplinePoints)==false )
+	std::vector<std::vector<double> > samples;
+	if ( m_TrajectorySpline.ipoWithConstSampleDist(m_stepSize, samples)==false )
 	{
-		//uhr-messmerf: diese exception wird geworfen, wenn nicht genügend Stützpunkte vorhanden sind (kleiner m_iGrad=3)
-		//uhr-messmerf: dies tritt auf, wenn die Punkte der Trajectory pfad zu nah beieinander liegen (dist < between_stepsize=2.5)
 		throw std::runtime_error("Error in BSplineND::ipoWithConstSampleDist!");
 	}
-	m_SplinePoints = zwischenPunkte;
+
+	// the path parameter needs strictly increasing lengths, drop samples without progress
+	m_SplinePoints.clear();
+	m_SplinePoints.push_back(samples.front());
+	for (unsigned int i=1; i < samples.size(); i++)
+	{
+		std::vector<double> dist(samples[i].size());
+		for(unsigned int j=0; j < samples[i].size(); j++)
+		{
+			dist.at(j) = samples[i].at(j) - m_SplinePoints.back().at(j);
+		}
+		if ( norm(dist) > 1e-9 )
+			m_SplinePoints.push_back(samples[i]);
+		else if ( i == samples.size()-1 && m_SplinePoints.size() > 1 )
+			m_SplinePoints.back() = samples[i];
+	}
 	ROS_INFO("Calculated %lu splinepoints", m_SplinePoints.size());
 
 	m_length_cumulated.clear();
@@ -108,85 +167,297 @@ RefValJS_PTP_Trajectory::RefValJS_PTP_Trajectory(const trajectory_msgs::JointTra
 	{
 		m_s_parts.push_back( m_length_parts[i] / m_length );
 	}
+}
 
-	m_v_rad_s = v_rad_s;
-	m_a_rad_s2 = a_rad_s2;
+/* Time optimal path parameterization (TOPP):
+	The path is sampled on a grid in s with a spacing of at most m_stepSize. The joint velocities and
+	accelerations are dq/dt = q' * sd and d2q/dt2 = q' * sdd + q'' * sd^2, with ' = d/ds, sd = ds/dt and
+	sdd = d2s/dt2. q' (dr_ds) is linear and q'' constant between two grid points, sdd is constant within a
+	grid interval and sd^2 therefore linear. The joint accelerations at both ends of an interval are linear
+	in sd^2 at its begin and its end, so they bound the admissible sd^2 at the end for a given sd^2 at the begin.
+	A backward pass yields the largest sd^2 at each grid point from which the robot can still stop at the end
+	of the path (bisection), a forward pass starting at rest then picks the largest admissible sd^2 below it.
+*/
+void RefValJS_PTP_Trajectory::calculateTimeOptimal(const std::vector<double>& v_max, const std::vector<double>& a_max)
+{
+	const unsigned int dof = m_trajectory.points.front().positions.size();
+	if ( v_max.size() < dof || a_max.size() < dof )
+	{
+		throw std::runtime_error("Joint limits do not match the trajectory!");
+	}
 
-	/* Parameter für Beschl.begrenzte Fahrt: */
-	double a = fabs(m_a_rad_s2);
-	double v = fabs(m_v_rad_s);
+	// all points equal the start: nothing to move, zero duration
+	if ( m_length_parts.empty() || m_length < 1e-9 )
+	{
+		m_topp_s.assign(1, 0.0);
+		m_topp_sd.assign(1, 0.0);
+		m_topp_sdd.assign(1, 0.0);
+		m_topp_t.assign(1, 0.0);
+		ROS_INFO("Time optimal parameterization of an empty path: 0 s");
+		return;
+	}
 
-	if (m_length > v*v/a)
+	// grid
+	m_topp_s.clear();
+	m_topp_s.push_back(0.0);
+	for (unsigned int i=0; i < m_length_parts.size(); i++)
 	{
-		// Phase mit konst. Geschw. wird erreicht:
-		m_T1 = m_T3 = v / a;
-		m_T2 = (m_length - v*v/a) / v;
+		unsigned int steps = std::max(1.0, ceil(m_length_parts[i] / m_stepSize));
+		for (unsigned int k = 1; k <= steps; k++)
+		{
+			m_topp_s.push_back( (m_length_cumulated[i] + m_length_parts[i] * k / steps) / m_length );
+		}
+	}
+	m_topp_s.back() = 1.0;
+	const unsigned int n = m_topp_s.size();
 
-		// Wegparameter s immer positiv, deswegen keine weitere Fallunterscheidung nötig:
-		m_sv2 = 1.0 / (m_T1 + m_T2);
-		m_sa1 = m_sv2 / m_T1;
-		m_sa3 = -m_sa1;
+	// path derivatives: q' at the grid points, q'' within the grid intervals
+	std::vector<vecd> dq(n), ddq(n-1, vecd(dof, 0.0));
+	for (unsigned int i = 0; i < n; i++)
+	{
+		dq[i] = dr_ds( std::min(m_topp_s[i], 1.0 - 1e-9) );
+	}
+	for (unsigned int i = 0; i+1 < n; i++)
+	{
+		for (unsigned int j = 0; j < dof; j++)
+		{
+			ddq[i][j] = (dq[i+1][j] - dq[i][j]) / (m_topp_s[i+1] - m_topp_s[i]);
+		}
 	}
-	else {
-		// Phase konst. Geschw. wird nicht erreicht:
-		m_T2 = 0.0;
-		m_T1 = m_T3 = sqrt(m_length / a);
 
-		m_sv2 = 1.0 / m_T1;
-		m_sa1 = m_sv2 / m_T1;
-		m_sa3 = -m_sa1;
+	// velocity limits bound sd^2 directly
+	vecd sd_sqr_max(n);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		sd_sqr_max[i] = 1e12;
+		for (unsigned int j = 0; j < dof; j++)
+		{
+			if ( fabs(dq[i][j]) > 1e-9 )
+				sd_sqr_max[i] = std::min(sd_sqr_max[i], sqr(v_max[j] / dq[i][j]));
+		}
+	}
 
+	// backward pass: largest sd^2 which still allows to stop at the end
+	sd_sqr_max.back() = 0.0;
+	double lo, hi;
+	for (unsigned int i = n-1; i > 0; i--)
+	{
+		double ds = m_topp_s[i] - m_topp_s[i-1];
+		double upper = sd_sqr_max[i-1];
+		lo = 0.0;
+		hi = sd_sqr_max[i];
+		if ( !limitNextVelocity(dq[i-1], dq[i], ddq[i-1], ds, upper, a_max, lo, hi) )
+		{
+			double lower = 0.0;
+			for (unsigned int k = 0; k < 100; k++)
+			{
+				double mid = 0.5 * (lower + upper);
+				lo = 0.0;
+				hi = sd_sqr_max[i];
+				if ( limitNextVelocity(dq[i-1], dq[i], ddq[i-1], ds, mid, a_max, lo, hi) )
+					lower = mid;
+				else
+					upper = mid;
+			}
+			upper = lower;
+		}
+		sd_sqr_max[i-1] = upper;
+	}
+
+	// forward pass: start at rest, accelerate as much as possible
+	vecd sd_sqr(n, 0.0);
+	for (unsigned int i = 0; i+1 < n; i++)
+	{
+		lo = 0.0;
+		hi = sd_sqr_max[i+1];
+		if ( limitNextVelocity(dq[i], dq[i+1], ddq[i], m_topp_s[i+1] - m_topp_s[i], sd_sqr[i], a_max, lo, hi) )
+			sd_sqr[i+1] = hi;
+		else
+			sd_sqr[i+1] = std::min(sd_sqr[i], sd_sqr_max[i+1]);  // only due to rounding
+	}
+
+	// time stamps of the grid points, constant sdd in between
+	m_topp_sd.resize(n);
+	m_topp_sdd.assign(n, 0.0);
+	m_topp_t.resize(n);
+	m_topp_t[0] = 0.0;
+	for (unsigned int i = 0; i < n; i++)
+	{
+		m_topp_sd[i] = sqrt(sd_sqr[i]);
+	}
+	for (unsigned int i = 0; i+1 < n; i++)
+	{
+		double ds = m_topp_s[i+1] - m_topp_s[i];
+		double sd_sum = m_topp_sd[i] + m_topp_sd[i+1];
+		m_topp_t[i+1] = m_topp_t[i] + ((sd_sum > 1e-12) ? 2.0 * ds / sd_sum : 0.0);
+		if ( ds > 0.0 )
+			m_topp_sdd[i] = (sd_sqr[i+1] - sd_sqr[i]) / (2.0 * ds);
 	}
-	// Bewegung vollständig charakterisiert.
 
+	ROS_INFO("Time optimal parameterization with %u grid points: %f s", n, m_topp_t.back());
+}
+
+/// narrows [lo, hi] to the sd^2 at the end of a grid interval admissible for the sd^2 at its begin, false if none is left
+bool RefValJS_PTP_Trajectory::limitNextVelocity(const std::vector<double>& dq_begin, const std::vector<double>& dq_end,
+	const std::vector<double>& ddq, double ds, double sd_sqr, const std::vector<double>& a_max, double& lo, double& hi) const
+{
+	// joint acceleration at either end: c_begin * sd_sqr + c_end * sd_sqr_end, with sdd = (sd_sqr_end - sd_sqr) / (2*ds)
+	for (unsigned int j = 0; j < ddq.size(); j++)
+	{
+		for (unsigned int end = 0; end < 2; end++)
+		{
+			double c_begin, c_end;
+			if (end == 0)
+			{
+				c_begin = ddq[j] - dq_begin[j] / (2.0 * ds);
+				c_end = dq_begin[j] / (2.0 * ds);
+			}
+			else
+			{
+				c_begin = -dq_end[j] / (2.0 * ds);
+				c_end = dq_end[j] / (2.0 * ds) + ddq[j];
+			}
+
+			double a_begin = c_begin * sd_sqr;
+			if ( fabs(c_end) > 1e-12 )
+			{
+				double bound_lo = (-a_max[j] - a_begin) / c_end;
+				double bound_hi = (a_max[j] - a_begin) / c_end;
+				if (bound_lo > bound_hi)
+					std::swap(bound_lo, bound_hi);
+				lo = std::max(lo, bound_lo);
+				hi = std::min(hi, bound_hi);
+			}
+			else if ( fabs(a_begin) > a_max[j] )
+			{
+				return false;
+			}
+		}
+	}
+	return lo <= hi;
 }
 
 std::vector<double> RefValJS_PTP_Trajectory::r(double s) const
 {
-	//printw("Line %d\ts: %f\n", __LINE__, s);
-	std::vector<double> soll;
+	std::vector<double> soll(m_trajectory.points.front().positions.size());
+	unsigned int hint = 0;
+	r(s, soll, hint);
+	return soll;
+}
+
+double RefValJS_PTP_Trajectory::s(double t) const
+{
+	unsigned int hint = 0;
+	return s(t, hint);
+}
+
+double RefValJS_PTP_Trajectory::ds_dt(double t) const
+{
+	unsigned int hint = 0;
+	return ds_dt(t, hint);
+}
+
+std::vector<double> RefValJS_PTP_Trajectory::dr_ds(double s) const
+{
+	std::vector<double> result(m_trajectory.points.front().positions.size());
+	unsigned int hint = 0;
+	dr_ds(s, result, hint);
+	return result;
+}
+
+void RefValJS_PTP_Trajectory::evaluate(double t, std::vector<double>& r, RefValHint& hint) const
+{
+	this->r(s(t, hint.time_index), r, hint.path_index);
+}
+
+void RefValJS_PTP_Trajectory::evaluate(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint) const
+{
+	double s_t = s(t, hint.time_index);
+	double ds = ds_dt(t, hint.time_index);
+	this->r(s_t, r, hint.path_index);
+	dr_ds(s_t, dr, hint.path_index);
+	for(unsigned int k = 0; k < dr.size(); k++)
+		dr[k] *= ds;
+}
+
+void RefValJS_PTP_Trajectory::evaluateBatch(double t, std::vector<double>& r, std::vector<double>& dr, RefValHint& hint,
+	unsigned int count, const double* t_at, std::vector<double>* const* r_at, RefValHint* hint_at) const
+{
+	RefValJS_PTP_Trajectory::evaluate(t, r, dr, hint);
+	for (unsigned int i = 0; i < count; i++)
+		this->r(s(t_at[i], hint_at[i].time_index), *r_at[i], hint_at[i].path_index);
+}
+
+/// index i of the interval v[i] <= x < v[i+1], clamped to the intervals of v, starting the search at hint
+unsigned int RefValJS_PTP_Trajectory::findInterval(const std::vector<double>& v, double x, unsigned int& hint)
+{
+	if (v.size() < 2)
+	{
+		hint = 0;
+		return 0;
+	}
+
+	unsigned int last = v.size() - 2;
+	unsigned int i = std::min(hint, last);
+
+	// the next lookup is usually in the same or one of the following intervals
+	for (unsigned int step = 0; step < 4; step++)
+	{
+		if (x < v[i] && i > 0)
+			i--;
+		else if (i < last && x >= v[i+1])
+			i++;
+		else
+		{
+			hint = i;
+			return i;
+		}
+	}
+
+	vecd_it it = upper_bound(v.begin(), v.end(), x);
+	i = std::min((unsigned int)std::max(int(it - v.begin()) - 1, 0), last);
+	hint = i;
+	return i;
+}
+
+void RefValJS_PTP_Trajectory::r(double s, std::vector<double>& soll, unsigned int& hint) const
+{
 	if (s <= 0)
 	{
 		soll = m_trajectory.points.front().positions;
 	} else
-	if (s < 1)
+	if (s < 1 && !m_length_parts.empty())
 	{
 		// since the Distances between the points of m_SplinePoints are not equal,
 		// we first need to find the last i where m_length_cumulated[i] is smaller than s*m_length
-
-		// return the first index i, where m_length_cumulated[i] is not smaller s * m_length
-		// more information under: http://www.cplusplus.com/reference/algorithm/lower_bound/
-		//typedef std::vector<double> dvec;
-
-
-		vecd_it start = m_length_cumulated.begin();
-		vecd_it end = m_length_cumulated.end();
-		vecd_it it = upper_bound(start, end, s * m_length);
-
-		int i = int(it-start) - 1;
+		unsigned int i = findInterval(m_length_cumulated, s * m_length, hint);
 		double frac = (s * m_length - m_length_cumulated[i]) / m_length_parts[i];
 
-
-		/*
-		int i = floor( s * m_param_length / m_stepSize);
-		double frac = s * m_param_length / m_stepSize - (double) i;
-		*/
 		// interpolate
-		soll.resize(m_SplinePoints[i].size());
 		for(unsigned int j = 0; j < m_SplinePoints[i].size(); j++)
 		{
-			soll.at(j) = m_SplinePoints[i].at(j) + (m_SplinePoints[i+1].at(j)-m_SplinePoints[i].at(j))*frac;
+			soll[j] = m_SplinePoints[i][j] + (m_SplinePoints[i+1][j]-m_SplinePoints[i][j])*frac;
 		}
 	}
 	else
 	{
 		soll = m_trajectory.points.back().positions;
 	}
-	return soll;
 }
 
-double RefValJS_PTP_Trajectory::s(double t) const
+double RefValJS_PTP_Trajectory::s(double t, unsigned int& hint) const
 {
+	if (m_time_optimal)
+	{
+		if (t >= m_topp_t.back())
+			return 1.0;
+		else if (t <= 0.0)
+			return 0.0;
+		unsigned int i = findInterval(m_topp_t, t, hint);
+		double dt = t - m_topp_t[i];
+		return std::min(m_topp_s[i] + m_topp_sd[i]*dt + 0.5*m_topp_sdd[i]*dt*dt, m_topp_s[i+1]);
+	}
+
 	if (t >= m_T1 + m_T2 + m_T3)
 		return 1.0;
 	else if (t >= m_T1 + m_T2)
@@ -204,8 +475,16 @@ double RefValJS_PTP_Trajectory::s(double t) const
 	else return 0.0;
 }
 
-double RefValJS_PTP_Trajectory::ds_dt(double t) const
+double RefValJS_PTP_Trajectory::ds_dt(double t, unsigned int& hint) const
 {
+	if (m_time_optimal)
+	{
+		if (t >= m_topp_t.back() || t <= 0.0)
+			return 0.0;
+		unsigned int i = findInterval(m_topp_t, t, hint);
+		return std::max(m_topp_sd[i] + m_topp_sdd[i]*(t - m_topp_t[i]), 0.0);
+	}
+
 	if (t >= m_T1 + m_T2 + m_T3)
 		return 0.0;
 	else if (t >= m_T1 + m_T2)
@@ -223,84 +502,33 @@ double RefValJS_PTP_Trajectory::ds_dt(double t) const
 	else return 0.0;
 }
 
+/// dr/ds at spline point i: central difference, one-sided at the first and the last point
+inline double RefValJS_PTP_Trajectory::dr_ds_point(unsigned int i, unsigned int k) const
+{
+	unsigned int lo = (i > 0) ? i-1 : i;
+	unsigned int hi = (i+1 < m_SplinePoints.size()) ? i+1 : i;
+	double step_s = (m_length_cumulated[hi] - m_length_cumulated[lo]) / m_length;
+	return (m_SplinePoints[hi][k] - m_SplinePoints[lo][k]) / step_s;
+}
 
-std::vector<double> RefValJS_PTP_Trajectory::dr_ds(double s) const
+void RefValJS_PTP_Trajectory::dr_ds(double s, std::vector<double>& result, unsigned int& hint) const
 {
-	//printw("Line %d\ts: %f\n", __LINE__, s);
-	std::vector<double> result = m_trajectory.points.front().positions;
-	if (s < 0.0 || s >= 1.0)
+	if (s < 0.0 || s >= 1.0 || m_length_parts.empty())
 	{
-		for(unsigned int j=0; j < result.size(); j++)
-			result.at(j) = 0.0;
+		for(unsigned int k = 0; k < result.size(); k++)
+			result[k] = 0.0;
 	}
 	else
 	{
-
-		vecd_it start = m_length_cumulated.begin();
-		vecd_it end = m_length_cumulated.end();
-		vecd_it it = upper_bound(start, end, s * m_length);
-
-		int i = int(it-start) - 1;
+		unsigned int i = findInterval(m_length_cumulated, s * m_length, hint);
 		double frac = (s * m_length - m_length_cumulated[i]) / m_length_parts[i];
 
-
-		/*
-		int i = floor( s * m_param_length / m_stepSize);
-		double frac = s * m_param_length / m_stepSize - (double) i;
-		*/
-
-		std::vector<double> vi;	// vi
-		std::vector<double> vii;// vi+1
-
-		double step_s = m_stepSize / m_param_length;
-
-		if ( i == 0 )
+		// linear interpolieren zwischen den Ableitungen an den Stützstellen i und i+1:
+		for(unsigned int k = 0; k < result.size(); k++)
 		{
-			// vi rechtsseitig approximieren
-			step_s = m_length_parts[0] / m_length;
-			vi.resize(m_SplinePoints[i].size());
-			for(unsigned int k = 0; k < m_SplinePoints[i].size(); k++)
-			{
-				vi.at(k) = (m_SplinePoints[1].at(k) - m_SplinePoints[0].at(k)) / step_s;
-			}
-			vii = vi;
-			// vi+1 zentrisch approximieren
-			//step_s = (m_length_parts[i]+m_length_parts[i+1]) / m_length;
-			//vii = (m_SplinePoints[i+2] - m_SplinePoints[i]) / (2.0 * step_s);
-		} else
-		if ( i == (int) m_SplinePoints.size() - 2 )
-		{
-			// vi zentrisch:
-			//step_s = (m_length_parts[i]+m_length_parts[i-1]) / m_length;
-			//vi = (m_SplinePoints[i+1] - m_SplinePoints[i-1]) / (2.0 * step_s);
-			// vi+1 linksseitig:
-			step_s = (m_length_parts[i]) / m_length;
-			vii.resize(m_SplinePoints[i].size());
-			for(unsigned int k = 0; k < m_SplinePoints[i].size(); k++)
-				vii.at(k) = (m_SplinePoints[i+1].at(k) - m_SplinePoints[i].at(k)) / step_s;
-			vi = vii;
-		} else
-		{
-			// beide zentrisch:
-			step_s = (m_length_parts[i]+m_length_parts[i-1]) / m_length;
-			vi.resize(m_SplinePoints[i].size());
-			for(unsigned int k = 0; k < m_SplinePoints[i].size(); k++)
-				vi.at(k) = (m_SplinePoints[i+1].at(k) - m_SplinePoints[i-1].at(k)) / step_s;
-			step_s = (m_length_parts[i]+m_length_parts[i+1]) / m_length;
-			vii.resize(m_SplinePoints[i].size());
-			for(unsigned int k = 0; k < m_SplinePoints[i].size(); k++)
-				vii.at(k) = (m_SplinePoints[i+2].at(k) - m_SplinePoints[i].at(k)) / step_s;
+			double vi = dr_ds_point(i, k);
+			double vii = dr_ds_point(i+1, k);
+			result[k] = vi + (vii-vi)*frac;
 		}
-
-		// linear interpolieren:
-		result.resize(m_SplinePoints[i].size());
-		for(unsigned int k = 0; k < m_SplinePoints[i].size(); k++)
-			result.at(k) = vi.at(k) + (vii.at(k)-vi.at(k))*frac;
 	}
-
-	return result;
 }
-
-
-
-
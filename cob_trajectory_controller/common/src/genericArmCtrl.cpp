@@ -58,8 +58,21 @@ genericArmCtrl::genericArmCtrl(int DOF, double PTPvel, double PTPacc, double max
 	m_CurrentError = 0.0; // rad
 	m_TargetError = 0.02; // rad;
 	overlap_time = 0.4;
+	time_optimal = false;
 	m_ExtraTime = 3;	// s
 
+	// buffers for the reference values, step() does not allocate
+	m_qsoll.resize(m_DOF);
+	m_vsoll.resize(m_DOF);
+	last_q.resize(m_DOF);
+	last_q1.resize(m_DOF);
+	last_q2.resize(m_DOF);
+	last_q3.resize(m_DOF);
+	m_last_q[0] = &last_q;
+	m_last_q[1] = &last_q1;
+	m_last_q[2] = &last_q2;
+	m_last_q[3] = &last_q3;
+
 }
 
 
@@ -100,6 +113,26 @@ void genericArmCtrl::SetPTPacc(double acc)
 		m_acc_js.at(i) = acc;
 }
 
+void genericArmCtrl::SetPTPvel(const std::vector<double>& vel)
+{
+	if ((int)vel.size() != m_DOF)
+	{
+		ROS_WARN("Size of joint velocity limits (%lu) does not match DOF (%d), ignoring", vel.size(), m_DOF);
+		return;
+	}
+	m_vel_js = vel;
+}
+
+void genericArmCtrl::SetPTPacc(const std::vector<double>& acc)
+{
+	if ((int)acc.size() != m_DOF)
+	{
+		ROS_WARN("Size of joint acceleration limits (%lu) does not match DOF (%d), ignoring", acc.size(), m_DOF);
+		return;
+	}
+	m_acc_js = acc;
+}
+
 /********************************************************************
  *                   PTP (Joint Space) Motion:                      *
  ********************************************************************/
@@ -126,6 +159,7 @@ bool genericArmCtrl::moveThetas(std::vector<double> conf_goal, std::vector<doubl
 
 					;
 	m_pRefVals = new RefValJS_PTP(conf_current, conf_goal, vel, acc);
+	resetHints();
 	startTime_.SetNow();
 	isMoving = true;
 	TotalTime_ = m_pRefVals->getTotalTime();
@@ -154,21 +188,29 @@ bool genericArmCtrl::moveTrajectory(trajectory_msgs::JointTrajectory pfad, std::
 	STD_CHECK_PROCEDURE()
 
 	/* Sollwerte generieren: */
-	double vel = m_vel_js.at(0);
-	for	(unsigned int i = 0; i<m_vel_js.size(); i++)
+	if (time_optimal)
 	{
-		if(m_vel_js.at(i) < vel)
-			vel = m_vel_js.at(i);
+		m_pRefVals = new RefValJS_PTP_Trajectory(pfad, m_vel_js, m_acc_js);
 	}
-	double acc = m_acc_js.at(0);
-	for	(unsigned int i = 0; i<m_acc_js.size(); i++)
+	else
 	{
-		if(m_acc_js.at(i) < acc)
-			acc = m_acc_js.at(i);
+		double vel = m_vel_js.at(0);
+		for	(unsigned int i = 0; i<m_vel_js.size(); i++)
+		{
+			if(m_vel_js.at(i) < vel)
+				vel = m_vel_js.at(i);
+		}
+		double acc = m_acc_js.at(0);
+		for	(unsigned int i = 0; i<m_acc_js.size(); i++)
+		{
+			if(m_acc_js.at(i) < acc)
+				acc = m_acc_js.at(i);
+		}
+		m_pRefVals = new RefValJS_PTP_Trajectory(pfad, vel, acc);
 	}
-	m_pRefVals = new RefValJS_PTP_Trajectory(pfad, vel, acc, true);
 
 	/* Regeljob starten: */
+	resetHints();
 	startTime_.SetNow();
 	isMoving = true;
 	TotalTime_ = m_pRefVals->getTotalTime();
@@ -201,7 +243,14 @@ bool genericArmCtrl::moveTrajectory(trajectory_msgs::JointTrajectory pfad, std::
 //	START_CTRL_JOB(Cartesian)
 //}
 
-bool genericArmCtrl::step(std::vector<double> current_pos, std::vector<double> & desired_vel)
+void genericArmCtrl::resetHints()
+{
+	m_hint = RefValHint();
+	for (int i = 0; i < 4; i++)
+		m_hint_last[i] = RefValHint();
+}
+
+bool genericArmCtrl::step(const std::vector<double>& current_pos, std::vector<double> & desired_vel)
 {
 	if(isMoving)
 	{
@@ -211,26 +260,15 @@ bool genericArmCtrl::step(std::vector<double> current_pos, std::vector<double> &
 		if ( m_pRefVals == NULL )
 				return false;
 		double t = timeNow_ - startTime_;
-		std::vector<double> m_qsoll = m_pRefVals->r_t( t );
-		std::vector<double> m_vsoll = m_pRefVals->dr_dt(t);
-
+		// reference and feed-forward velocity at t, while moving also the points one overlap_time back
+		unsigned int count = 0;
 		if(t < TotalTime_)
 		{
-			if(t < overlap_time)
-			{
-				last_q = m_pRefVals->r_t( 0.0 );
-				last_q1 = m_pRefVals->r_t( 0.0 );
-				last_q2 = m_pRefVals->r_t( 0.0 );
-				last_q3 = m_pRefVals->r_t( 0.0 );
-			}
-			else
-			{
-				last_q = m_pRefVals->r_t( t - overlap_time );
-				last_q1 = m_pRefVals->r_t( t - (3.0*overlap_time/4.0) );
-				last_q2 = m_pRefVals->r_t( t - (overlap_time/2.0) );
-				last_q3 = m_pRefVals->r_t( t - (overlap_time/4.0) );
-			}
+			count = 4;
+			for (int i = 0; i < 4; i++)
+				m_t_last[i] = (t < overlap_time) ? 0.0 : t - (4 - i) * overlap_time / 4.0;
 		}
+		m_pRefVals->evaluateBatch(t, m_qsoll, m_vsoll, m_hint, count, m_t_last, m_last_q, m_hint_last);
 
 		double len = 0;
 		for(int i = 0; i < m_DOF; i++)
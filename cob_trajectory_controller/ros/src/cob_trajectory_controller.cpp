@@ -107,6 +107,7 @@ private:
     trajectory_msgs::JointTrajectory traj_;
     trajectory_msgs::JointTrajectory traj_2_;
     std::vector<double> q_current, startposition_, joint_distance_;
+    std::vector<double> des_vel_;
 
 public:
 
@@ -170,10 +171,34 @@ public:
         {
             n_private_.getParam("operation_mode", current_operation_mode_);
         }
+        bool time_optimal = false;
+        if (n_private_.hasParam("time_optimal"))
+        {
+            n_private_.getParam("time_optimal", time_optimal);
+        }
+        std::vector<double> max_joint_vel, max_joint_acc;
+        if (n_private_.hasParam("max_joint_vel"))
+        {
+            n_private_.getParam("max_joint_vel", max_joint_vel);
+        }
+        if (n_private_.hasParam("max_joint_acc"))
+        {
+            n_private_.getParam("max_joint_acc", max_joint_acc);
+        }
         q_current.resize(DOF);
+        des_vel_.resize(DOF);
         ROS_INFO("starting controller with DOF: %d PTPvel: %f PTPAcc: %f maxError %f", DOF, PTPvel, PTPacc, maxError);
         traj_generator_ = new genericArmCtrl(DOF, PTPvel, PTPacc, maxError);
         traj_generator_->overlap_time = overlap_time;
+        traj_generator_->time_optimal = time_optimal;
+        if (!max_joint_vel.empty())
+        {
+            traj_generator_->SetPTPvel(max_joint_vel);
+        }
+        if (!max_joint_acc.empty())
+        {
+            traj_generator_->SetPTPacc(max_joint_acc);
+        }
 
         as_.start();
     }
@@ -408,8 +433,7 @@ public:
                 ROS_INFO("Preempted trajectory action");
                 return;
             }
-            std::vector<double> des_vel;
-            if(traj_generator_->step(q_current, des_vel))
+            if(traj_generator_->step(q_current, des_vel_))
             {
                 if(!traj_generator_->isMoving) //Finished trajectory
                 {
@@ -419,7 +443,7 @@ public:
                 std_msgs::Float64MultiArray target_joint_vel;
                 for(int i=0; i<DOF; i++)
                 {
-                    target_joint_vel.data.push_back(des_vel.at(i));
+                    target_joint_vel.data.push_back(des_vel_.at(i));
                 }
 
                 //send everything
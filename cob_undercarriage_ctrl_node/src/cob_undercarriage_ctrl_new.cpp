@@ -67,7 +67,8 @@
 #include <diagnostic_updater/diagnostic_updater.h>
 #include <geometry_msgs/Twist.h>
 #include <nav_msgs/Odometry.h>
-#include <tf/transform_broadcaster.h>
+#include <tf/tfMessage.h>
+#include <realtime_tools/realtime_publisher.h>
 #include <cob_msgs/EmergencyStopState.h>
 #include <control_msgs/JointTrajectoryControllerState.h>
 
@@ -76,6 +77,7 @@
 #include <cob_omni_drive_controller/OdometryTracker.h>
 #include <vector>
 #include <angles/angles.h>
+#include <boost/scoped_ptr.hpp>
 
 //####################
 //#### node class ####
@@ -86,11 +88,11 @@ class NodeClass
     // create a handle for this node, initialize node
     ros::NodeHandle n; // parameter are uploaded to private space
 
-    // topics to publish
-    ros::Publisher topic_pub_joint_state_cmd_;          // cmd issued for single joints of undercarriage
-    ros::Publisher topic_pub_controller_joint_command_;
-    ros::Publisher topic_pub_odometry_;                 // calculated (measured) velocity, rotation and pose (odometry-based) for the robot
-    tf::TransformBroadcaster tf_broadcast_odometry_;    // according transformation for the tf broadcaster
+    // topics to publish, messages are preallocated for the configured wheels
+    typedef realtime_tools::RealtimePublisher<control_msgs::JointTrajectoryControllerState> JointCommandPublisher;
+    boost::scoped_ptr<JointCommandPublisher> topic_pub_controller_joint_command_;   // cmd issued for single joints of undercarriage
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<nav_msgs::Odometry> > topic_pub_odometry_; // calculated (measured) velocity, rotation and pose (odometry-based) for the robot
+    boost::scoped_ptr<realtime_tools::RealtimePublisher<tf::tfMessage> > tf_pub_odometry_;        // according transformation for tf
 
     // topics to subscribe, callback is called for new messages arriving
     ros::Subscriber topic_sub_CMD_pltf_twist_;          // issued command to be achieved by the platform
@@ -125,13 +127,24 @@ class NodeClass
     int m_iNumWheels;
     bool m_bEMStopActive;
 
+    // joint layout: drive and steer joint of every wheel, in order of the wheel configuration
+    std::vector<std::string> joint_names_;
+    // wheel index and kind of the joints of the last state message, -1 for unknown joints
+    std::vector<std::string> state_joint_names_;
+    std::vector<int> state_joint_wheel_;
+    std::vector<bool> state_joint_is_steer_;
+
+    // buffers reused in every cycle
+    std::vector<WheelState> wheel_states_;
+    std::vector<WheelCommand> wheel_commands_;
+
     bool has_target;
 
     diagnostic_msgs::DiagnosticStatus diagnostic_status_lookup_; // used to access defines for warning levels
 
     // Constructor
     NodeClass()
-    : ucar_ctrl_(0)
+    : ucar_ctrl_(0), m_iNumJoints(0), m_iNumWheels(0)
     {
       // initialization of variables
       is_initialized_bool_ = false;
@@ -205,14 +218,31 @@ class NodeClass
 
          ucar_ctrl_ = new UndercarriageCtrl(wps);
          is_ucarr_geom_initialized_bool_ = true;
+
+         for(size_t i = 0; i < wps.size(); ++i){
+             joint_names_.push_back(wps[i].geom.drive_name);
+             joint_names_.push_back(wps[i].geom.steer_name);
+         }
+         wheel_states_.resize(m_iNumWheels);
+         wheel_commands_.resize(m_iNumWheels);
      }
 
       // implementation of topics
       // published topics
-      //topic_pub_joint_state_cmd_ = n.advertise<sensor_msgs::JointState>("joint_command", 1);
-      topic_pub_controller_joint_command_ = n.advertise<control_msgs::JointTrajectoryControllerState> ("joint_command", 1);
+      topic_pub_controller_joint_command_.reset(new JointCommandPublisher(n, "joint_command", 1));
+      topic_pub_controller_joint_command_->msg_.joint_names = joint_names_;
+      topic_pub_controller_joint_command_->msg_.desired.positions.resize(m_iNumJoints);
+      topic_pub_controller_joint_command_->msg_.desired.velocities.resize(m_iNumJoints);
+
+      topic_pub_odometry_.reset(new realtime_tools::RealtimePublisher<nav_msgs::Odometry>(n, "odometry", 1));
 
-      topic_pub_odometry_ = n.advertise<nav_msgs::Odometry>("odometry", 1);
+      if (broadcast_tf_)
+      {
+        tf_pub_odometry_.reset(new realtime_tools::RealtimePublisher<tf::tfMessage>(n, "/tf", 100));
+        tf_pub_odometry_->msg_.transforms.resize(1);
+        tf_pub_odometry_->msg_.transforms[0].header.frame_id = "/odom_combined";
+        tf_pub_odometry_->msg_.transforms[0].child_frame_id = "/base_footprint";
+      }
 
       // subscribed topics
       topic_sub_CMD_pltf_twist_ = n.subscribe("command", 1, &NodeClass::topicCallbackTwistCmd, this);
@@ -341,37 +371,6 @@ class NodeClass
     // Listens for status of underlying hardware (base drive chain)
     void topicCallbackDiagnostic(const diagnostic_msgs::DiagnosticStatus::ConstPtr& msg)
     {
-      control_msgs::JointTrajectoryControllerState joint_state_cmd;
-
-      // prepare joint_cmds for heartbeat (compose header)
-      joint_state_cmd.header.stamp = ros::Time::now();
-      //joint_state_cmd.header.frame_id = frame_id; //Where to get this id from?
-      // ToDo: configure over Config-File (number of motors) and Msg
-      // assign right size to JointState data containers
-      //joint_state_cmd.set_name_size(m_iNumMotors);
-      joint_state_cmd.desired.positions.resize(m_iNumJoints);
-      joint_state_cmd.desired.velocities.resize(m_iNumJoints);            
-      //joint_state_cmd.desired.effort.resize(m_iNumJoints);
-
-      // TODO: Generic adapation reqiuerd for joint_names when base_drive_chain will be updated
-      joint_state_cmd.joint_names.push_back("fl_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("fl_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("bl_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("bl_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("br_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("br_caster_rotation_joint");
-      joint_state_cmd.joint_names.push_back("fr_caster_r_wheel_joint");
-      joint_state_cmd.joint_names.push_back("fr_caster_rotation_joint");
-      joint_state_cmd.joint_names.resize(m_iNumJoints);
-
-      // compose jointcmds
-      for(int i=0; i<m_iNumJoints; i++)
-      {
-        joint_state_cmd.desired.positions[i] = 0.0;
-        joint_state_cmd.desired.velocities[i] = 0.0;
-        //joint_state_cmd.desired.effort[i] = 0.0;
-      }
-
       // set status of underlying drive chain to member variable 
       drive_chain_diagnostic_ = msg->level;
 
@@ -401,64 +400,55 @@ class NodeClass
         if(drive_chain_diagnostic_ != diagnostic_status_lookup_.WARN)
         {
           // publish zero-vel. jointcmds to avoid Watchdogs stopping ctrlr
-          topic_pub_controller_joint_command_.publish(joint_state_cmd);
+          publishJointCommands(false);
         }
       }
     }
 
     void topicCallbackJointControllerStates(const control_msgs::JointTrajectoryControllerState::ConstPtr& msg) {
-      int num_joints = msg->joint_names.size();
+      if (!is_initialized_bool_) return;
+
+      // associate inputs to according steer and drive joints, the mapping is only rebuilt if the joint names change
+      if (msg->joint_names != state_joint_names_)
+      {
+        state_joint_names_ = msg->joint_names;
+        state_joint_wheel_.assign(state_joint_names_.size(), -1);
+        state_joint_is_steer_.assign(state_joint_names_.size(), false);
+        for(size_t i = 0; i < state_joint_names_.size(); i++)
+        {
+          for(size_t j = 0; j < joint_names_.size(); j++)
+          {
+            if(state_joint_names_[i] == joint_names_[j])
+            {
+              state_joint_wheel_[i] = j / 2;
+              state_joint_is_steer_[i] = (j % 2) == 1;
+            }
+          }
+        }
+      }
 
       // replaces the vectors per parameter with a vector of wheelStates which combines the wheel specfic params
-      std::vector<WheelState> wStates;
-      wStates.assign(m_iNumWheels, WheelState());
+      wheel_states_.assign(m_iNumWheels, WheelState());
 
       joint_state_odom_stamp_ = msg->header.stamp;
 
-      for(int i = 0; i < num_joints; i++)
+      for(size_t i = 0; i < state_joint_wheel_.size(); i++)
       {
-        // associate inputs to according steer and drive joints
-        // ToDo: specify this globally (Prms-File or config-File or via msg-def.)
-        if(msg->joint_names[i] ==  "fl_caster_r_wheel_joint")
+        const int w = state_joint_wheel_[i];
+        if(w < 0) continue;
+        if(state_joint_is_steer_[i])
         {
-             wStates[0].dVelGearDriveRadS = msg->actual.velocities[i];
+          wheel_states_[w].dAngGearSteerRad = msg->actual.positions[i];
+          wheel_states_[w].dVelGearSteerRadS = msg->actual.velocities[i];
         }
-        if(msg->joint_names[i] ==  "bl_caster_r_wheel_joint")
-        {
-            wStates[1].dVelGearDriveRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "br_caster_r_wheel_joint")
-        {
-            wStates[2].dVelGearDriveRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "fr_caster_r_wheel_joint")
-        {
-            wStates[3].dVelGearDriveRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "fl_caster_rotation_joint")
-        {
-            wStates[0].dAngGearSteerRad = msg->actual.positions[i];
-            wStates[0].dVelGearSteerRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "bl_caster_rotation_joint")
-        {
-            wStates[1].dAngGearSteerRad = msg->actual.positions[i];
-            wStates[1].dVelGearSteerRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "br_caster_rotation_joint")
-        {
-            wStates[2].dAngGearSteerRad = msg->actual.positions[i];
-            wStates[2].dVelGearSteerRadS = msg->actual.velocities[i];
-        }
-        if(msg->joint_names[i] ==  "fr_caster_rotation_joint")
+        else
         {
-            wStates[3].dAngGearSteerRad = msg->actual.positions[i];
-            wStates[3].dVelGearSteerRadS = msg->actual.velocities[i];
+          wheel_states_[w].dVelGearDriveRadS = msg->actual.velocities[i];
         }
       }
 
       // Set measured Wheel Velocities and Angles to Controler Class (implements inverse kinematic)
-      ucar_ctrl_->updateWheelStates(wStates);
+      ucar_ctrl_->updateWheelStates(wheel_states_);
 
       // calculate odometry every time
       UpdateOdometry();
@@ -473,6 +463,8 @@ class NodeClass
     bool InitCtrl();
     // perform one control step, calculate inverse kinematics and publish updated joint cmd's (if no EMStop occurred)
     void CalcCtrlStep();
+    // publish joint commands for all wheels (zero if active is false)
+    void publishJointCommands(bool active);
     // acquires the current undercarriage configuration from base_drive_chain
     // calculates odometry from current measurement values and publishes it via an odometry topic and the tf broadcaster
     void UpdateOdometry();
@@ -519,14 +511,6 @@ int main(int argc, char** argv)
 // perform one control step, calculate inverse kinematics and publish updated joint cmd's (if no EMStop occurred)
 void NodeClass::CalcCtrlStep()
 {
-  // WheelStates will be initialized with zero-values
-  std::vector<WheelCommand> wStates;
-  wStates.assign(m_iNumWheels, WheelCommand());
-
-  // create control_msg
-  control_msgs::JointTrajectoryControllerState joint_state_cmd;
-
-  int j = 0, k = 0;
   iwatchdog_ += 1;
 
   // if controller is initialized and underlying hardware is operating normal
@@ -539,71 +523,49 @@ void NodeClass::CalcCtrlStep()
     // perform one control step,
     // get the resulting cmd's for the wheel velocities and -angles from the controller class
     // and output the achievable pltf velocity-cmds (if velocity limits where exceeded)
-    ucar_ctrl_->calcControlStep(wStates, sample_time_, false);
+    ucar_ctrl_->calcControlStep(wheel_commands_, sample_time_, false);
 
     // if drives not operating nominal -> force commands to zero
     if(drive_chain_diagnostic_ != diagnostic_status_lookup_.OK){
-        for(int i = 0; i < wStates.size(); i++){
-            wStates[i].dAngGearSteerRad = 0.0;
-            wStates[i].dVelGearSteerRadS = 0.0;
+        for(int i = 0; i < wheel_commands_.size(); i++){
+            wheel_commands_[i].dAngGearSteerRad = 0.0;
+            wheel_commands_[i].dVelGearSteerRadS = 0.0;
         }
     }
 
-    // compose jointcmds of control_msg
-
-    // compose header of control_msg
-    joint_state_cmd.header.stamp = ros::Time::now();
-
-    //Where to get this id from?
-    //joint_state_cmd.header.frame_id = frame_id;
-
-    // ToDo: configure over Config-File (number of motors) and Msg
-    // assign right size to JointState data containers
-    //joint_state_cmd.set_name_size(m_iNumJoints);
-
-    joint_state_cmd.desired.positions.resize(m_iNumJoints);
-    joint_state_cmd.desired.velocities.resize(m_iNumJoints);            
-    //joint_state_cmd.effort.resize(m_iNumJoints);
-    joint_state_cmd.joint_names.push_back("fl_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("fl_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("bl_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("bl_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("br_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("br_caster_rotation_joint");
-    joint_state_cmd.joint_names.push_back("fr_caster_r_wheel_joint");
-    joint_state_cmd.joint_names.push_back("fr_caster_rotation_joint");
-    joint_state_cmd.joint_names.resize(m_iNumJoints);
-
-    // compose data body of control_msg
-    for(int i = 0; i<m_iNumJoints; i++)
+    publishJointCommands(iwatchdog_ < (int) std::floor(timeout_/sample_time_) && has_target);
+  }
+
+}
+
+void NodeClass::publishJointCommands(bool active)
+{
+  if(!topic_pub_controller_joint_command_->trylock()) return;
+
+  control_msgs::JointTrajectoryControllerState &joint_state_cmd = topic_pub_controller_joint_command_->msg_;
+
+  // compose header of control_msg
+  joint_state_cmd.header.stamp = ros::Time::now();
+
+  // compose data body of control_msg, joints are ordered drive/steer per wheel
+  for(int i = 0; i < m_iNumWheels; i++)
+  {
+    if(active)
     {
-      if(iwatchdog_ < (int) std::floor(timeout_/sample_time_) && has_target)
-      {
-        // for steering motors
-        if( i == 1 || i == 3 || i == 5 || i == 7) // ToDo: specify this via the Msg
-        {
-            joint_state_cmd.desired.positions[i] = wStates[j].dAngGearSteerRad;
-            joint_state_cmd.desired.velocities[i] = wStates[j].dVelGearSteerRadS;
-            j = j + 1;
-        }
-        else
-        {
-          joint_state_cmd.desired.positions[i] = 0.0;
-          joint_state_cmd.desired.velocities[i] = wStates[k].dVelGearDriveRadS;
-          k = k + 1;
-        }
-      }
-      else
-      {
-        joint_state_cmd.desired.positions[i] = 0.0;
-        joint_state_cmd.desired.velocities[i] = 0.0;
-      }
+      joint_state_cmd.desired.positions[2*i] = 0.0;
+      joint_state_cmd.desired.velocities[2*i] = wheel_commands_[i].dVelGearDriveRadS;
+      joint_state_cmd.desired.positions[2*i+1] = wheel_commands_[i].dAngGearSteerRad;
+      joint_state_cmd.desired.velocities[2*i+1] = wheel_commands_[i].dVelGearSteerRadS;
+    }
+    else
+    {
+      joint_state_cmd.desired.positions[2*i] = joint_state_cmd.desired.positions[2*i+1] = 0.0;
+      joint_state_cmd.desired.velocities[2*i] = joint_state_cmd.desired.velocities[2*i+1] = 0.0;
     }
-
-    // publish jointcmds
-    topic_pub_controller_joint_command_.publish(joint_state_cmd);
   }
 
+  // publish jointcmds
+  topic_pub_controller_joint_command_->unlockAndPublish();
 }
 
 // calculates odometry from current measurement values
@@ -624,27 +586,29 @@ void NodeClass::UpdateOdometry()
   odom_tracker_->track(joint_state_odom_stamp_, (joint_state_odom_stamp_-last_time_).toSec(), pltState.getVelX(), pltState.getVelY(), pltState.dRotRobRadS);
   last_time_ = joint_state_odom_stamp_;
 
-  nav_msgs::Odometry odom_top = odom_tracker_->getOdometry();
+  const nav_msgs::Odometry &odom_top = odom_tracker_->getOdometry();
 
-  if (broadcast_tf_ == true)
+  if (tf_pub_odometry_ && tf_pub_odometry_->trylock())
   {
     // compose and publish transform for tf package
-    geometry_msgs::TransformStamped odom_tf;
+    geometry_msgs::TransformStamped &odom_tf = tf_pub_odometry_->msg_.transforms[0];
     // compose header
     odom_tf.header.stamp = odom_top.header.stamp;
-    odom_tf.header.frame_id = "/odom_combined";
-    odom_tf.child_frame_id = "/base_footprint";
     // compose data container
     odom_tf.transform.translation.x = odom_top.pose.pose.position.x;
     odom_tf.transform.translation.y = odom_top.pose.pose.position.y;
     odom_tf.transform.rotation = odom_top.pose.pose.orientation;
 
     // publish the transform (for debugging, conflicts with robot-pose-ekf)
-    tf_broadcast_odometry_.sendTransform(odom_tf);
+    tf_pub_odometry_->unlockAndPublish();
   }
 
   // publish odometry msg
-  topic_pub_odometry_.publish(odom_top);
+  if (topic_pub_odometry_->trylock())
+  {
+    topic_pub_odometry_->msg_ = odom_top;
+    topic_pub_odometry_->unlockAndPublish();
+  }
 }
 
 // set EM Flag and stop ctrlr if active
@@ -652,26 +616,15 @@ void NodeClass::setEMStopActive(bool bEMStopActive)
 {
     m_bEMStopActive = bEMStopActive;
 
-    std::vector<WheelState> wStates;
-    wStates.assign(m_iNumWheels, WheelState());
-
-    std::vector<WheelCommand> wCommands;
-    wCommands.assign(m_iNumWheels, WheelCommand());
-    
     // if emergency stop reset ctrlr to zero
     if(m_bEMStopActive)
     {
-//        std::cout << "EMStop: " << "Active" << std::endl;
         has_target = false;
         // reset and update current wheel states but keep current dAngGearSteerRad per wheelState
-        ucar_ctrl_->calcControlStep(wCommands, sample_time_, true);
+        ucar_ctrl_->calcControlStep(wheel_commands_, sample_time_, true);
 
         // set current wheel states with previous reset and updated wheelStates
-        ucar_ctrl_->updateWheelStates(wStates);
+        wheel_states_.assign(m_iNumWheels, WheelState());
+        ucar_ctrl_->updateWheelStates(wheel_states_);
     }
-//    else
-//        std::cout << "EMStop: " << "Inactive" << std::endl;
 }
-
-
-